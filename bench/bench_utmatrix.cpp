@@ -0,0 +1,455 @@
+﻿#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "utmatrix.h"
+
+// Бенчмарк умножения матриц: блочный GEMM против классического цикла i-j-k
+// и масштабирование GEMM и поэлементных операций по числу потоков,
+// упакованные треугольные матрицы против плотных,
+// разложение Холецкого против LU на одной и той же SPD-матрице,
+// QR-разложение высокой узкой матрицы: блочное Хаусхолдера против TSQR,
+// алгоритм Штрассена–Винограда против классического GEMM: время и погрешность,
+// текстовый ввод-вывод против двоичного формата и отображения файла в память,
+// скорость разбора и записи текста против поэлементных operator>> и operator<<,
+// плиточные произведения вне ядра: время и объём чтения по размеру плитки и кэша,
+// GEMV и транспонированный GEMV против цикла с одним аккумулятором, в ГБ/с,
+// транспонирование: рекурсивное, на месте и наивный цикл, в ГБ/с.
+// Запуск: bench_utmatrix [n1 n2 ...]
+
+using Clock = std::chrono::steady_clock;
+
+template<typename T>
+void fillRandom(TDynamicMatrix<T>& m, unsigned seed)
+{
+    srand(seed);
+    for (size_t i = 0; i < m.rows(); i++)
+        for (size_t j = 0; j < m.cols(); j++)
+            m[i][j] = T(rand() % 100) / T(10);
+}
+
+// Классическое умножение, которое было в utmatrix.h до блочного GEMM
+template<typename T>
+void naiveMultiply(const TDynamicMatrix<T>& a, const TDynamicMatrix<T>& b, TDynamicMatrix<T>& c)
+{
+    for (size_t i = 0; i < a.rows(); i++)
+        for (size_t j = 0; j < b.cols(); j++) {
+            T sum = T();
+            for (size_t k = 0; k < a.cols(); k++)
+                sum += a[i][k] * b[k][j];
+            c[i][j] = sum;
+        }
+}
+
+template<typename F>
+double bestSeconds(F&& f, int reps)
+{
+    double best = 1e300;
+    for (int r = 0; r < reps; r++) {
+        auto t0 = Clock::now();
+        f();
+        double s = std::chrono::duration<double>(Clock::now() - t0).count();
+        best = std::min(best, s);
+    }
+    return best;
+}
+
+template<typename T>
+void benchGemm(const char* type, size_t n)
+{
+    TDynamicMatrix<T> a(n, n), b(n, n), c(n, n), ref(n, n);
+    fillRandom(a, 1);
+    fillRandom(b, 2);
+
+    const double flops = 2.0 * n * n * n;
+    const int reps = n <= 256 ? 5 : 1;
+    double tFast = bestSeconds([&] { c = a * b; }, reps);
+    double tNaive = bestSeconds([&] { naiveMultiply(a, b, ref); }, reps);
+
+    double maxErr = 0;
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < n; j++)
+            maxErr = std::max(maxErr, double(std::abs(c[i][j] - ref[i][j])));
+
+    cout << "gemm<" << type << "> n=" << n
+         << "  blocked " << flops / tFast * 1e-9 << " GFLOP/s"
+         << "  naive " << flops / tNaive * 1e-9 << " GFLOP/s"
+         << "  speedup x" << tNaive / tFast
+         << "  max|err| " << maxErr << endl;
+}
+
+// Время при 1..N потоках пула, N — число потоков по умолчанию
+template<typename T>
+void benchScaling(const char* type, size_t n)
+{
+    TDynamicMatrix<T> a(n, n), b(n, n), c(n, n);
+    TDynamicVector<T> x(n), y(n);
+    fillRandom(a, 1);
+    fillRandom(b, 2);
+    for (size_t i = 0; i < n; i++) x[i] = T(i % 10);
+
+    TThreadPool& pool = TThreadPool::instance();
+    const size_t maxThreads = pool.threadCount();
+    double tGemm1 = 0, tAdd1 = 0, tGemv1 = 0;
+    for (size_t t = 1; t <= maxThreads; t++) {
+        pool.setThreadCount(t);
+        double tGemm = bestSeconds([&] { c = a * b; }, 3);
+        double tAdd = bestSeconds([&] { c = a + b * T(2); }, 5);
+        double tGemv = bestSeconds([&] { y = a * x; }, 5);
+        if (t == 1) {
+            tGemm1 = tGemm;
+            tAdd1 = tAdd;
+            tGemv1 = tGemv;
+        }
+        cout << "threads=" << t << " " << type << " n=" << n
+             << "  gemm " << 2.0 * n * n * n / tGemm * 1e-9 << " GFLOP/s x" << tGemm1 / tGemm
+             << "  add " << tAdd * 1e3 << " ms x" << tAdd1 / tAdd
+             << "  gemv " << tGemv * 1e3 << " ms x" << tGemv1 / tGemv << endl;
+    }
+    pool.setThreadCount(maxThreads);
+}
+
+template<typename T>
+void benchTriangular(const char* type, size_t n)
+{
+    TDynamicMatrix<T> d(n, n);
+    fillRandom(d, 3);
+    TUpperTriangularMatrix<T> u(d);
+    TDynamicMatrix<T> ud = u;
+    TDynamicVector<T> x(n), y(n);
+    for (size_t i = 0; i < n; i++) x[i] = T(i % 10);
+
+    const int reps = n <= 256 ? 5 : 1;
+    double tTri = bestSeconds([&] { TUpperTriangularMatrix<T> r = u * u; }, reps);
+    double tDense = bestSeconds([&] { TDynamicMatrix<T> r = ud * ud; }, reps);
+    double tTriMv = bestSeconds([&] { y = u * x; }, 5);
+    double tDenseMv = bestSeconds([&] { y = ud * x; }, 5);
+
+    cout << "triangular<" << type << "> n=" << n
+         << "  memory " << sizeof(T) * n * (n + 1) / 2 / 1024 << " KiB vs " << sizeof(T) * n * n / 1024 << " KiB"
+         << "  u*u " << tTri * 1e3 << " ms (dense " << tDense * 1e3 << " ms)"
+         << "  u*x " << tTriMv * 1e3 << " ms (dense " << tDenseMv * 1e3 << " ms)" << endl;
+}
+
+// Симметричная матрица с диагональным преобладанием положительно определена
+template<typename T>
+void fillSpd(TDynamicMatrix<T>& m, unsigned seed)
+{
+    srand(seed);
+    for (size_t i = 0; i < m.rows(); i++) {
+        for (size_t j = 0; j < i; j++)
+            m[i][j] = m[j][i] = T(rand() % 100) / T(100);
+        m[i][i] = T(m.rows());
+    }
+}
+
+template<typename T>
+void benchFactorizations(const char* type, size_t n)
+{
+    TDynamicMatrix<T> a(n, n);
+    fillSpd(a, 4);
+    TDynamicVector<T> b(n);
+    for (size_t i = 0; i < n; i++) b[i] = T(i % 10);
+
+    const int reps = n <= 256 ? 5 : 1;
+    double tLu = bestSeconds([&] { TLUFactorization<T> lu(a); }, reps);
+    double tChol = bestSeconds([&] { TCholeskyFactorization<T> c(a); }, reps);
+    TLUFactorization<T> lu(a);
+    TCholeskyFactorization<T> chol(a);
+    double tLuSolve = bestSeconds([&] { TDynamicVector<T> x = lu.solve(b); }, 5);
+    double tCholSolve = bestSeconds([&] { TDynamicVector<T> x = chol.solve(b); }, 5);
+
+    TDynamicVector<T> x = chol.solve(b), r = a * x - b;
+    double maxRes = 0;
+    for (size_t i = 0; i < n; i++)
+        maxRes = std::max(maxRes, double(std::abs(r[i])));
+
+    const double luFlops = 2.0 / 3.0 * n * n * n, cholFlops = 1.0 / 3.0 * n * n * n;
+    cout << "factor<" << type << "> n=" << n
+         << "  lu " << tLu * 1e3 << " ms " << luFlops / tLu * 1e-9 << " GFLOP/s"
+         << "  cholesky " << tChol * 1e3 << " ms " << cholFlops / tChol * 1e-9 << " GFLOP/s"
+         << "  speedup x" << tLu / tChol
+         << "  solve " << tLuSolve * 1e3 << " / " << tCholSolve * 1e3 << " ms"
+         << "  max|Ax-b| " << maxRes << endl;
+}
+
+template<typename T>
+void benchTallSkinny(const char* type, size_t m, size_t n)
+{
+    TDynamicMatrix<T> a(m, n);
+    fillRandom(a, 5);
+    TDynamicVector<T> b(m);
+    for (size_t i = 0; i < m; i++) b[i] = T(i % 10);
+
+    double tQr = bestSeconds([&] { TQRFactorization<T> qr(a); }, 3);
+    double tTsqr = bestSeconds([&] { TTallSkinnyQR<T> qr(a); }, 3);
+    TQRFactorization<T> qr(a);
+    TTallSkinnyQR<T> tsqr(a);
+    double tSolve = bestSeconds([&] { TDynamicVector<T> x = qr.solve(b); }, 3);
+    double tTsSolve = bestSeconds([&] { TDynamicVector<T> x = tsqr.solve(b); }, 3);
+
+    // Невязка задачи наименьших квадратов ортогональна столбцам A
+    TDynamicVector<T> r = a * tsqr.solve(b) - b;
+    double maxOrth = 0;
+    for (size_t j = 0; j < n; j++) {
+        double s = 0;
+        for (size_t i = 0; i < m; i++)
+            s += double(a[i][j]) * double(r[i]);
+        maxOrth = std::max(maxOrth, std::abs(s));
+    }
+
+    const double flops = 2.0 * m * n * n - 2.0 / 3.0 * n * n * n;
+    cout << "qr<" << type << "> " << m << "x" << n
+         << "  householder " << tQr * 1e3 << " ms " << flops / tQr * 1e-9 << " GFLOP/s"
+         << "  tsqr(" << tsqr.leafCount() << " blocks) " << tTsqr * 1e3 << " ms " << flops / tTsqr * 1e-9 << " GFLOP/s"
+         << "  lstsq " << tSolve * 1e3 << " / " << tTsSolve * 1e3 << " ms"
+         << "  max|A^T r| " << maxOrth << endl;
+}
+
+// Погрешность обоих алгоритмов считается относительно произведения в double
+template<typename T>
+void benchStrassen(const char* type, size_t n)
+{
+    TDynamicMatrix<T> a(n, n), b(n, n), c(n, n), s(n, n);
+    fillRandom(a, 6);
+    fillRandom(b, 7);
+    TDynamicMatrix<double> ad(n, n), bd(n, n);
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < n; j++) {
+            ad[i][j] = double(a[i][j]);
+            bd[i][j] = double(b[i][j]);
+        }
+    const TDynamicMatrix<double> ref = ad * bd;
+    double refMax = 0;
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < n; j++)
+            refMax = std::max(refMax, std::abs(ref[i][j]));
+    auto relErr = [&](const TDynamicMatrix<T>& m) {
+        double e = 0;
+        for (size_t i = 0; i < n; i++)
+            for (size_t j = 0; j < n; j++)
+                e = std::max(e, std::abs(double(m[i][j]) - ref[i][j]));
+        return e / refMax;
+    };
+
+    const double flops = 2.0 * n * n * n;
+    const int reps = n <= 512 ? 3 : 1;
+    double tClassic = bestSeconds([&] { c = a * b; }, reps);
+    cout << "strassen<" << type << "> n=" << n
+         << "  classical " << tClassic * 1e3 << " ms " << flops / tClassic * 1e-9 << " GFLOP/s"
+         << " err " << relErr(c) << endl;
+    for (size_t cutoff : { 128, 256, 512 }) {
+        if (cutoff >= n) break;
+        double tStrassen = bestSeconds([&] {
+            gemmStrassen(n, n, n, a.data(), a.stride(), b.data(), b.stride(), s.data(), s.stride(), cutoff);
+        }, reps);
+        cout << "    cutoff=" << cutoff
+             << "  " << tStrassen * 1e3 << " ms " << flops / tStrassen * 1e-9 << " effective GFLOP/s"
+             << "  speedup x" << tClassic / tStrassen
+             << "  err " << relErr(s) << endl;
+    }
+}
+
+template<typename T>
+void benchBinaryIo(const char* type, size_t n)
+{
+    TDynamicMatrix<T> a(n, n), b(n, n);
+    fillRandom(a, 8);
+    const string textPath = "bench_utmatrix.txt", binPath = "bench_utmatrix.bin";
+
+    double tTextWrite = bestSeconds([&] { ofstream f(textPath); f << a; }, 1);
+    double tTextRead = bestSeconds([&] { ifstream f(textPath); f >> b; }, 1);
+    double tBinWrite = bestSeconds([&] { saveBinary(binPath, a); }, 3);
+    double tBinRead = bestSeconds([&] { b = loadBinary<T>(binPath); }, 3);
+    // Отображение не читает данные: время открытия и время первого прохода по элементам
+    double tMap = bestSeconds([&] { TMappedMatrix<T> m(binPath); }, 3);
+    T sink = T();
+    double tMapScan = bestSeconds([&] {
+        TMappedMatrix<T> m(binPath);
+        for (size_t i = 0; i < n; i++)
+            for (size_t j = 0; j < n; j++)
+                sink += m(i, j);
+    }, 3);
+
+    ifstream textFile(textPath, ios::binary | ios::ate), binFile(binPath, ios::binary | ios::ate);
+    const double mb = 1.0 / (1024 * 1024);
+    cout << "io<" << type << "> n=" << n
+         << "  text " << double(textFile.tellg()) * mb << " MiB write " << tTextWrite * 1e3 << " ms read " << tTextRead * 1e3 << " ms"
+         << "  binary " << double(binFile.tellg()) * mb << " MiB write " << tBinWrite * 1e3 << " ms read " << tBinRead * 1e3 << " ms"
+         << "  mmap open " << tMap * 1e3 << " ms open+scan " << tMapScan * 1e3 << " ms"
+         << (sink == T(-1) ? " " : "") << endl;
+    textFile.close();
+    binFile.close();
+    std::remove(textPath.c_str());
+    std::remove(binPath.c_str());
+}
+
+template<typename T>
+void benchTextParse(const char* type, size_t n)
+{
+    TDynamicVector<T> v(n), u(n);
+    for (size_t i = 0; i < n; i++) v[i] = T(std::sin(double(i)) * 1e3);
+    std::ostringstream os;
+    os << setprecision(17);
+    double tWrite = bestSeconds([&] { os.str(""); os << v; }, 3);
+    const std::string text = os.str();
+    double tWriteOld = bestSeconds([&] {
+        std::ostringstream o;
+        o << setprecision(17);
+        for (size_t i = 0; i < n; i++) o << v[i] << ' ';
+    }, 1);
+    double tRead = bestSeconds([&] { std::istringstream is(text); is >> u; }, 3);
+    double tReadOld = bestSeconds([&] {
+        std::istringstream is(text);
+        for (size_t i = 0; i < n; i++) is >> u[i];
+    }, 1);
+    const double mb = double(text.size()) / (1024 * 1024);
+    cout << "text<" << type << "> " << n << " values " << mb << " MiB"
+         << "  read " << mb / tRead << " MiB/s (operator>> per element " << mb / tReadOld << " MiB/s)"
+         << "  write " << mb / tWrite << " MiB/s (per element " << mb / tWriteOld << " MiB/s)" << endl;
+}
+
+template<typename T>
+void benchTiled(const char* type, size_t n)
+{
+    TDynamicMatrix<T> a(n, n), b(n, n);
+    fillRandom(a, 9);
+    fillRandom(b, 10);
+    TDynamicVector<T> x(n, T(1));
+    const double tDense = bestSeconds([&] { TDynamicMatrix<T> c = a * b; }, 1);
+    const double mb = 1.0 / (1024 * 1024);
+    for (size_t tile : { size_t(128), size_t(256) }) {
+        const size_t grid = (n + tile - 1) / tile;
+        for (size_t cache : { size_t(3), grid + 1, grid * grid }) {
+            if (cache < 3) continue;
+            TTiledMatrix<T> ta(a, tile, cache), tb(b, tile, cache);
+            ta.clearCache(); // операнды читаются из файла
+            tb.clearCache();
+            ta.resetStats();
+            tb.resetStats();
+            auto t0 = Clock::now();
+            TTiledMatrix<T> tc = ta * tb;
+            tc.flush();
+            const double tProduct = std::chrono::duration<double>(Clock::now() - t0).count();
+            const double readMb = double(ta.stats().bytesRead + tb.stats().bytesRead) * mb;
+            const double writeMb = double(tc.stats().bytesWritten) * mb;
+            ta.clearCache();
+            ta.resetStats();
+            const double tGemv = bestSeconds([&] { TDynamicVector<T> y = ta * x; }, 1);
+            cout << "tiled<" << type << "> n=" << n << " tile=" << tile << " cache=" << cache
+                 << "  product " << tProduct * 1e3 << " ms (in memory " << tDense * 1e3 << " ms)"
+                 << " read " << readMb << " MiB (operands " << 2.0 * double(n * n * sizeof(T)) * mb << " MiB)"
+                 << " written " << writeMb << " MiB"
+                 << "  gemv " << tGemv * 1e3 << " ms read " << double(ta.stats().bytesRead) * mb << " MiB" << endl;
+        }
+    }
+}
+
+template<typename T>
+void benchGemv(const char* type, size_t m, size_t n)
+{
+    TDynamicMatrix<T> a(m, n);
+    fillRandom(a, 11);
+    TDynamicVector<T> x(n, T(1)), z(m, T(1)), y(m), w(n);
+    // Прежняя реализация: один последовательный аккумулятор на строку
+    double tNaive = bestSeconds([&] {
+        for (size_t i = 0; i < m; i++) {
+            const T* row = a.data() + i * n;
+            T sum = T();
+            for (size_t j = 0; j < n; j++)
+                sum += row[j] * x[j];
+            y[i] = sum;
+        }
+    }, 3);
+    double tGemv = bestSeconds([&] { gemv(m, n, a.data(), n, x.data(), y.data()); }, 5);
+    double tGemvT = bestSeconds([&] { gemvTransposed(m, n, a.data(), n, z.data(), w.data()); }, 5);
+    const double gb = double(m) * double(n) * sizeof(T) * 1e-9;
+    cout << "gemv<" << type << "> " << m << "x" << n
+         << "  naive " << gb / tNaive << " GB/s"
+         << "  gemv " << gb / tGemv << " GB/s (x" << tNaive / tGemv << ")"
+         << "  transposed " << gb / tGemvT << " GB/s" << endl;
+}
+
+template<typename T>
+void benchTranspose(const char* type, size_t m, size_t n)
+{
+    TDynamicMatrix<T> a(m, n), b(n, m);
+    fillRandom(a, 13);
+    double tNaive = bestSeconds([&] {
+        for (size_t i = 0; i < m; i++)
+            for (size_t j = 0; j < n; j++)
+                b(j, i) = a(i, j);
+    }, 3);
+    double tRec = bestSeconds([&] { transpose(m, n, a.data(), n, b.data(), m); }, 5);
+    double tInPlace = bestSeconds([&] { a.transpose(); }, 5);
+    // Чтение и запись каждого элемента
+    const double gb = 2.0 * double(m) * double(n) * sizeof(T) * 1e-9;
+    cout << "transpose<" << type << "> " << m << "x" << n
+         << "  naive " << gb / tNaive << " GB/s"
+         << "  recursive " << gb / tRec << " GB/s (x" << tNaive / tRec << ")"
+         << "  in place " << gb / tInPlace << " GB/s" << endl;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; i++)
+        sizes.push_back(strtoul(argv[i], nullptr, 10));
+    if (sizes.empty())
+        sizes = { 64, 256, 512, 1024 };
+
+    for (size_t n : sizes) {
+        benchGemm<double>("double", n);
+        benchGemm<float>("float", n);
+    }
+    for (size_t n : sizes) {
+        benchScaling<double>("double", n);
+        benchScaling<float>("float", n);
+    }
+    for (size_t n : sizes) {
+        benchTriangular<double>("double", n);
+        benchTriangular<float>("float", n);
+    }
+    for (size_t n : sizes) {
+        benchFactorizations<double>("double", n);
+        benchFactorizations<float>("float", n);
+    }
+    for (size_t n : sizes) {
+        benchStrassen<double>("double", n);
+        benchStrassen<float>("float", n);
+    }
+    for (size_t n : sizes) {
+        benchBinaryIo<double>("double", n);
+        benchBinaryIo<float>("float", n);
+    }
+    for (size_t n : sizes) {
+        benchGemv<double>("double", n, n);
+        benchGemv<float>("float", n, n);
+    }
+    benchGemv<double>("double", MAX_MATRIX_SIZE, MAX_MATRIX_SIZE);
+    benchGemv<float>("float", MAX_MATRIX_SIZE, MAX_MATRIX_SIZE);
+    for (size_t n : sizes) {
+        benchTranspose<double>("double", n, n);
+        benchTranspose<float>("float", n, n);
+    }
+    benchTranspose<double>("double", 8192, 8192);
+    benchTranspose<float>("float", 8192, 8192);
+    benchTranspose<double>("double", 3000, 5000);
+    for (size_t n : sizes)
+        if (n >= 256)
+            benchTiled<double>("double", n);
+    benchTextParse<double>("double", 10000000);
+    benchTextParse<float>("float", 10000000);
+    benchTextParse<int>("int", 10000000);
+    for (size_t n : { 16, 50, 200 }) {
+        benchTallSkinny<double>("double", MAX_MATRIX_SIZE, n);
+        benchTallSkinny<float>("float", MAX_MATRIX_SIZE, n);
+    }
+    return 0;
+}
@@ -4,278 +4,5288 @@
 #include <iostream>
 #include <stdexcept>
 #include <algorithm>
+#include <memory>
+#include <new>
 #include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include <cstdint>
+#include <limits>
+#include <atomic>
+#include <cstdlib>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <fstream>
+#include <charconv>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
-const int MAX_VECTOR_SIZE = 100000000;
-const int MAX_MATRIX_SIZE = 10000;
+// Ограничения размеров по умолчанию: число элементов вектора (и матрицы целиком)
+// и число строк и столбцов матрицы. Переопределяются при компиляции макросами
+// UTMATRIX_MAX_VECTOR_SIZE и UTMATRIX_MAX_MATRIX_SIZE или во время выполнения
+// через sizeLimits().
+#ifndef UTMATRIX_MAX_VECTOR_SIZE
+#define UTMATRIX_MAX_VECTOR_SIZE 100000000
+#endif
+#ifndef UTMATRIX_MAX_MATRIX_SIZE
+#define UTMATRIX_MAX_MATRIX_SIZE 10000
+#endif
+
+const size_t MAX_VECTOR_SIZE = UTMATRIX_MAX_VECTOR_SIZE;
+const size_t MAX_MATRIX_SIZE = UTMATRIX_MAX_MATRIX_SIZE;
+
+// Выравнивание буферов (размер строки кэша, достаточно для AVX-512)
+const size_t MEM_ALIGNMENT = 64;
+
+// Уровни набора SIMD-инструкций, выбираемые во время выполнения по CPUID
+enum class TSimdLevel { Scalar = 0, SSE2 = 1, AVX2 = 2, AVX512 = 3 };
+
+// Таблица ядер поэлементных операций над непрерывными массивами
+template<typename T>
+struct TSimdKernels
+{
+    void (*add)(const T* a, const T* b, T* res, size_t n);
+    void (*sub)(const T* a, const T* b, T* res, size_t n);
+    void (*addScalar)(const T* a, T val, T* res, size_t n);
+    void (*subScalar)(const T* a, T val, T* res, size_t n);
+    void (*mulScalar)(const T* a, T val, T* res, size_t n);
+    T (*dot)(const T* a, const T* b, size_t n);
+    void (*axpy)(T alpha, const T* x, T* y, size_t n); // y += alpha * x
+    // Четыре строки с шагом lda: res[r] = (a[r], x) и y += сумма alpha[r] * a[r]
+    void (*dotRows4)(const T* a, size_t lda, const T* x, T* res, size_t n);
+    void (*axpyRows4)(const T* alpha, const T* a, size_t lda, T* y, size_t n);
+};
+
+namespace utmatrix_detail {
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define UTMATRIX_X86
+#endif
+
+#if defined(UTMATRIX_X86) && (defined(__GNUC__) || defined(__clang__))
+#define UTMATRIX_TARGET(isa) __attribute__((target(isa)))
+#else
+#define UTMATRIX_TARGET(isa)
+#endif
+
+inline TSimdLevel detectSimdLevel() noexcept
+{
+#ifdef UTMATRIX_X86
+    unsigned r1[4] = {}, r7[4] = {};
+#ifdef _MSC_VER
+    int regs[4];
+    __cpuid(regs, 0);
+    const unsigned maxLeaf = unsigned(regs[0]);
+    __cpuid(regs, 1);
+    std::copy(regs, regs + 4, r1);
+    if (maxLeaf >= 7) {
+        __cpuidex(regs, 7, 0);
+        std::copy(regs, regs + 4, r7);
+    }
+#else
+    const unsigned maxLeaf = __get_cpuid_max(0, nullptr);
+    __get_cpuid(1, &r1[0], &r1[1], &r1[2], &r1[3]);
+    if (maxLeaf >= 7)
+        __cpuid_count(7, 0, r7[0], r7[1], r7[2], r7[3]);
+#endif
+    if (!(r1[3] & (1u << 26))) return TSimdLevel::Scalar;
+    // AVX требует, чтобы ОС сохраняла регистры YMM/ZMM (OSXSAVE + XCR0)
+    if (!(r1[2] & (1u << 27)) || !(r1[2] & (1u << 28))) return TSimdLevel::SSE2;
+#ifdef _MSC_VER
+    const unsigned long long xcr0 = _xgetbv(0);
+#else
+    unsigned xlo, xhi;
+    __asm__ volatile("xgetbv" : "=a"(xlo), "=d"(xhi) : "c"(0));
+    const unsigned long long xcr0 = (static_cast<unsigned long long>(xhi) << 32) | xlo;
+#endif
+    if ((xcr0 & 0x6) != 0x6 || !(r7[1] & (1u << 5))) return TSimdLevel::SSE2;
+    if ((xcr0 & 0xE6) == 0xE6 && (r7[1] & (1u << 16))) return TSimdLevel::AVX512;
+    return TSimdLevel::AVX2;
+#else
+    return TSimdLevel::Scalar;
+#endif
+}
+
+// Скалярные ядра: запасной путь и обработка хвостов
+template<typename T>
+struct TScalarKernels
+{
+    static void add(const T* a, const T* b, T* res, size_t n) { for (size_t i = 0; i < n; i++) res[i] = a[i] + b[i]; }
+    static void sub(const T* a, const T* b, T* res, size_t n) { for (size_t i = 0; i < n; i++) res[i] = a[i] - b[i]; }
+    static void addScalar(const T* a, T val, T* res, size_t n) { for (size_t i = 0; i < n; i++) res[i] = a[i] + val; }
+    static void subScalar(const T* a, T val, T* res, size_t n) { for (size_t i = 0; i < n; i++) res[i] = a[i] - val; }
+    static void mulScalar(const T* a, T val, T* res, size_t n) { for (size_t i = 0; i < n; i++) res[i] = a[i] * val; }
+    static T dot(const T* a, const T* b, size_t n)
+    {
+        T res = T();
+        for (size_t i = 0; i < n; i++) res += a[i] * b[i];
+        return res;
+    }
+    static void axpy(T alpha, const T* x, T* y, size_t n) { for (size_t i = 0; i < n; i++) y[i] += alpha * x[i]; }
+    static void dotRows4(const T* a, size_t lda, const T* x, T* res, size_t n)
+    {
+        T s0 = T(), s1 = T(), s2 = T(), s3 = T();
+        for (size_t i = 0; i < n; i++) {
+            s0 += a[i] * x[i];
+            s1 += a[lda + i] * x[i];
+            s2 += a[2 * lda + i] * x[i];
+            s3 += a[3 * lda + i] * x[i];
+        }
+        res[0] = s0; res[1] = s1; res[2] = s2; res[3] = s3;
+    }
+    static void axpyRows4(const T* alpha, const T* a, size_t lda, T* y, size_t n)
+    {
+        for (size_t i = 0; i < n; i++)
+            y[i] += alpha[0] * a[i] + alpha[1] * a[lda + i] + alpha[2] * a[2 * lda + i] + alpha[3] * a[3 * lda + i];
+    }
+};
+
+#ifdef UTMATRIX_X86
+
+// Обёртки над регистрами: для каждого набора инструкций и типа элемента
+// задаются ширина, загрузка/сохранение и арифметика. Умножение 64-битных
+// целых собирается из 32-битных произведений (mullo_epi64 есть только в AVX-512DQ).
+#define UTMATRIX_SIMD_INT64_MUL(pre) \
+    reg ahi = pre##_srli_epi64(a, 32), bhi = pre##_srli_epi64(b, 32); \
+    reg mid = pre##_add_epi64(pre##_mul_epu32(a, bhi), pre##_mul_epu32(ahi, b)); \
+    return pre##_add_epi64(pre##_mul_epu32(a, b), pre##_slli_epi64(mid, 32));
+
+struct TSse2F64 {
+    typedef double T; typedef __m128d reg; static const size_t width = 2;
+    UTMATRIX_TARGET("sse2") static reg load(const T* p) { return _mm_loadu_pd(p); }
+    UTMATRIX_TARGET("sse2") static void store(T* p, reg v) { _mm_storeu_pd(p, v); }
+    UTMATRIX_TARGET("sse2") static reg set1(T v) { return _mm_set1_pd(v); }
+    UTMATRIX_TARGET("sse2") static reg add(reg a, reg b) { return _mm_add_pd(a, b); }
+    UTMATRIX_TARGET("sse2") static reg sub(reg a, reg b) { return _mm_sub_pd(a, b); }
+    UTMATRIX_TARGET("sse2") static reg mul(reg a, reg b) { return _mm_mul_pd(a, b); }
+};
+struct TSse2F32 {
+    typedef float T; typedef __m128 reg; static const size_t width = 4;
+    UTMATRIX_TARGET("sse2") static reg load(const T* p) { return _mm_loadu_ps(p); }
+    UTMATRIX_TARGET("sse2") static void store(T* p, reg v) { _mm_storeu_ps(p, v); }
+    UTMATRIX_TARGET("sse2") static reg set1(T v) { return _mm_set1_ps(v); }
+    UTMATRIX_TARGET("sse2") static reg add(reg a, reg b) { return _mm_add_ps(a, b); }
+    UTMATRIX_TARGET("sse2") static reg sub(reg a, reg b) { return _mm_sub_ps(a, b); }
+    UTMATRIX_TARGET("sse2") static reg mul(reg a, reg b) { return _mm_mul_ps(a, b); }
+};
+struct TSse2I32 {
+    typedef int32_t T; typedef __m128i reg; static const size_t width = 4;
+    UTMATRIX_TARGET("sse2") static reg load(const T* p) { return _mm_loadu_si128(reinterpret_cast<const reg*>(p)); }
+    UTMATRIX_TARGET("sse2") static void store(T* p, reg v) { _mm_storeu_si128(reinterpret_cast<reg*>(p), v); }
+    UTMATRIX_TARGET("sse2") static reg set1(T v) { return _mm_set1_epi32(v); }
+    UTMATRIX_TARGET("sse2") static reg add(reg a, reg b) { return _mm_add_epi32(a, b); }
+    UTMATRIX_TARGET("sse2") static reg sub(reg a, reg b) { return _mm_sub_epi32(a, b); }
+    UTMATRIX_TARGET("sse2") static reg mul(reg a, reg b)
+    {
+        // в SSE2 нет mullo_epi32: перемножаем чётные и нечётные элементы отдельно
+        reg even = _mm_mul_epu32(a, b);
+        reg odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+        return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                                  _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+    }
+};
+struct TSse2I64 {
+    typedef int64_t T; typedef __m128i reg; static const size_t width = 2;
+    UTMATRIX_TARGET("sse2") static reg load(const T* p) { return _mm_loadu_si128(reinterpret_cast<const reg*>(p)); }
+    UTMATRIX_TARGET("sse2") static void store(T* p, reg v) { _mm_storeu_si128(reinterpret_cast<reg*>(p), v); }
+    UTMATRIX_TARGET("sse2") static reg set1(T v) { return _mm_set1_epi64x(v); }
+    UTMATRIX_TARGET("sse2") static reg add(reg a, reg b) { return _mm_add_epi64(a, b); }
+    UTMATRIX_TARGET("sse2") static reg sub(reg a, reg b) { return _mm_sub_epi64(a, b); }
+    UTMATRIX_TARGET("sse2") static reg mul(reg a, reg b) { UTMATRIX_SIMD_INT64_MUL(_mm) }
+};
+
+struct TAvx2F64 {
+    typedef double T; typedef __m256d reg; static const size_t width = 4;
+    UTMATRIX_TARGET("avx2") static reg load(const T* p) { return _mm256_loadu_pd(p); }
+    UTMATRIX_TARGET("avx2") static void store(T* p, reg v) { _mm256_storeu_pd(p, v); }
+    UTMATRIX_TARGET("avx2") static reg set1(T v) { return _mm256_set1_pd(v); }
+    UTMATRIX_TARGET("avx2") static reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+    UTMATRIX_TARGET("avx2") static reg sub(reg a, reg b) { return _mm256_sub_pd(a, b); }
+    UTMATRIX_TARGET("avx2") static reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+};
+struct TAvx2F32 {
+    typedef float T; typedef __m256 reg; static const size_t width = 8;
+    UTMATRIX_TARGET("avx2") static reg load(const T* p) { return _mm256_loadu_ps(p); }
+    UTMATRIX_TARGET("avx2") static void store(T* p, reg v) { _mm256_storeu_ps(p, v); }
+    UTMATRIX_TARGET("avx2") static reg set1(T v) { return _mm256_set1_ps(v); }
+    UTMATRIX_TARGET("avx2") static reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+    UTMATRIX_TARGET("avx2") static reg sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+    UTMATRIX_TARGET("avx2") static reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+};
+struct TAvx2I32 {
+    typedef int32_t T; typedef __m256i reg; static const size_t width = 8;
+    UTMATRIX_TARGET("avx2") static reg load(const T* p) { return _mm256_loadu_si256(reinterpret_cast<const reg*>(p)); }
+    UTMATRIX_TARGET("avx2") static void store(T* p, reg v) { _mm256_storeu_si256(reinterpret_cast<reg*>(p), v); }
+    UTMATRIX_TARGET("avx2") static reg set1(T v) { return _mm256_set1_epi32(v); }
+    UTMATRIX_TARGET("avx2") static reg add(reg a, reg b) { return _mm256_add_epi32(a, b); }
+    UTMATRIX_TARGET("avx2") static reg sub(reg a, reg b) { return _mm256_sub_epi32(a, b); }
+    UTMATRIX_TARGET("avx2") static reg mul(reg a, reg b) { return _mm256_mullo_epi32(a, b); }
+};
+struct TAvx2I64 {
+    typedef int64_t T; typedef __m256i reg; static const size_t width = 4;
+    UTMATRIX_TARGET("avx2") static reg load(const T* p) { return _mm256_loadu_si256(reinterpret_cast<const reg*>(p)); }
+    UTMATRIX_TARGET("avx2") static void store(T* p, reg v) { _mm256_storeu_si256(reinterpret_cast<reg*>(p), v); }
+    UTMATRIX_TARGET("avx2") static reg set1(T v) { return _mm256_set1_epi64x(v); }
+    UTMATRIX_TARGET("avx2") static reg add(reg a, reg b) { return _mm256_add_epi64(a, b); }
+    UTMATRIX_TARGET("avx2") static reg sub(reg a, reg b) { return _mm256_sub_epi64(a, b); }
+    UTMATRIX_TARGET("avx2") static reg mul(reg a, reg b) { UTMATRIX_SIMD_INT64_MUL(_mm256) }
+};
+
+struct TAvx512F64 {
+    typedef double T; typedef __m512d reg; static const size_t width = 8;
+    UTMATRIX_TARGET("avx512f") static reg load(const T* p) { return _mm512_loadu_pd(p); }
+    UTMATRIX_TARGET("avx512f") static void store(T* p, reg v) { _mm512_storeu_pd(p, v); }
+    UTMATRIX_TARGET("avx512f") static reg set1(T v) { return _mm512_set1_pd(v); }
+    UTMATRIX_TARGET("avx512f") static reg add(reg a, reg b) { return _mm512_add_pd(a, b); }
+    UTMATRIX_TARGET("avx512f") static reg sub(reg a, reg b) { return _mm512_sub_pd(a, b); }
+    UTMATRIX_TARGET("avx512f") static reg mul(reg a, reg b) { return _mm512_mul_pd(a, b); }
+};
+struct TAvx512F32 {
+    typedef float T; typedef __m512 reg; static const size_t width = 16;
+    UTMATRIX_TARGET("avx512f") static reg load(const T* p) { return _mm512_loadu_ps(p); }
+    UTMATRIX_TARGET("avx512f") static void store(T* p, reg v) { _mm512_storeu_ps(p, v); }
+    UTMATRIX_TARGET("avx512f") static reg set1(T v) { return _mm512_set1_ps(v); }
+    UTMATRIX_TARGET("avx512f") static reg add(reg a, reg b) { return _mm512_add_ps(a, b); }
+    UTMATRIX_TARGET("avx512f") static reg sub(reg a, reg b) { return _mm512_sub_ps(a, b); }
+    UTMATRIX_TARGET("avx512f") static reg mul(reg a, reg b) { return _mm512_mul_ps(a, b); }
+};
+struct TAvx512I32 {
+    typedef int32_t T; typedef __m512i reg; static const size_t width = 16;
+    UTMATRIX_TARGET("avx512f") static reg load(const T* p) { return _mm512_loadu_si512(p); }
+    UTMATRIX_TARGET("avx512f") static void store(T* p, reg v) { _mm512_storeu_si512(p, v); }
+    UTMATRIX_TARGET("avx512f") static reg set1(T v) { return _mm512_set1_epi32(v); }
+    UTMATRIX_TARGET("avx512f") static reg add(reg a, reg b) { return _mm512_add_epi32(a, b); }
+    UTMATRIX_TARGET("avx512f") static reg sub(reg a, reg b) { return _mm512_sub_epi32(a, b); }
+    UTMATRIX_TARGET("avx512f") static reg mul(reg a, reg b) { return _mm512_mullo_epi32(a, b); }
+};
+// GCC ложно предупреждает о неинициализированных операндах внутри
+// _mm512_mul_epu32 и _mm512_slli_epi64 после встраивания
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+struct TAvx512I64 {
+    typedef int64_t T; typedef __m512i reg; static const size_t width = 8;
+    UTMATRIX_TARGET("avx512f") static reg load(const T* p) { return _mm512_loadu_si512(p); }
+    UTMATRIX_TARGET("avx512f") static void store(T* p, reg v) { _mm512_storeu_si512(p, v); }
+    UTMATRIX_TARGET("avx512f") static reg set1(T v) { return _mm512_set1_epi64(v); }
+    UTMATRIX_TARGET("avx512f") static reg add(reg a, reg b) { return _mm512_add_epi64(a, b); }
+    UTMATRIX_TARGET("avx512f") static reg sub(reg a, reg b) { return _mm512_sub_epi64(a, b); }
+    UTMATRIX_TARGET("avx512f") static reg mul(reg a, reg b) { UTMATRIX_SIMD_INT64_MUL(_mm512) }
+};
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#undef UTMATRIX_SIMD_INT64_MUL
+
+// Ядра, общие для всех наборов инструкций. Атрибут target должен стоять и на
+// самих ядрах, иначе компилятор не встроит в них обёртки над регистрами.
+#define UTMATRIX_SIMD_KERNELS(name, isa)                                                         \
+template<class V>                                                                                \
+struct name                                                                                      \
+{                                                                                                \
+    typedef typename V::T T;                                                                     \
+    typedef typename V::reg reg;                                                                 \
+    static const size_t W = V::width;                                                            \
+                                                                                                 \
+    UTMATRIX_TARGET(isa) static void add(const T* a, const T* b, T* res, size_t n)               \
+    {                                                                                            \
+        size_t i = 0;                                                                            \
+        for (; i + W <= n; i += W) V::store(res + i, V::add(V::load(a + i), V::load(b + i)));    \
+        TScalarKernels<T>::add(a + i, b + i, res + i, n - i);                                    \
+    }                                                                                            \
+    UTMATRIX_TARGET(isa) static void sub(const T* a, const T* b, T* res, size_t n)               \
+    {                                                                                            \
+        size_t i = 0;                                                                            \
+        for (; i + W <= n; i += W) V::store(res + i, V::sub(V::load(a + i), V::load(b + i)));    \
+        TScalarKernels<T>::sub(a + i, b + i, res + i, n - i);                                    \
+    }                                                                                            \
+    UTMATRIX_TARGET(isa) static void addScalar(const T* a, T val, T* res, size_t n)              \
+    {                                                                                            \
+        const reg v = V::set1(val);                                                              \
+        size_t i = 0;                                                                            \
+        for (; i + W <= n; i += W) V::store(res + i, V::add(V::load(a + i), v));                 \
+        TScalarKernels<T>::addScalar(a + i, val, res + i, n - i);                                \
+    }                                                                                            \
+    UTMATRIX_TARGET(isa) static void subScalar(const T* a, T val, T* res, size_t n)              \
+    {                                                                                            \
+        const reg v = V::set1(val);                                                              \
+        size_t i = 0;                                                                            \
+        for (; i + W <= n; i += W) V::store(res + i, V::sub(V::load(a + i), v));                 \
+        TScalarKernels<T>::subScalar(a + i, val, res + i, n - i);                                \
+    }                                                                                            \
+    UTMATRIX_TARGET(isa) static void mulScalar(const T* a, T val, T* res, size_t n)              \
+    {                                                                                            \
+        const reg v = V::set1(val);                                                              \
+        size_t i = 0;                                                                            \
+        for (; i + W <= n; i += W) V::store(res + i, V::mul(V::load(a + i), v));                 \
+        TScalarKernels<T>::mulScalar(a + i, val, res + i, n - i);                                \
+    }                                                                                            \
+    /* четыре независимых аккумулятора скрывают задержку сложения */                              \
+    UTMATRIX_TARGET(isa) static T dot(const T* a, const T* b, size_t n)                          \
+    {                                                                                            \
+        reg s0 = V::set1(T()), s1 = s0, s2 = s0, s3 = s0;                                        \
+        size_t i = 0;                                                                            \
+        for (; i + 4 * W <= n; i += 4 * W) {                                                     \
+            s0 = V::add(s0, V::mul(V::load(a + i), V::load(b + i)));                             \
+            s1 = V::add(s1, V::mul(V::load(a + i + W), V::load(b + i + W)));                     \
+            s2 = V::add(s2, V::mul(V::load(a + i + 2 * W), V::load(b + i + 2 * W)));             \
+            s3 = V::add(s3, V::mul(V::load(a + i + 3 * W), V::load(b + i + 3 * W)));             \
+        }                                                                                        \
+        for (; i + W <= n; i += W) s0 = V::add(s0, V::mul(V::load(a + i), V::load(b + i)));     \
+        T lanes[W];                                                                              \
+        V::store(lanes, V::add(V::add(s0, s1), V::add(s2, s3)));                                 \
+        T res = TScalarKernels<T>::dot(a + i, b + i, n - i);                                     \
+        for (size_t l = 0; l < W; l++) res += lanes[l];                                          \
+        return res;                                                                              \
+    }                                                                                            \
+    UTMATRIX_TARGET(isa) static void axpy(T alpha, const T* x, T* y, size_t n)                   \
+    {                                                                                            \
+        const reg a = V::set1(alpha);                                                            \
+        size_t i = 0;                                                                            \
+        for (; i + W <= n; i += W) V::store(y + i, V::add(V::load(y + i), V::mul(a, V::load(x + i)))); \
+        TScalarKernels<T>::axpy(alpha, x + i, y + i, n - i);                                     \
+    }                                                                                            \
+    /* x загружается один раз на четыре строки, по два аккумулятора на строку */                 \
+    UTMATRIX_TARGET(isa) static void dotRows4(const T* a, size_t lda, const T* x, T* res, size_t n) \
+    {                                                                                            \
+        const T* r[4] = { a, a + lda, a + 2 * lda, a + 3 * lda };                                \
+        reg s0 = V::set1(T()), s1 = s0, s2 = s0, s3 = s0, t0 = s0, t1 = s0, t2 = s0, t3 = s0;    \
+        size_t i = 0;                                                                            \
+        for (; i + 2 * W <= n; i += 2 * W) {                                                     \
+            const reg x0 = V::load(x + i), x1 = V::load(x + i + W);                              \
+            s0 = V::add(s0, V::mul(V::load(r[0] + i), x0));                                      \
+            s1 = V::add(s1, V::mul(V::load(r[1] + i), x0));                                      \
+            s2 = V::add(s2, V::mul(V::load(r[2] + i), x0));                                      \
+            s3 = V::add(s3, V::mul(V::load(r[3] + i), x0));                                      \
+            t0 = V::add(t0, V::mul(V::load(r[0] + i + W), x1));                                  \
+            t1 = V::add(t1, V::mul(V::load(r[1] + i + W), x1));                                  \
+            t2 = V::add(t2, V::mul(V::load(r[2] + i + W), x1));                                  \
+            t3 = V::add(t3, V::mul(V::load(r[3] + i + W), x1));                                  \
+        }                                                                                        \
+        if (i + W <= n) {                                                                        \
+            const reg x0 = V::load(x + i);                                                       \
+            s0 = V::add(s0, V::mul(V::load(r[0] + i), x0));                                      \
+            s1 = V::add(s1, V::mul(V::load(r[1] + i), x0));                                      \
+            s2 = V::add(s2, V::mul(V::load(r[2] + i), x0));                                      \
+            s3 = V::add(s3, V::mul(V::load(r[3] + i), x0));                                      \
+            i += W;                                                                              \
+        }                                                                                        \
+        T lanes[4][W];                                                                           \
+        V::store(lanes[0], V::add(s0, t0));                                                      \
+        V::store(lanes[1], V::add(s1, t1));                                                      \
+        V::store(lanes[2], V::add(s2, t2));                                                      \
+        V::store(lanes[3], V::add(s3, t3));                                                      \
+        for (size_t q = 0; q < 4; q++) {                                                         \
+            T sum = TScalarKernels<T>::dot(r[q] + i, x + i, n - i);                              \
+            for (size_t l = 0; l < W; l++) sum += lanes[q][l];                                   \
+            res[q] = sum;                                                                        \
+        }                                                                                        \
+    }                                                                                            \
+    /* y читается и пишется один раз на четыре строки */                                         \
+    UTMATRIX_TARGET(isa) static void axpyRows4(const T* alpha, const T* a, size_t lda, T* y, size_t n) \
+    {                                                                                            \
+        const reg c0 = V::set1(alpha[0]), c1 = V::set1(alpha[1]), c2 = V::set1(alpha[2]), c3 = V::set1(alpha[3]); \
+        const T* r1 = a + lda;                                                                   \
+        const T* r2 = a + 2 * lda;                                                               \
+        const T* r3 = a + 3 * lda;                                                               \
+        size_t i = 0;                                                                            \
+        for (; i + W <= n; i += W) {                                                             \
+            const reg p = V::add(V::mul(c0, V::load(a + i)), V::mul(c1, V::load(r1 + i)));       \
+            const reg q = V::add(V::mul(c2, V::load(r2 + i)), V::mul(c3, V::load(r3 + i)));      \
+            V::store(y + i, V::add(V::load(y + i), V::add(p, q)));                               \
+        }                                                                                        \
+        TScalarKernels<T>::axpyRows4(alpha, a + i, lda, y + i, n - i);                           \
+    }                                                                                            \
+};
+
+UTMATRIX_SIMD_KERNELS(TSse2Kernels, "sse2")
+UTMATRIX_SIMD_KERNELS(TAvx2Kernels, "avx2")
+UTMATRIX_SIMD_KERNELS(TAvx512Kernels, "avx512f")
+
+#undef UTMATRIX_SIMD_KERNELS
+
+template<typename T> struct TSimdRegs { typedef void sse2; typedef void avx2; typedef void avx512; };
+template<> struct TSimdRegs<double> { typedef TSse2F64 sse2; typedef TAvx2F64 avx2; typedef TAvx512F64 avx512; };
+template<> struct TSimdRegs<float> { typedef TSse2F32 sse2; typedef TAvx2F32 avx2; typedef TAvx512F32 avx512; };
+template<> struct TSimdRegs<int32_t> { typedef TSse2I32 sse2; typedef TAvx2I32 avx2; typedef TAvx512I32 avx512; };
+template<> struct TSimdRegs<int64_t> { typedef TSse2I64 sse2; typedef TAvx2I64 avx2; typedef TAvx512I64 avx512; };
+
+#endif // UTMATRIX_X86
+
+template<typename T, template<class> class K, class V>
+const TSimdKernels<T>* kernelTable()
+{
+    static const TSimdKernels<T> table = { &K<V>::add, &K<V>::sub, &K<V>::addScalar, &K<V>::subScalar,
+        &K<V>::mulScalar, &K<V>::dot, &K<V>::axpy, &K<V>::dotRows4, &K<V>::axpyRows4 };
+    return &table;
+}
+
+template<typename T>
+const TSimdKernels<T>* scalarKernelTable()
+{
+    static const TSimdKernels<T> table = { &TScalarKernels<T>::add, &TScalarKernels<T>::sub,
+        &TScalarKernels<T>::addScalar, &TScalarKernels<T>::subScalar, &TScalarKernels<T>::mulScalar,
+        &TScalarKernels<T>::dot, &TScalarKernels<T>::axpy, &TScalarKernels<T>::dotRows4, &TScalarKernels<T>::axpyRows4 };
+    return &table;
+}
+
+template<typename T>
+struct TSimdSupported : std::integral_constant<bool,
+    std::is_same<T, double>::value || std::is_same<T, float>::value ||
+    std::is_same<T, int32_t>::value || std::is_same<T, int64_t>::value> {};
+
+} // namespace utmatrix_detail
+
+// Наилучший уровень SIMD, поддерживаемый процессором и ОС (определяется один раз)
+inline TSimdLevel simdLevel() noexcept
+{
+    static const TSimdLevel level = utmatrix_detail::detectSimdLevel();
+    return level;
+}
+
+// Ядра заданного уровня; nullptr, если уровень не поддерживается для типа T
+template<typename T>
+const TSimdKernels<T>* simdKernels(TSimdLevel level)
+{
+    using namespace utmatrix_detail;
+    if constexpr (!TSimdSupported<T>::value) {
+        return nullptr;
+    }
+    else {
+        if (level > simdLevel()) return nullptr;
+        switch (level) {
+#ifdef UTMATRIX_X86
+        case TSimdLevel::AVX512: return kernelTable<T, TAvx512Kernels, typename TSimdRegs<T>::avx512>();
+        case TSimdLevel::AVX2: return kernelTable<T, TAvx2Kernels, typename TSimdRegs<T>::avx2>();
+        case TSimdLevel::SSE2: return kernelTable<T, TSse2Kernels, typename TSimdRegs<T>::sse2>();
+#endif
+        default: return scalarKernelTable<T>();
+        }
+    }
+}
+
+// Ядра для текущего процессора; nullptr для типов без SIMD-реализации
+template<typename T>
+const TSimdKernels<T>* simdKernels()
+{
+    static const TSimdKernels<T>* kernels = simdKernels<T>(simdLevel());
+    return kernels;
+}
+
+// Пул потоков библиотеки. Число потоков (включая вызывающий) по умолчанию равно
+// числу аппаратных потоков; его можно задать переменной окружения
+// UTMATRIX_NUM_THREADS или методом setThreadCount().
+class TThreadPool
+{
+    std::vector<std::thread> workers;
+    std::mutex mtx;
+    std::condition_variable cvWork, cvDone;
+    std::mutex jobMutex;          // одновременно выполняется одно задание
+    bool stopping = false;
+
+    // Текущее задание: диапазон [begin, end) раздаётся кусками по chunk
+    const std::function<void(size_t, size_t)>* job = nullptr;
+    size_t jobEnd = 0, jobChunk = 1;
+    std::atomic<size_t> jobNext{0};
+    unsigned long long generation = 0;
+    size_t busy = 0;
+    std::exception_ptr error;
+
+    static bool& insideWorker() noexcept
+    {
+        static thread_local bool flag = false;
+        return flag;
+    }
+
+    static size_t defaultThreadCount()
+    {
+        if (const char* env = std::getenv("UTMATRIX_NUM_THREADS")) {
+            long n = std::strtol(env, nullptr, 10);
+            if (n > 0) return size_t(n);
+        }
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    void runChunks()
+    {
+        for (;;) {
+            size_t b = jobNext.fetch_add(jobChunk);
+            if (b >= jobEnd) break;
+            try {
+                (*job)(b, std::min(jobEnd, b + jobChunk));
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (!error) error = std::current_exception();
+                jobNext.store(jobEnd); // остальные куски не запускаем
+            }
+        }
+    }
+
+    void workerLoop()
+    {
+        insideWorker() = true;
+        unsigned long long seen = 0;
+        std::unique_lock<std::mutex> lock(mtx);
+        for (;;) {
+            cvWork.wait(lock, [&] { return stopping || (job != nullptr && generation != seen); });
+            if (stopping) return;
+            seen = generation;
+            busy++;
+            lock.unlock();
+            runChunks();
+            lock.lock();
+            if (--busy == 0) cvDone.notify_all();
+        }
+    }
+
+    void start(size_t n)
+    {
+        stopping = false;
+        for (size_t i = 1; i < n; i++)
+            workers.emplace_back([this] { workerLoop(); });
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        cvWork.notify_all();
+        for (auto& w : workers) w.join();
+        workers.clear();
+    }
+
+public:
+    explicit TThreadPool(size_t n = defaultThreadCount()) { start(std::max<size_t>(1, n)); }
+    TThreadPool(const TThreadPool&) = delete;
+    TThreadPool& operator=(const TThreadPool&) = delete;
+    ~TThreadPool() { stop(); }
+
+    static TThreadPool& instance()
+    {
+        static TThreadPool pool;
+        return pool;
+    }
+
+    size_t threadCount() const noexcept { return workers.size() + 1; }
+
+    void setThreadCount(size_t n)
+    {
+        std::lock_guard<std::mutex> jobLock(jobMutex);
+        stop();
+        start(std::max<size_t>(1, n));
+    }
+
+    // Вызывает f(b, e) для непересекающихся поддиапазонов [begin, end) длиной не
+    // меньше grain. Вызывающий поток участвует в работе. Вложенные вызовы и вызовы,
+    // пока пул занят другим заданием, выполняются последовательно.
+    template<typename F>
+    void parallelFor(size_t begin, size_t end, size_t grain, F&& f)
+    {
+        if (begin >= end) return;
+        const size_t n = end - begin;
+        grain = std::max<size_t>(1, grain);
+        if (workers.empty() || n <= grain || insideWorker()) {
+            f(begin, end);
+            return;
+        }
+        std::unique_lock<std::mutex> jobLock(jobMutex, std::try_to_lock);
+        if (!jobLock.owns_lock()) {
+            f(begin, end);
+            return;
+        }
+        // По несколько кусков на поток для балансировки нагрузки
+        const size_t pieces = std::min(n / grain, threadCount() * 4);
+        const std::function<void(size_t, size_t)> fn = [&f](size_t b, size_t e) { f(b, e); };
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            job = &fn;
+            jobEnd = end;
+            jobChunk = (n + pieces - 1) / pieces;
+            jobNext.store(begin);
+            error = nullptr;
+            generation++;
+        }
+        cvWork.notify_all();
+        insideWorker() = true;
+        runChunks();
+        insideWorker() = false;
+        std::exception_ptr err;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cvDone.wait(lock, [&] { return busy == 0; });
+            job = nullptr;
+            err = error;
+        }
+        if (err) std::rethrow_exception(err);
+    }
+};
+
+// Число выделений буферов векторов и матриц с начала работы программы.
+// Позволяет в тестах проверять, что операция не выделяет лишнюю память.
+inline std::atomic<size_t>& allocationCounter() noexcept
+{
+    static std::atomic<size_t> counter(0);
+    return counter;
+}
+
+inline size_t allocationCount() noexcept
+{
+    return allocationCounter().load(std::memory_order_relaxed);
+}
+
+// Распределитель по умолчанию: блоки выровнены по Align байт, поэтому SIMD-ядра
+// работают с выровненными данными и не пересекают границы строк кэша.
+// Вместо него можно подставить любой распределитель с интерфейсом std::allocator
+// (арена, пул, большие страницы, NUMA-локальная память).
+template<typename T, size_t Align = MEM_ALIGNMENT>
+struct TAlignedAllocator
+{
+    static_assert(Align >= alignof(T) && (Align & (Align - 1)) == 0, "Выравнивание должно быть степенью двойки не меньше alignof(T)");
+
+    typedef T value_type;
+    template<typename U> struct rebind { typedef TAlignedAllocator<U, Align> other; };
+
+    TAlignedAllocator() noexcept = default;
+    template<typename U> TAlignedAllocator(const TAlignedAllocator<U, Align>&) noexcept {}
+
+    T* allocate(size_t n)
+    {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T)) throw std::bad_array_new_length();
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Align)));
+    }
+
+    void deallocate(T* p, size_t) noexcept
+    {
+        ::operator delete(p, std::align_val_t(Align));
+    }
+
+    template<typename U> bool operator==(const TAlignedAllocator<U, Align>&) const noexcept { return true; }
+    template<typename U> bool operator!=(const TAlignedAllocator<U, Align>&) const noexcept { return false; }
+};
+
+// Действующие ограничения размеров, проверяемые конструкторами. Для задач больше
+// ограничений по умолчанию их поднимают до создания объектов; размеры, произведение
+// которых не помещается в size_t, отвергаются при любых ограничениях.
+struct TSizeLimits
+{
+    size_t maxVectorSize = MAX_VECTOR_SIZE; // элементов в векторе или матрице
+    size_t maxMatrixSize = MAX_MATRIX_SIZE; // строк и столбцов плотной или треугольной матрицы
+};
+
+inline TSizeLimits& sizeLimits() noexcept
+{
+    static TSizeLimits limits;
+    return limits;
+}
+
+namespace utmatrix_detail {
+
+// a * b с проверкой переполнения size_t
+inline size_t checkedMul(size_t a, size_t b)
+{
+    if (b != 0 && a > std::numeric_limits<size_t>::max() / b)
+        throw overflow_error("Размер не помещается в size_t");
+    return a * b;
+}
+
+// a * b mod md без переполнения: напрямую, если произведение помещается
+// в 64 бита, иначе сложениями со сдвигом
+inline unsigned long long mulMod(unsigned long long a, unsigned long long b, unsigned long long md) noexcept
+{
+    a %= md;
+    b %= md;
+    if (b == 0 || a <= std::numeric_limits<unsigned long long>::max() / b) return a * b % md;
+    unsigned long long r = 0;
+    for (; b != 0; b >>= 1) {
+        if (b & 1) r = (r >= md - a) ? r - (md - a) : r + a;
+        a = (a >= md - a) ? a - (md - a) : a + a;
+    }
+    return r;
+}
+
+} // namespace utmatrix_detail
+
+// Метка конструкторов, оставляющих элементы тривиальных типов неинициализированными
+struct TUninitializedTag {};
+constexpr TUninitializedTag uninitialized{};
+
+template<typename T, typename Alloc = TAlignedAllocator<T>> class TDynamicVector;
+template<typename T, typename Alloc = TAlignedAllocator<T>> class TDynamicMatrix;
+template<typename T> class TMatrixRow;
+template<typename T, bool Upper> class TTriangularMatrix;
+template<typename T> class TSparseMatrix;
+template<typename T> class TMappedMatrix;
+template<typename T> class TVectorView;
+template<typename T> class TMatrixView;
+
+enum class TSparseFormat { CSR, CSC };
+
+// Шаблоны выражений: операторы +, - и умножение на скаляр возвращают лёгкие
+// узлы, которые вычисляются одним проходом при присваивании или конструировании.
+// Векторное выражение имеет size() и eval(i), матричное — rows(), cols() и eval(i, j);
+// eval не проверяет индексы.
+template<typename E> struct TIsVectorExpr : std::false_type {};
+template<typename E> struct TIsMatrixExpr : std::false_type {};
+// Листья (владеющие памятью объекты) хранятся в узлах по ссылке, узлы — по значению
+template<typename E> struct TIsExprLeaf : std::false_type {};
+
+template<typename T, typename A> struct TIsVectorExpr<TDynamicVector<T, A>> : std::true_type {};
+template<typename T> struct TIsVectorExpr<TMatrixRow<T>> : std::true_type {};
+template<typename T, typename A> struct TIsMatrixExpr<TDynamicMatrix<T, A>> : std::true_type {};
+template<typename T, typename A> struct TIsExprLeaf<TDynamicVector<T, A>> : std::true_type {};
+template<typename T, typename A> struct TIsExprLeaf<TDynamicMatrix<T, A>> : std::true_type {};
+template<typename T, bool U> struct TIsMatrixExpr<TTriangularMatrix<T, U>> : std::true_type {};
+template<typename T, bool U> struct TIsExprLeaf<TTriangularMatrix<T, U>> : std::true_type {};
+template<typename T> struct TIsMatrixExpr<TSparseMatrix<T>> : std::true_type {};
+template<typename T> struct TIsExprLeaf<TSparseMatrix<T>> : std::true_type {};
+template<typename T> struct TIsMatrixExpr<TMappedMatrix<T>> : std::true_type {};
+template<typename T> struct TIsExprLeaf<TMappedMatrix<T>> : std::true_type {};
+// Представления не владеют памятью и копируются в узлы по значению
+template<typename T> struct TIsVectorExpr<TVectorView<T>> : std::true_type {};
+template<typename T> struct TIsMatrixExpr<TMatrixView<T>> : std::true_type {};
+
+// Плотные матрицы: элементы лежат по строкам, (i, j) — data()[i * stride() + j].
+// Такие операнды передаются в GEMM/GEMV без копирования
+template<typename E> struct TIsDenseMatrix : std::false_type {};
+template<typename T, typename A> struct TIsDenseMatrix<TDynamicMatrix<T, A>> : std::true_type {};
+template<typename T> struct TIsDenseMatrix<TMappedMatrix<T>> : std::true_type {};
+template<typename T> struct TIsDenseMatrix<TMatrixView<T>> : std::true_type {};
+
+struct TAddOp { template<typename T> static T apply(const T& a, const T& b) { return a + b; } };
+struct TSubOp { template<typename T> static T apply(const T& a, const T& b) { return a - b; } };
+struct TMulOp { template<typename T> static T apply(const T& a, const T& b) { return a * b; } };
+
+namespace utmatrix_detail {
+
+template<typename E>
+using TExprOperand = typename std::conditional<TIsExprLeaf<E>::value, const E&, const E>::type;
+
+} // namespace utmatrix_detail
+
+// Общая часть узлов векторных выражений: проверяемый доступ к элементам
+template<typename E>
+class TVectorExprBase
+{
+    const E& self() const noexcept { return static_cast<const E&>(*this); }
+
+public:
+    auto operator[](size_t ind) const {
+        if (ind >= self().size()) throw out_of_range("Индекс вне диапазона");
+        return self().eval(ind);
+    }
+
+    auto at(size_t ind) const { return (*this)[ind]; }
+};
+
+template<typename L, typename R, typename Op>
+class TVectorBinaryExpr : public TVectorExprBase<TVectorBinaryExpr<L, R, Op>>
+{
+    utmatrix_detail::TExprOperand<L> lhs;
+    utmatrix_detail::TExprOperand<R> rhs;
+
+public:
+    typedef typename L::value_type value_type;
+
+    TVectorBinaryExpr(const L& l, const R& r) : lhs(l), rhs(r)
+    {
+        if (l.size() != r.size()) throw invalid_argument("Векторы должны быть одного размера");
+    }
+
+    size_t size() const noexcept { return lhs.size(); }
+    value_type eval(size_t i) const { return Op::apply(lhs.eval(i), rhs.eval(i)); }
+    const L& left() const noexcept { return lhs; }
+    const R& right() const noexcept { return rhs; }
+};
+
+template<typename L, typename Op>
+class TVectorScalarExpr : public TVectorExprBase<TVectorScalarExpr<L, Op>>
+{
+public:
+    typedef typename L::value_type value_type;
+
+private:
+    utmatrix_detail::TExprOperand<L> lhs;
+    value_type val;
+
+public:
+    TVectorScalarExpr(const L& l, const value_type& v) : lhs(l), val(v) {}
+
+    size_t size() const noexcept { return lhs.size(); }
+    value_type eval(size_t i) const { return Op::apply(lhs.eval(i), val); }
+    const L& left() const noexcept { return lhs; }
+    const value_type& scalar() const noexcept { return val; }
+};
+
+template<typename L, typename R, typename Op>
+struct TIsVectorExpr<TVectorBinaryExpr<L, R, Op>> : std::true_type {};
+template<typename L, typename Op>
+struct TIsVectorExpr<TVectorScalarExpr<L, Op>> : std::true_type {};
+
+// Строка матричного выражения, возвращаемая operator[] узла
+template<typename E>
+class TMatrixExprRow
+{
+    const E& expr;
+    size_t row;
+
+public:
+    TMatrixExprRow(const E& e, size_t i) noexcept : expr(e), row(i) {}
+
+    size_t size() const noexcept { return expr.cols(); }
+
+    auto operator[](size_t ind) const {
+        if (ind >= expr.cols()) throw out_of_range("Индекс вне диапазона");
+        return expr.eval(row, ind);
+    }
+};
+
+template<typename E>
+class TMatrixExprBase
+{
+    const E& self() const noexcept { return static_cast<const E&>(*this); }
+
+public:
+    TMatrixExprRow<E> operator[](size_t ind) const {
+        if (ind >= self().rows()) throw out_of_range("Индекс вне диапазона");
+        return TMatrixExprRow<E>(self(), ind);
+    }
+};
+
+template<typename L, typename R, typename Op>
+class TMatrixBinaryExpr : public TMatrixExprBase<TMatrixBinaryExpr<L, R, Op>>
+{
+    utmatrix_detail::TExprOperand<L> lhs;
+    utmatrix_detail::TExprOperand<R> rhs;
+
+public:
+    typedef typename L::value_type value_type;
+
+    TMatrixBinaryExpr(const L& l, const R& r) : lhs(l), rhs(r)
+    {
+        if (l.rows() != r.rows() || l.cols() != r.cols()) throw invalid_argument("Матрицы должны быть одного размера");
+    }
+
+    size_t rows() const noexcept { return lhs.rows(); }
+    size_t cols() const noexcept { return lhs.cols(); }
+    value_type eval(size_t i, size_t j) const { return Op::apply(lhs.eval(i, j), rhs.eval(i, j)); }
+    const L& left() const noexcept { return lhs; }
+    const R& right() const noexcept { return rhs; }
+};
+
+template<typename L, typename Op>
+class TMatrixScalarExpr : public TMatrixExprBase<TMatrixScalarExpr<L, Op>>
+{
+public:
+    typedef typename L::value_type value_type;
+
+private:
+    utmatrix_detail::TExprOperand<L> lhs;
+    value_type val;
+
+public:
+    TMatrixScalarExpr(const L& l, const value_type& v) : lhs(l), val(v) {}
+
+    size_t rows() const noexcept { return lhs.rows(); }
+    size_t cols() const noexcept { return lhs.cols(); }
+    value_type eval(size_t i, size_t j) const { return Op::apply(lhs.eval(i, j), val); }
+    const L& left() const noexcept { return lhs; }
+    const value_type& scalar() const noexcept { return val; }
+};
+
+template<typename L, typename R, typename Op>
+struct TIsMatrixExpr<TMatrixBinaryExpr<L, R, Op>> : std::true_type {};
+template<typename L, typename Op>
+struct TIsMatrixExpr<TMatrixScalarExpr<L, Op>> : std::true_type {};
+
+namespace utmatrix_detail {
+
+// Вычисление выражений в готовый буфер. Общий случай — один цикл по элементам;
+// простейшие узлы над непрерывными листьями передаются SIMD-ядрам.
+struct TExprEval
+{
+    // Поэлементные ядра над непрерывными участками: SIMD, если есть, иначе цикл
+
+    template<typename T, typename Op>
+    static void binary(const T* a, const T* b, T* dst, size_t n, Op)
+    {
+        for (size_t i = 0; i < n; i++)
+            dst[i] = Op::apply(a[i], b[i]);
+    }
+
+    template<typename T>
+    static void binary(const T* a, const T* b, T* dst, size_t n, TAddOp)
+    {
+        if (auto k = simdKernels<T>()) k->add(a, b, dst, n);
+        else for (size_t i = 0; i < n; i++) dst[i] = a[i] + b[i];
+    }
+
+    template<typename T>
+    static void binary(const T* a, const T* b, T* dst, size_t n, TSubOp)
+    {
+        if (auto k = simdKernels<T>()) k->sub(a, b, dst, n);
+        else for (size_t i = 0; i < n; i++) dst[i] = a[i] - b[i];
+    }
+
+    template<typename T, typename Op>
+    static void scalar(const T* a, const T& val, T* dst, size_t n, Op)
+    {
+        for (size_t i = 0; i < n; i++)
+            dst[i] = Op::apply(a[i], val);
+    }
+
+    template<typename T>
+    static void scalar(const T* a, const T& val, T* dst, size_t n, TAddOp)
+    {
+        if (auto k = simdKernels<T>()) k->addScalar(a, val, dst, n);
+        else for (size_t i = 0; i < n; i++) dst[i] = a[i] + val;
+    }
+
+    template<typename T>
+    static void scalar(const T* a, const T& val, T* dst, size_t n, TSubOp)
+    {
+        if (auto k = simdKernels<T>()) k->subScalar(a, val, dst, n);
+        else for (size_t i = 0; i < n; i++) dst[i] = a[i] - val;
+    }
+
+    template<typename T>
+    static void scalar(const T* a, const T& val, T* dst, size_t n, TMulOp)
+    {
+        if (auto k = simdKernels<T>()) k->mulScalar(a, val, dst, n);
+        else for (size_t i = 0; i < n; i++) dst[i] = a[i] * val;
+    }
+
+    template<typename T>
+    static T dot(const T* a, const T* b, size_t n)
+    {
+        if (auto k = simdKernels<T>()) return k->dot(a, b, n);
+        T result = T();
+        for (size_t i = 0; i < n; i++)
+            result += a[i] * b[i];
+        return result;
+    }
+
+    template<typename T>
+    static void axpy(const T& alpha, const T* x, T* y, size_t n)
+    {
+        if (auto k = simdKernels<T>()) k->axpy(alpha, x, y, n);
+        else for (size_t i = 0; i < n; i++) y[i] += alpha * x[i];
+    }
+
+    // Матрицы делятся между потоками пула по диапазонам строк
+    template<typename F>
+    static void forRows(size_t r, size_t c, F&& f)
+    {
+        const size_t minElems = 1 << 15; // меньший кусок не окупает запуск потока
+        const size_t grain = std::max<size_t>(1, minElems / std::max<size_t>(1, c));
+        TThreadPool::instance().parallelFor(0, r, grain, f);
+    }
+
+    // Векторы
+
+    template<typename T, typename E>
+    static void assign(T* dst, const E& e)
+    {
+        const size_t n = e.size();
+        for (size_t i = 0; i < n; i++)
+            dst[i] = e.eval(i);
+    }
+
+    template<typename T, typename A, typename B, typename Op>
+    static void assign(T* dst, const TVectorBinaryExpr<TDynamicVector<T, A>, TDynamicVector<T, B>, Op>& e)
+    {
+        binary(e.left().pMem, e.right().pMem, dst, e.size(), Op());
+    }
+
+    template<typename T, typename A, typename Op>
+    static void assign(T* dst, const TVectorScalarExpr<TDynamicVector<T, A>, Op>& e)
+    {
+        scalar(e.left().pMem, e.scalar(), dst, e.size(), Op());
+    }
+
+    // Обновление на месте: dst[i] = dst[i] op e[i]
+    template<typename T, typename E, typename Op>
+    static void update(T* dst, const E& e, Op)
+    {
+        const size_t n = e.size();
+        for (size_t i = 0; i < n; i++)
+            dst[i] = Op::apply(dst[i], e.eval(i));
+    }
+
+    template<typename T, typename A, typename Op>
+    static void update(T* dst, const TDynamicVector<T, A>& v, Op)
+    {
+        binary(dst, v.pMem, dst, v.sz, Op());
+    }
+
+    // Строки матрицы непрерывны и тоже обрабатываются векторными ядрами
+    template<typename T, typename U, typename Op>
+    static void update(T* dst, const TMatrixRow<U>& r, Op)
+    {
+        binary(dst, r.data(), dst, r.size(), Op());
+    }
+
+    template<typename T, typename U, typename Op>
+    static void update(T* dst, const TVectorView<U>& v, Op)
+    {
+        if (v.stride() == 1)
+            binary(dst, static_cast<const T*>(v.data()), dst, v.size(), Op());
+        else
+            for (size_t i = 0; i < v.size(); i++)
+                dst[i] = Op::apply(dst[i], v(i));
+    }
+
+    template<typename T, typename Op>
+    static void updateScalar(T* dst, size_t n, const T& val, Op)
+    {
+        scalar(dst, val, dst, n, Op());
+    }
+
+    // y += alpha * x
+    template<typename T, typename E>
+    static void axpy(T* y, const T& alpha, const E& x)
+    {
+        const size_t n = x.size();
+        for (size_t i = 0; i < n; i++)
+            y[i] += alpha * x.eval(i);
+    }
+
+    template<typename T, typename A>
+    static void axpy(T* y, const T& alpha, const TDynamicVector<T, A>& x)
+    {
+        axpy(alpha, x.pMem, y, x.sz);
+    }
+
+    template<typename T, typename U>
+    static void axpy(T* y, const T& alpha, const TMatrixRow<U>& x)
+    {
+        axpy(alpha, x.data(), y, x.size());
+    }
+
+    template<typename T, typename U>
+    static void axpy(T* y, const T& alpha, const TVectorView<U>& x)
+    {
+        if (x.stride() == 1)
+            axpy(alpha, static_cast<const T*>(x.data()), y, x.size());
+        else
+            for (size_t i = 0; i < x.size(); i++)
+                y[i] += alpha * x(i);
+    }
+
+    // Матрицы: строки результата лежат с шагом ldd (у плотной матрицы ldd == cols)
+
+    template<typename T, typename E>
+    static typename std::enable_if<!TIsDenseMatrix<E>::value>::type assignMatrix(T* dst, size_t ldd, const E& e)
+    {
+        const size_t c = e.cols();
+        forRows(e.rows(), c, [&](size_t rb, size_t re) {
+            for (size_t i = rb; i < re; i++) {
+                T* row = dst + i * ldd;
+                for (size_t j = 0; j < c; j++)
+                    row[j] = e.eval(i, j);
+            }
+        });
+    }
+
+    // Плотные операнды обрабатываются векторными ядрами по строкам, а если
+    // строки всех операндов идут без промежутков — одним участком на поток
+    template<typename T, typename M>
+    static typename std::enable_if<TIsDenseMatrix<M>::value>::type assignMatrix(T* dst, size_t ldd, const M& m)
+    {
+        const size_t c = m.cols(), lda = m.stride();
+        const T* a = m.data();
+        forRows(m.rows(), c, [&](size_t rb, size_t re) {
+            if (lda == c && ldd == c)
+                std::copy_n(a + rb * c, (re - rb) * c, dst + rb * c);
+            else
+                for (size_t i = rb; i < re; i++)
+                    std::copy_n(a + i * lda, c, dst + i * ldd);
+        });
+    }
+
+    template<typename T, typename L, typename R, typename Op>
+    static typename std::enable_if<TIsDenseMatrix<L>::value && TIsDenseMatrix<R>::value>::type
+        assignMatrix(T* dst, size_t ldd, const TMatrixBinaryExpr<L, R, Op>& e)
+    {
+        const size_t c = e.cols(), lda = e.left().stride(), ldb = e.right().stride();
+        const T* a = e.left().data();
+        const T* b = e.right().data();
+        forRows(e.rows(), c, [&](size_t rb, size_t re) {
+            if (lda == c && ldb == c && ldd == c)
+                binary(a + rb * c, b + rb * c, dst + rb * c, (re - rb) * c, Op());
+            else
+                for (size_t i = rb; i < re; i++)
+                    binary(a + i * lda, b + i * ldb, dst + i * ldd, c, Op());
+        });
+    }
+
+    template<typename T, typename L, typename Op>
+    static typename std::enable_if<TIsDenseMatrix<L>::value>::type
+        assignMatrix(T* dst, size_t ldd, const TMatrixScalarExpr<L, Op>& e)
+    {
+        const size_t c = e.cols(), lda = e.left().stride();
+        const T* a = e.left().data();
+        const T& val = e.scalar();
+        forRows(e.rows(), c, [&](size_t rb, size_t re) {
+            if (lda == c && ldd == c)
+                scalar(a + rb * c, val, dst + rb * c, (re - rb) * c, Op());
+            else
+                for (size_t i = rb; i < re; i++)
+                    scalar(a + i * lda, val, dst + i * ldd, c, Op());
+        });
+    }
+
+    // Треугольная матрица в плотную: копирование хранимых строк и нули вне треугольника
+    template<typename T, bool U>
+    static void assignMatrix(T* dst, size_t ldd, const TTriangularMatrix<T, U>& m)
+    {
+        const size_t c = m.cols();
+        forRows(m.rows(), c, [&](size_t rb, size_t re) {
+            for (size_t i = rb; i < re; i++) {
+                T* row = dst + i * ldd;
+                std::fill_n(row, c, T());
+                std::copy_n(m.rowData(i), m.rowLength(i), row + m.rowBegin(i));
+            }
+        });
+    }
+
+    // Разреженная матрица в плотную: обнуление и разнесение ненулевых элементов
+    template<typename T>
+    static void assignMatrix(T* dst, size_t ldd, const TSparseMatrix<T>& m)
+    {
+        const size_t c = m.cols();
+        const bool csr = m.format() == TSparseFormat::CSR;
+        const auto& outer = m.outerIndex();
+        const auto& inner = m.innerIndex();
+        const auto& vals = m.values();
+        forRows(m.rows(), c, [&](size_t rb, size_t re) {
+            for (size_t i = rb; i < re; i++)
+                std::fill_n(dst + i * ldd, c, T());
+            if (csr)
+                for (size_t i = rb; i < re; i++)
+                    for (size_t q = outer[i]; q < outer[i + 1]; q++)
+                        dst[i * ldd + inner[q]] = vals[q];
+        });
+        if (!csr)
+            for (size_t j = 0; j < c; j++)
+                for (size_t q = outer[j]; q < outer[j + 1]; q++)
+                    dst[inner[q] * ldd + j] = vals[q];
+    }
+
+    template<typename T, typename E, typename Op>
+    static typename std::enable_if<!TIsDenseMatrix<E>::value>::type updateMatrix(T* dst, size_t ldd, const E& e, Op)
+    {
+        const size_t c = e.cols();
+        forRows(e.rows(), c, [&](size_t rb, size_t re) {
+            for (size_t i = rb; i < re; i++) {
+                T* row = dst + i * ldd;
+                for (size_t j = 0; j < c; j++)
+                    row[j] = Op::apply(row[j], e.eval(i, j));
+            }
+        });
+    }
+
+    template<typename T, typename M, typename Op>
+    static typename std::enable_if<TIsDenseMatrix<M>::value>::type updateMatrix(T* dst, size_t ldd, const M& m, Op)
+    {
+        const size_t c = m.cols(), lda = m.stride();
+        const T* a = m.data();
+        forRows(m.rows(), c, [&](size_t rb, size_t re) {
+            if (lda == c && ldd == c)
+                binary(dst + rb * c, a + rb * c, dst + rb * c, (re - rb) * c, Op());
+            else
+                for (size_t i = rb; i < re; i++)
+                    binary(dst + i * ldd, a + i * lda, dst + i * ldd, c, Op());
+        });
+    }
+
+    template<typename T, typename Op>
+    static void updateMatrixScalar(T* dst, size_t ldd, size_t r, size_t c, const T& val, Op)
+    {
+        forRows(r, c, [&](size_t rb, size_t re) {
+            if (ldd == c)
+                scalar(dst + rb * c, val, dst + rb * c, (re - rb) * c, Op());
+            else
+                for (size_t i = rb; i < re; i++)
+                    scalar(dst + i * ldd, val, dst + i * ldd, c, Op());
+        });
+    }
+
+    template<typename T, typename E>
+    static typename std::enable_if<!TIsDenseMatrix<E>::value>::type axpyMatrix(T* y, size_t ldy, const T& alpha, const E& x)
+    {
+        const size_t c = x.cols();
+        forRows(x.rows(), c, [&](size_t rb, size_t re) {
+            for (size_t i = rb; i < re; i++) {
+                T* row = y + i * ldy;
+                for (size_t j = 0; j < c; j++)
+                    row[j] += alpha * x.eval(i, j);
+            }
+        });
+    }
+
+    template<typename T, typename M>
+    static typename std::enable_if<TIsDenseMatrix<M>::value>::type axpyMatrix(T* y, size_t ldy, const T& alpha, const M& x)
+    {
+        const size_t c = x.cols(), ldx = x.stride();
+        const T* a = x.data();
+        forRows(x.rows(), c, [&](size_t rb, size_t re) {
+            if (ldx == c && ldy == c)
+                axpy(alpha, a + rb * c, y + rb * c, (re - rb) * c);
+            else
+                for (size_t i = rb; i < re; i++)
+                    axpy(alpha, a + i * ldx, y + i * ldy, c);
+        });
+    }
+
+    template<typename L, typename R>
+    static typename L::value_type dot(const L& l, const R& r)
+    {
+        typedef typename L::value_type T;
+        T result = T();
+        const size_t n = l.size();
+        for (size_t i = 0; i < n; i++)
+            result += l.eval(i) * r.eval(i);
+        return result;
+    }
+
+    template<typename T, typename A, typename B>
+    static T dot(const TDynamicVector<T, A>& l, const TDynamicVector<T, B>& r)
+    {
+        return dot(l.pMem, r.pMem, l.sz);
+    }
+};
+
+// Листья передаются как есть, узлы вычисляются во временную матрицу
+template<typename T, typename A>
+const TDynamicMatrix<T, A>& materialize(const TDynamicMatrix<T, A>& m) noexcept { return m; }
+
+template<typename E>
+typename std::enable_if<TIsMatrixExpr<E>::value && !TIsExprLeaf<E>::value,
+    TDynamicMatrix<typename E::value_type>>::type materialize(const E& e) { return TDynamicMatrix<typename E::value_type>(e); }
+
+// В произведениях с плотными матрицами треугольные и разреженные матрицы разворачиваются
+template<typename T, bool U>
+TDynamicMatrix<T> materialize(const TTriangularMatrix<T, U>& m) { return TDynamicMatrix<T>(m); }
+
+template<typename T>
+TDynamicMatrix<T> materialize(const TSparseMatrix<T>& m) { return TDynamicMatrix<T>(m); }
+
+template<typename T>
+const TMappedMatrix<T>& materialize(const TMappedMatrix<T>& m) noexcept { return m; }
+
+template<typename T>
+const TMatrixView<T>& materialize(const TMatrixView<T>& m) noexcept { return m; }
+
+template<typename T, typename A>
+const TDynamicVector<T, A>& materialize(const TDynamicVector<T, A>& v) noexcept { return v; }
+
+template<typename E>
+typename std::enable_if<TIsVectorExpr<E>::value && !TIsExprLeaf<E>::value,
+    TDynamicVector<typename E::value_type>>::type materialize(const E& e) { return TDynamicVector<typename E::value_type>(e); }
+
+} // namespace utmatrix_detail
+
+namespace utmatrix_detail {
+
+// Быстрый текстовый ввод-вывод чисел через from_chars/to_chars: без локали,
+// без виртуальных вызовов на каждый элемент. Текст читается большими кусками,
+// кусок делится между потоками по границам разделителей: первый проход считает
+// числа в каждой части, второй разбирает части параллельно, каждая — в своё
+// смещение результата. Типы без from_chars (символы, bool, пользовательские)
+// и потоки без позиционирования обрабатываются прежним поэлементным путём.
+template<typename T>
+struct TTextCodec
+{
+    static constexpr bool supported = std::is_arithmetic<T>::value && !std::is_same<T, bool>::value &&
+        !std::is_same<T, char>::value && !std::is_same<T, signed char>::value && !std::is_same<T, unsigned char>::value;
+
+    // constexpr, а не const: std::min берёт их по ссылке, а отдельного определения нет
+    static constexpr size_t chunkSize = size_t(1) << 24; // байт за одно чтение
+    static constexpr size_t minPartSize = size_t(1) << 20; // меньшая часть не окупает поток
+
+    // Разделители чисел: пробельные символы, а также запятая и точка с запятой (CSV)
+    static bool isSeparator(char c) noexcept
+    {
+        struct TTable
+        {
+            bool sep[256] = {};
+            TTable() { for (unsigned char c : { ' ', '\n', '\r', '\t', ',', ';', '\v', '\f' }) sep[c] = true; }
+        };
+        static const TTable table;
+        return table.sep[static_cast<unsigned char>(c)];
+    }
+
+    static size_t countTokens(const char* b, const char* e) noexcept
+    {
+        size_t count = 0;
+        bool inToken = false;
+        for (; b != e; ++b) {
+            const bool sep = isSeparator(*b);
+            count += !sep && !inToken;
+            inToken = !sep;
+        }
+        return count;
+    }
+
+    // Разбор не более need чисел до конца участка; false при некорректной записи числа
+    static bool parse(const char* b, const char* e, T* dst, size_t need, size_t& parsed, const char*& stop) noexcept
+    {
+        parsed = 0;
+        while (parsed < need) {
+            while (b != e && isSeparator(*b)) ++b;
+            if (b == e) break;
+            if (*b == '+' && b + 1 != e && b[1] != '-') ++b; // from_chars не принимает '+'
+            auto r = std::from_chars(b, e, dst[parsed]);
+            if (r.ec != std::errc() || (r.ptr != e && !isSeparator(*r.ptr))) return false;
+            b = r.ptr;
+            parsed++;
+        }
+        stop = b;
+        return true;
+    }
+
+    // Разбор [b, e) с делением на части между потоками; возвращает число
+    // прочитанных значений (не больше need) и конец последнего из них
+    static size_t parseRegion(const char* b, const char* e, T* dst, size_t need, const char*& stop, bool& ok)
+    {
+        const size_t threads = TThreadPool::instance().threadCount();
+        const size_t parts = std::min(threads * 4, size_t(e - b) / minPartSize);
+        size_t parsed = 0;
+        if (threads == 1 || parts < 2) {
+            ok = parse(b, e, dst, need, parsed, stop);
+            return parsed;
+        }
+        std::vector<const char*> bounds(parts + 1);
+        bounds[0] = b;
+        bounds[parts] = e;
+        for (size_t p = 1; p < parts; p++) {
+            const char* q = std::max(bounds[p - 1], b + (e - b) / ptrdiff_t(parts) * ptrdiff_t(p));
+            while (q != e && !isSeparator(*q)) ++q;
+            bounds[p] = q;
+        }
+        std::vector<size_t> offset(parts + 1, 0);
+        TThreadPool::instance().parallelFor(0, parts, 1, [&](size_t pb, size_t pe) {
+            for (size_t p = pb; p < pe; p++)
+                offset[p + 1] = countTokens(bounds[p], bounds[p + 1]);
+        });
+        for (size_t p = 0; p < parts; p++)
+            offset[p + 1] += offset[p];
+        size_t last = 0; // последняя часть, из которой нужны числа
+        while (last + 1 < parts && offset[last + 1] < need) last++;
+        std::atomic<bool> good(true);
+        std::vector<const char*> ends(parts, nullptr);
+        TThreadPool::instance().parallelFor(0, last + 1, 1, [&](size_t pb, size_t pe) {
+            for (size_t p = pb; p < pe; p++) {
+                size_t cnt;
+                if (!parse(bounds[p], bounds[p + 1], dst + offset[p], std::min(offset[p + 1], need) - offset[p], cnt, ends[p]))
+                    good = false;
+            }
+        });
+        ok = good;
+        stop = ends[last];
+        return std::min(offset[last + 1], need);
+    }
+
+    static void readSlow(istream& istr, T* dst, size_t n)
+    {
+        for (size_t i = 0; i < n; i++)
+            istr >> dst[i];
+    }
+
+    static void read(istream& istr, T* dst, size_t n)
+    {
+        if (!istr || n == 0) return;
+        streambuf* sb = istr.rdbuf();
+        const streampos start = sb->pubseekoff(0, ios::cur, ios::in);
+        if (start == streampos(streamoff(-1))) {
+            readSlow(istr, dst, n);
+            return;
+        }
+        std::string buf;
+        size_t have = 0, done = 0;
+        size_t chunk = size_t(1) << 16; // куски растут до chunkSize, чтобы малые данные не требовали большого буфера
+        streamoff consumed = 0;
+        for (;;) {
+            buf.resize(have + chunk);
+            const size_t got = size_t(sb->sgetn(&buf[have], std::streamsize(chunk)));
+            have += got;
+            const bool eof = got < chunk;
+            chunk = std::min(chunk * 2, chunkSize);
+            // Числа на границе куска дочитываются со следующим куском
+            size_t limit = have;
+            if (!eof)
+                while (limit > 0 && !isSeparator(buf[limit - 1])) limit--;
+            if (limit > 0) {
+                const char* stop = buf.data();
+                bool ok = true;
+                done += parseRegion(buf.data(), buf.data() + limit, dst + done, n - done, stop, ok);
+                if (!ok) {
+                    istr.setstate(ios::failbit);
+                    return;
+                }
+                if (done == n) {
+                    sb->pubseekpos(start + consumed + streamoff(stop - buf.data()), ios::in);
+                    return;
+                }
+            }
+            if (eof) {
+                istr.setstate(ios::failbit | ios::eofbit);
+                return;
+            }
+            buf.erase(0, limit);
+            have -= limit;
+            consumed += streamoff(limit);
+        }
+    }
+
+    // Формат числа по состоянию потока, как у operator<<; false — нужен прежний путь
+    static bool format(const ostream& ostr, std::chars_format& fmt, int& precision) noexcept
+    {
+        const ios::fmtflags f = ostr.flags();
+        if (ostr.width() != 0 || (f & (ios::showpos | ios::showpoint | ios::uppercase | ios::showbase))) return false;
+        if (std::is_integral<T>::value) return (f & ios::basefield) == ios::dec || (f & ios::basefield) == 0;
+        const ios::fmtflags ff = f & ios::floatfield;
+        if (ff == (ios::fixed | ios::scientific)) return false;
+        fmt = ff == ios::fixed ? std::chars_format::fixed
+            : ff == ios::scientific ? std::chars_format::scientific : std::chars_format::general;
+        precision = int(ostr.precision());
+        return true;
+    }
+
+    template<typename U = T>
+    static typename std::enable_if<std::is_integral<U>::value, char*>::type
+        put(char* b, char* e, U v, std::chars_format, int) noexcept { return std::to_chars(b, e, v).ptr; }
+
+    template<typename U = T>
+    static typename std::enable_if<std::is_floating_point<U>::value, char*>::type
+        put(char* b, char* e, U v, std::chars_format fmt, int precision) noexcept { return std::to_chars(b, e, v, fmt, precision).ptr; }
+
+    static void writeSlow(ostream& ostr, const T* src, size_t rows, size_t cols, size_t stride, bool lines)
+    {
+        for (size_t i = 0; i < rows; i++) {
+            for (size_t j = 0; j < cols; j++)
+                ostr << src[i * stride + j] << ' ';
+            if (lines) ostr << endl;
+        }
+    }
+
+    // Строки по cols чисел (шаг строк stride), после каждого числа пробел,
+    // после строки — перевод строки, если lines
+    static void write(ostream& ostr, const T* src, size_t rows, size_t cols, size_t stride, bool lines)
+    {
+        std::chars_format fmt = std::chars_format::general;
+        int precision = 6;
+        if (!format(ostr, fmt, precision) || precision > 1000) {
+            writeSlow(ostr, src, rows, cols, stride, lines);
+            return;
+        }
+        // В фиксированной записи целая часть занимает до max_exponent10 + 1 цифр:
+        // 309 у double, почти 5000 у 80-битного long double
+        const size_t intDigits = std::is_floating_point<T>::value ? size_t(std::numeric_limits<T>::max_exponent10) + 1 : 0;
+        const size_t maxLen = size_t(precision) + (fmt == std::chars_format::fixed ? intDigits : 0) + 42;
+        // Элементы форматируются частями параллельно и пишутся в поток по порядку;
+        // буфер части — около 4 МБ независимо от длины числа
+        const size_t total = rows * cols, perPart = std::max<size_t>(1, (size_t(1) << 22) / maxLen);
+        const size_t partsPerBatch = TThreadPool::instance().threadCount() * 4;
+        std::vector<std::string> parts(partsPerBatch);
+        for (size_t batch = 0; batch < total; batch += perPart * partsPerBatch) {
+            const size_t batchParts = std::min(partsPerBatch, (total - batch + perPart - 1) / perPart);
+            TThreadPool::instance().parallelFor(0, batchParts, 1, [&](size_t pb, size_t pe) {
+                for (size_t p = pb; p < pe; p++) {
+                    const size_t eb = batch + p * perPart, ee = std::min(total, eb + perPart);
+                    std::string& s = parts[p];
+                    s.resize((ee - eb) * maxLen);
+                    char* out = &s[0];
+                    char* end = out + s.size();
+                    size_t i = eb / cols, j = eb % cols;
+                    for (size_t k = eb; k < ee; k++) {
+                        out = put(out, end, src[i * stride + j], fmt, precision);
+                        *out++ = ' ';
+                        if (++j == cols) {
+                            if (lines) *out++ = '\n';
+                            j = 0;
+                            i++;
+                        }
+                    }
+                    s.resize(size_t(out - s.data()));
+                }
+            });
+            for (size_t p = 0; p < batchParts; p++)
+                ostr.write(parts[p].data(), std::streamsize(parts[p].size()));
+        }
+        if (lines) ostr.flush();
+    }
+};
+
+template<typename T>
+typename std::enable_if<TTextCodec<T>::supported>::type readText(istream& istr, T* dst, size_t n)
+{
+    TTextCodec<T>::read(istr, dst, n);
+}
+
+template<typename T>
+typename std::enable_if<!TTextCodec<T>::supported>::type readText(istream& istr, T* dst, size_t n)
+{
+    TTextCodec<T>::readSlow(istr, dst, n);
+}
+
+template<typename T>
+typename std::enable_if<TTextCodec<T>::supported>::type
+    writeText(ostream& ostr, const T* src, size_t rows, size_t cols, size_t stride, bool lines)
+{
+    TTextCodec<T>::write(ostr, src, rows, cols, stride, lines);
+}
+
+template<typename T>
+typename std::enable_if<!TTextCodec<T>::supported>::type
+    writeText(ostream& ostr, const T* src, size_t rows, size_t cols, size_t stride, bool lines)
+{
+    TTextCodec<T>::writeSlow(ostr, src, rows, cols, stride, lines);
+}
+
+} // namespace utmatrix_detail
+
+template<typename T, typename Alloc>
+class TDynamicVector
+{
+    typedef std::allocator_traits<Alloc> TAllocTraits;
+
+protected:
+    size_t sz;
+    T* pMem;
+    Alloc alloc;
+
+    friend struct utmatrix_detail::TExprEval;
+
+    // Выделение памяти без инициализации элементов
+    T* allocate(size_t n)
+    {
+        allocationCounter().fetch_add(1, std::memory_order_relaxed);
+        return TAllocTraits::allocate(alloc, n);
+    }
+
+    void deallocate(T* p, size_t n) noexcept
+    {
+        TAllocTraits::deallocate(alloc, p, n);
+    }
+
+    // Выделение буфера и его инициализация init(p); при исключении память освобождается
+    template<typename F>
+    T* construct(size_t n, F&& init)
+    {
+        T* p = allocate(n);
+        try {
+            init(p);
+        }
+        catch (...) {
+            deallocate(p, n);
+            throw;
+        }
+        return p;
+    }
+
+    T* create(size_t n)
+    {
+        return construct(n, [n](T* p) { std::uninitialized_value_construct_n(p, n); });
+    }
+
+    // Для тривиальных типов память остаётся неинициализированной
+    T* createUninitialized(size_t n)
+    {
+        return construct(n, [n](T* p) { std::uninitialized_default_construct_n(p, n); });
+    }
+
+    T* createFilled(size_t n, const T& value)
+    {
+        return construct(n, [n, &value](T* p) { std::uninitialized_fill_n(p, n, value); });
+    }
+
+    T* createCopy(const T* src, size_t n)
+    {
+        return construct(n, [n, src](T* p) { std::uninitialized_copy_n(src, n, p); });
+    }
+
+    static size_t checkedSize(size_t n)
+    {
+        if (n == 0 || n > sizeLimits().maxVectorSize)
+            throw out_of_range("Вектор должен быть больше нуля, но меньше максимального значения");
+        return n;
+    }
+
+    void destroy(T* p, size_t n) noexcept
+    {
+        if (p == nullptr) return;
+        std::destroy_n(p, n);
+        deallocate(p, n);
+    }
+
+public:
+    typedef T value_type;
+    typedef Alloc allocator_type;
+
+    TDynamicVector(size_t size = 1, const Alloc& a = Alloc()) : sz(checkedSize(size)), alloc(a) {
+        pMem = create(sz);
+    }
+
+    // Элементы не обнуляются: для результатов, которые сразу перезаписываются целиком
+    TDynamicVector(size_t size, TUninitializedTag, const Alloc& a = Alloc()) : sz(checkedSize(size)), alloc(a) {
+        pMem = createUninitialized(sz);
+    }
+
+    TDynamicVector(size_t size, const T& value, const Alloc& a = Alloc()) : sz(checkedSize(size)), alloc(a) {
+        pMem = createFilled(sz, value);
+    }
+
+    TDynamicVector(T* arr, size_t s, const Alloc& a = Alloc()) : sz(s), alloc(a)
+    {
+        assert(arr != nullptr && "Конструктор TDynamicVector требует ненулевой аргумент");
+        pMem = createCopy(arr, sz);
+    }
+
+    TDynamicVector(const TDynamicVector& v) : sz(v.sz), alloc(TAllocTraits::select_on_container_copy_construction(v.alloc))
+    {
+        pMem = createCopy(v.pMem, sz);
+    }
+
+    // Вычисление выражения за один проход
+    template<typename E, typename = typename std::enable_if<TIsVectorExpr<E>::value && !std::is_same<E, TDynamicVector>::value>::type>
+    TDynamicVector(const E& e, const Alloc& a = Alloc()) : TDynamicVector(e.size(), uninitialized, a)
+    {
+        utmatrix_detail::TExprEval::assign(pMem, e);
+    }
+
+    TDynamicVector(TDynamicVector&& v) noexcept : sz(v.sz), pMem(v.pMem), alloc(std::move(v.alloc))
+    {
+        v.sz = 0;
+        v.pMem = nullptr;
+    }
+
+    ~TDynamicVector()
+    {
+        destroy(pMem, sz);
+    }
+
+    // При совпадении размеров копирование идёт в существующий буфер без выделения памяти
+    TDynamicVector& operator=(const TDynamicVector& v)
+    {
+        if (this == &v) return *this;
+        if (sz == v.sz && pMem != nullptr) {
+            std::copy_n(v.pMem, sz, pMem);
+        }
+        else {
+            T* p = createCopy(v.pMem, v.sz);
+            destroy(pMem, sz);
+            sz = v.sz;
+            pMem = p;
+        }
+        return *this;
+    }
+
+    // Буфер переходит вместе со своим распределителем
+    TDynamicVector& operator=(TDynamicVector&& v) noexcept
+    {
+        if (this != &v) {
+            destroy(pMem, sz);
+            alloc = std::move(v.alloc);
+            sz = v.sz;
+            pMem = v.pMem;
+            v.sz = 0;
+            v.pMem = nullptr;
+        }
+        return *this;
+    }
+
+    Alloc get_allocator() const noexcept { return alloc; }
+
+    // Выражение пишется прямо в текущий буфер, если размеры совпадают:
+    // поэлементные узлы читают только i-й элемент, поэтому совпадение
+    // с операндом безопасно
+    template<typename E, typename = typename std::enable_if<TIsVectorExpr<E>::value && !std::is_same<E, TDynamicVector>::value>::type>
+    TDynamicVector& operator=(const E& e)
+    {
+        if (e.size() == sz) {
+            utmatrix_detail::TExprEval::assign(pMem, e);
+        }
+        else {
+            TDynamicVector tmp(e, alloc);
+            swap(*this, tmp);
+        }
+        return *this;
+    }
+
+    size_t size() const noexcept { return sz; }
+    T eval(size_t ind) const { return pMem[ind]; }
+
+    T& operator[](size_t ind) {
+        if (ind >= sz) throw out_of_range("Индекс вне диапазона");
+        return pMem[ind];
+    }
+
+    const T& operator[](size_t ind) const {
+        if (ind >= sz) throw out_of_range("Индекс вне диапазона");
+        return pMem[ind];
+    }
+
+    T& at(size_t ind)
+    {
+        if (ind >= sz) throw out_of_range("Индекс вне диапазона");
+        return pMem[ind];
+    }
+
+    const T& at(size_t ind) const {
+        if (ind >= sz) throw out_of_range("Индекс вне диапазона");
+        return pMem[ind];
+    }
+
+    // Доступ без проверки индекса для внутренних циклов; проверка только в отладочной сборке
+    T& operator()(size_t ind) noexcept
+    {
+        assert(ind < sz && "Индекс вне диапазона");
+        return pMem[ind];
+    }
+
+    const T& operator()(size_t ind) const noexcept
+    {
+        assert(ind < sz && "Индекс вне диапазона");
+        return pMem[ind];
+    }
+
+    T* data() noexcept { return pMem; }
+    const T* data() const noexcept { return pMem; }
+    T* begin() noexcept { return pMem; }
+    const T* begin() const noexcept { return pMem; }
+    T* end() noexcept { return pMem + sz; }
+    const T* end() const noexcept { return pMem + sz; }
+
+    // Представление size элементов, начиная с offset, с шагом stride
+    TVectorView<T> view() noexcept { return TVectorView<T>(pMem, sz); }
+    TVectorView<const T> view() const noexcept { return TVectorView<const T>(pMem, sz); }
+    TVectorView<T> view(size_t offset, size_t size, size_t stride = 1) { return view().view(offset, size, stride); }
+    TVectorView<const T> view(size_t offset, size_t size, size_t stride = 1) const { return view().view(offset, size, stride); }
+
+    bool operator==(const TDynamicVector& v) const noexcept
+    {
+        if (sz != v.sz) return false;
+        return std::equal(pMem, pMem + sz, v.pMem);
+    }
+
+    bool operator!=(const TDynamicVector& v) const noexcept
+    {
+        return !(*this == v);
+    }
+
+    // Составные операции пишут результат в собственный буфер без выделения памяти
+
+    template<typename E, typename = typename std::enable_if<TIsVectorExpr<E>::value>::type>
+    TDynamicVector& operator+=(const E& e)
+    {
+        if (sz != e.size()) throw invalid_argument("Векторы должны быть одного размера");
+        utmatrix_detail::TExprEval::update(pMem, e, TAddOp());
+        return *this;
+    }
+
+    template<typename E, typename = typename std::enable_if<TIsVectorExpr<E>::value>::type>
+    TDynamicVector& operator-=(const E& e)
+    {
+        if (sz != e.size()) throw invalid_argument("Векторы должны быть одного размера");
+        utmatrix_detail::TExprEval::update(pMem, e, TSubOp());
+        return *this;
+    }
+
+    TDynamicVector& operator+=(const T& val)
+    {
+        utmatrix_detail::TExprEval::updateScalar(pMem, sz, val, TAddOp());
+        return *this;
+    }
+
+    TDynamicVector& operator-=(const T& val)
+    {
+        utmatrix_detail::TExprEval::updateScalar(pMem, sz, val, TSubOp());
+        return *this;
+    }
+
+    TDynamicVector& operator*=(const T& val)
+    {
+        utmatrix_detail::TExprEval::updateScalar(pMem, sz, val, TMulOp());
+        return *this;
+    }
+
+    // this += alpha * x за один проход
+    template<typename E, typename = typename std::enable_if<TIsVectorExpr<E>::value>::type>
+    TDynamicVector& axpy(const T& alpha, const E& x)
+    {
+        if (sz != x.size()) throw invalid_argument("Векторы должны быть одного размера");
+        utmatrix_detail::TExprEval::axpy(pMem, alpha, x);
+        return *this;
+    }
+
+    friend void swap(TDynamicVector& lhs, TDynamicVector& rhs) noexcept
+    {
+        std::swap(lhs.sz, rhs.sz);
+        std::swap(lhs.pMem, rhs.pMem);
+        std::swap(lhs.alloc, rhs.alloc);
+    }
+
+    friend istream& operator>>(istream& istr, TDynamicVector& v)
+    {
+        utmatrix_detail::readText(istr, v.pMem, v.sz);
+        return istr;
+    }
+
+    friend ostream& operator<<(ostream& ostr, const TDynamicVector& v)
+    {
+        utmatrix_detail::writeText(ostr, v.pMem, 1, v.sz, v.sz, false);
+        return ostr;
+    }
+};
+
+// Параметры блочного умножения матриц (GEMM)
+struct TGemmConfig
+{
+    size_t mc = 96;                // строк A в упакованном блоке (L2)
+    size_t kc = 256;               // общая глубина блоков A и B (L1)
+    size_t nc = 4096;              // столбцов B в упакованном блоке (L3)
+    size_t minWork = 48 * 48 * 48; // при меньшем m*n*k упаковка не окупается
+    size_t minParallelWork = 128 * 128 * 128; // при меньшем m*n*k умножение идёт в одном потоке
+    size_t strassenCutoff = 0;     // 0 — operator* не использует алгоритм Штрассена–Винограда
+};
+
+inline TGemmConfig& gemmConfig() noexcept
+{
+    static TGemmConfig config;
+    return config;
+}
+
+namespace utmatrix_detail {
+
+// Выровненный рабочий буфер, растущий только при нехватке места
+template<typename T>
+class TAlignedBuffer
+{
+    T* pMem = nullptr;
+    size_t cap = 0;
+
+public:
+    TAlignedBuffer() = default;
+    TAlignedBuffer(const TAlignedBuffer&) = delete;
+    TAlignedBuffer& operator=(const TAlignedBuffer&) = delete;
+    ~TAlignedBuffer() { ::operator delete(pMem, std::align_val_t(MEM_ALIGNMENT)); }
+
+    T* reserve(size_t n)
+    {
+        if (n > cap) {
+            T* p = static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(MEM_ALIGNMENT)));
+            ::operator delete(pMem, std::align_val_t(MEM_ALIGNMENT));
+            pMem = p;
+            cap = n;
+        }
+        return pMem;
+    }
+};
+
+// Размер регистрового блока микроядра: MR строк на NR столбцов
+template<typename T>
+struct TGemmShape
+{
+    static const size_t MR = 4;
+    static const size_t NR = (sizeof(T) >= 8) ? 4 : 8; // 4x4 double / 4x8 float умещаются в 16 регистрах SSE
+};
+
+// Упаковка блока A (mb x kb) в полосы по MR строк, недостающие строки дополняются нулями
+template<typename T, size_t MR>
+void gemmPackA(size_t mb, size_t kb, const T* a, ptrdiff_t rs, ptrdiff_t cs, T* buf)
+{
+    for (size_t ir = 0; ir < mb; ir += MR) {
+        size_t m = std::min(MR, mb - ir);
+        for (size_t p = 0; p < kb; p++) {
+            const T* src = a + ptrdiff_t(ir) * rs + ptrdiff_t(p) * cs;
+            size_t i = 0;
+            for (; i < m; i++) buf[i] = src[ptrdiff_t(i) * rs];
+            for (; i < MR; i++) buf[i] = T();
+            buf += MR;
+        }
+    }
+}
+
+// Упаковка блока B (kb x nb) в полосы по NR столбцов
+template<typename T, size_t NR>
+void gemmPackB(size_t kb, size_t nb, const T* b, ptrdiff_t rs, ptrdiff_t cs, T* buf)
+{
+    for (size_t jr = 0; jr < nb; jr += NR) {
+        size_t n = std::min(NR, nb - jr);
+        for (size_t p = 0; p < kb; p++) {
+            const T* src = b + ptrdiff_t(p) * rs + ptrdiff_t(jr) * cs;
+            size_t j = 0;
+            if (cs == 1)
+                for (; j < n; j++) buf[j] = src[j];
+            else
+                for (; j < n; j++) buf[j] = src[ptrdiff_t(j) * cs];
+            for (; j < NR; j++) buf[j] = T();
+            buf += NR;
+        }
+    }
+}
+
+// Микроядро: блок MR x NR накапливается в регистрах по упакованным полосам A и B,
+// затем C = alpha * AB + beta * C (при beta == 0 старое содержимое C не читается)
+template<typename T, size_t MR, size_t NR>
+void gemmMicroKernel(size_t kb, const T* a, const T* b, T alpha, T beta, T* c, size_t ldc, size_t m, size_t n)
+{
+    T acc[MR][NR] = {};
+    for (size_t p = 0; p < kb; p++) {
+        for (size_t i = 0; i < MR; i++) {
+            const T ai = a[i];
+            for (size_t j = 0; j < NR; j++)
+                acc[i][j] += ai * b[j];
+        }
+        a += MR;
+        b += NR;
+    }
+    for (size_t i = 0; i < m; i++) {
+        T* ci = c + i * ldc;
+        if (beta == T())
+            for (size_t j = 0; j < n; j++) ci[j] = alpha * acc[i][j];
+        else
+            for (size_t j = 0; j < n; j++) ci[j] = alpha * acc[i][j] + beta * ci[j];
+    }
+}
+
+// Простой цикл в порядке i-k-j для малых задач и типов без упаковки
+template<typename T>
+void gemmSimple(size_t m, size_t n, size_t k, T alpha,
+                const T* a, ptrdiff_t rsa, ptrdiff_t csa,
+                const T* b, ptrdiff_t rsb, ptrdiff_t csb,
+                T beta, T* c, size_t ldc)
+{
+    for (size_t i = 0; i < m; i++) {
+        T* ci = c + i * ldc;
+        for (size_t j = 0; j < n; j++)
+            ci[j] = (beta == T()) ? T() : beta * ci[j];
+        for (size_t p = 0; p < k; p++) {
+            const T aip = alpha * a[ptrdiff_t(i) * rsa + ptrdiff_t(p) * csa];
+            const T* bp = b + ptrdiff_t(p) * rsb;
+            for (size_t j = 0; j < n; j++)
+                ci[j] += aip * bp[ptrdiff_t(j) * csb];
+        }
+    }
+}
+
+// Буферы упаковки объявлены в функции, а не в лямбде gemmBlocked: поток,
+// который первым обратился к thread_local, регистрирует и его деструктор
+template<typename T>
+T* packBufferA(size_t count)
+{
+    static thread_local TAlignedBuffer<T> buf;
+    return buf.reserve(count);
+}
+
+template<typename T>
+T* packBufferB(size_t count)
+{
+    static thread_local TAlignedBuffer<T> buf;
+    return buf.reserve(count);
+}
+
+template<typename T>
+void gemmBlocked(size_t m, size_t n, size_t k, T alpha,
+                 const T* a, ptrdiff_t rsa, ptrdiff_t csa,
+                 const T* b, ptrdiff_t rsb, ptrdiff_t csb,
+                 T beta, T* c, size_t ldc)
+{
+    const size_t MR = TGemmShape<T>::MR;
+    const size_t NR = TGemmShape<T>::NR;
+    const TGemmConfig& cfg = gemmConfig();
+    size_t mc = std::max(MR, cfg.mc / MR * MR);
+    const size_t nc = std::max(NR, cfg.nc / NR * NR);
+    const size_t kc = std::max<size_t>(1, cfg.kc);
+
+    // Потоки делят между собой блоки строк C; если блоков меньше, чем потоков,
+    // высота блока уменьшается, чтобы работы хватило всем
+    TThreadPool& pool = TThreadPool::instance();
+    const size_t threads = (m * n * k >= cfg.minParallelWork) ? pool.threadCount() : 1;
+    if (threads > 1 && (m + mc - 1) / mc < threads)
+        mc = std::max(MR, ((m + threads - 1) / threads + MR - 1) / MR * MR);
+    const size_t blocks = (m + mc - 1) / mc;
+
+    T* packB = packBufferB<T>(nc * kc);
+
+    for (size_t jc = 0; jc < n; jc += nc) {
+        const size_t nb = std::min(nc, n - jc);
+        for (size_t pc = 0; pc < k; pc += kc) {
+            const size_t kb = std::min(kc, k - pc);
+            const T betaBlock = (pc == 0) ? beta : T(1);
+            gemmPackB<T, NR>(kb, nb, b + ptrdiff_t(pc) * rsb + ptrdiff_t(jc) * csb, rsb, csb, packB);
+            auto rowBlocks = [&](size_t first, size_t last) {
+                T* packA = packBufferA<T>(mc * kc); // у каждого потока свой буфер
+                for (size_t blk = first; blk < last; blk++) {
+                    const size_t ic = blk * mc;
+                    const size_t mb = std::min(mc, m - ic);
+                    gemmPackA<T, MR>(mb, kb, a + ptrdiff_t(ic) * rsa + ptrdiff_t(pc) * csa, rsa, csa, packA);
+                    for (size_t jr = 0; jr < nb; jr += NR) {
+                        for (size_t ir = 0; ir < mb; ir += MR) {
+                            gemmMicroKernel<T, MR, NR>(kb, packA + ir * kb, packB + jr * kb, alpha, betaBlock,
+                                c + (ic + ir) * ldc + jc + jr, ldc, std::min(MR, mb - ir), std::min(NR, nb - jr));
+                        }
+                    }
+                }
+            };
+            if (threads > 1)
+                pool.parallelFor(0, blocks, 1, rowBlocks);
+            else
+                rowBlocks(0, blocks);
+        }
+    }
+}
+
+} // namespace utmatrix_detail
+
+// C = alpha * A * B + beta * C, где A — m x k, B — k x n, C — m x n (по строкам, шаг ldc).
+// Элементы A и B адресуются через шаги по строкам и столбцам, что позволяет
+// передавать транспонированные операнды без копирования.
+template<typename T>
+void gemm(size_t m, size_t n, size_t k, T alpha,
+          const T* a, ptrdiff_t rsa, ptrdiff_t csa,
+          const T* b, ptrdiff_t rsb, ptrdiff_t csb,
+          T beta, T* c, size_t ldc)
+{
+    if (m == 0 || n == 0) return;
+    if (k == 0 || !std::is_arithmetic<T>::value || m * n * k < gemmConfig().minWork) {
+        utmatrix_detail::gemmSimple(m, n, k, alpha, a, rsa, csa, b, rsb, csb, beta, c, ldc);
+        return;
+    }
+    utmatrix_detail::gemmBlocked(m, n, k, alpha, a, rsa, csa, b, rsb, csb, beta, c, ldc);
+}
+
+namespace utmatrix_detail {
+
+// C = A +- B для блоков m x n с шагами строк lda, ldb, ldc
+template<typename T, typename Op>
+void strassenAdd(size_t m, size_t n, const T* a, size_t lda, const T* b, size_t ldb, T* c, size_t ldc, Op op)
+{
+    TExprEval::forRows(m, n, [&](size_t rb, size_t re) {
+        for (size_t i = rb; i < re; i++)
+            TExprEval::binary(a + i * lda, b + i * ldb, c + i * ldc, n, op);
+    });
+}
+
+// Длина рабочей области для произведения m x k на k x n: три временных блока
+// на уровень, каждый выровнен по MEM_ALIGNMENT; уровни вызываются по очереди
+// и переиспользуют одну и ту же память
+template<typename T>
+size_t strassenWorkspace(size_t m, size_t n, size_t k, size_t cutoff)
+{
+    const size_t align = std::max<size_t>(1, MEM_ALIGNMENT / sizeof(T));
+    size_t total = 0;
+    while (std::min({ m, n, k }) > cutoff && std::min({ m, n, k }) >= 2) {
+        m /= 2; n /= 2; k /= 2;
+        for (size_t s : { m * k, k * n, m * n })
+            total += (s + align - 1) / align * align;
+    }
+    return total;
+}
+
+// Схема Винограда: 7 умножений и 15 сложений на уровень, порядок вычислений
+// подобран так, что кроме C нужны три временных блока X, Y, Z
+template<typename T>
+void strassenRecursive(size_t m, size_t n, size_t k,
+                       const T* a, size_t lda, const T* b, size_t ldb, T* c, size_t ldc,
+                       size_t cutoff, T* work)
+{
+    if (std::min({ m, n, k }) <= cutoff || std::min({ m, n, k }) < 2) {
+        gemm(m, n, k, T(1), a, ptrdiff_t(lda), ptrdiff_t(1), b, ptrdiff_t(ldb), ptrdiff_t(1), T(), c, ldc);
+        return;
+    }
+    // Нечётные размеры: ядро чётного размера по Винограду, крайние строка,
+    // столбец и слагаемое ранга 1 — обычным GEMM
+    const size_t me = m & ~size_t(1), ne = n & ~size_t(1), ke = k & ~size_t(1);
+    const size_t m2 = me / 2, n2 = ne / 2, k2 = ke / 2;
+
+    const size_t align = std::max<size_t>(1, MEM_ALIGNMENT / sizeof(T));
+    auto rounded = [align](size_t s) { return (s + align - 1) / align * align; };
+    T* x = work;
+    T* y = x + rounded(m2 * k2);
+    T* z = y + rounded(k2 * n2);
+    T* next = z + rounded(m2 * n2);
+
+    const T* a11 = a;
+    const T* a12 = a + k2;
+    const T* a21 = a + m2 * lda;
+    const T* a22 = a21 + k2;
+    const T* b11 = b;
+    const T* b12 = b + n2;
+    const T* b21 = b + k2 * ldb;
+    const T* b22 = b21 + n2;
+    T* c11 = c;
+    T* c12 = c + n2;
+    T* c21 = c + m2 * ldc;
+    T* c22 = c21 + n2;
+    auto mul = [&](const T* l, size_t ldl, const T* r, size_t ldr, T* dst, size_t ldd) {
+        strassenRecursive(m2, n2, k2, l, ldl, r, ldr, dst, ldd, cutoff, next);
+    };
+
+    strassenAdd(m2, k2, a11, lda, a21, lda, x, k2, TSubOp());   // S3 = A11 - A21
+    strassenAdd(k2, n2, b22, ldb, b12, ldb, y, n2, TSubOp());   // T3 = B22 - B12
+    mul(x, k2, y, n2, c21, ldc);                                // P7 = S3 T3
+    strassenAdd(m2, k2, a21, lda, a22, lda, x, k2, TAddOp());   // S1 = A21 + A22
+    strassenAdd(k2, n2, b12, ldb, b11, ldb, y, n2, TSubOp());   // T1 = B12 - B11
+    mul(x, k2, y, n2, c22, ldc);                                // P5 = S1 T1
+    strassenAdd(m2, k2, x, k2, a11, lda, x, k2, TSubOp());      // S2 = S1 - A11
+    strassenAdd(k2, n2, b22, ldb, y, n2, y, n2, TSubOp());      // T2 = B22 - T1
+    mul(x, k2, y, n2, c12, ldc);                                // P6 = S2 T2
+    strassenAdd(m2, k2, a12, lda, x, k2, x, k2, TSubOp());      // S4 = A12 - S2
+    mul(x, k2, b22, ldb, c11, ldc);                             // P3 = S4 B22
+    mul(a11, lda, b11, ldb, z, n2);                             // P1 = A11 B11
+    strassenAdd(m2, n2, z, n2, c12, ldc, c12, ldc, TAddOp());   // U2 = P1 + P6
+    strassenAdd(m2, n2, c12, ldc, c21, ldc, c21, ldc, TAddOp()); // U3 = U2 + P7
+    strassenAdd(m2, n2, c12, ldc, c22, ldc, c12, ldc, TAddOp()); // U4 = U2 + P5
+    strassenAdd(m2, n2, c21, ldc, c22, ldc, c22, ldc, TAddOp()); // C22 = U3 + P5
+    strassenAdd(m2, n2, c12, ldc, c11, ldc, c12, ldc, TAddOp()); // C12 = U4 + P3
+    strassenAdd(k2, n2, y, n2, b21, ldb, y, n2, TSubOp());      // T4 = T2 - B21
+    mul(a22, lda, y, n2, c11, ldc);                             // P4 = A22 T4
+    strassenAdd(m2, n2, c21, ldc, c11, ldc, c21, ldc, TSubOp()); // C21 = U3 - P4
+    mul(a12, lda, b21, ldb, c11, ldc);                          // P2 = A12 B21
+    strassenAdd(m2, n2, c11, ldc, z, n2, c11, ldc, TAddOp());   // C11 = P1 + P2
+
+    if (ke != k)
+        gemm(me, ne, size_t(1), T(1), a + ke, ptrdiff_t(lda), ptrdiff_t(1),
+             b + ke * ldb, ptrdiff_t(ldb), ptrdiff_t(1), T(1), c, ldc);
+    if (ne != n)
+        gemm(me, size_t(1), k, T(1), a, ptrdiff_t(lda), ptrdiff_t(1),
+             b + ne, ptrdiff_t(ldb), ptrdiff_t(1), T(), c + ne, ldc);
+    if (me != m)
+        gemm(size_t(1), n, k, T(1), a + me * lda, ptrdiff_t(lda), ptrdiff_t(1),
+             b, ptrdiff_t(ldb), ptrdiff_t(1), T(), c + me * ldc, ldc);
+}
+
+} // namespace utmatrix_detail
+
+// C = A * B алгоритмом Штрассена–Винограда: O(n^2.81) умножений вместо O(n^3).
+// Рекурсия продолжается, пока наименьший из размеров больше cutoff, ниже работает
+// блочный GEMM. Рабочая область выделяется один раз на поток и переиспользуется
+// всеми уровнями и последующими вызовами. Погрешность растёт с глубиной рекурсии
+// быстрее, чем у классического алгоритма, поэтому путь включается явно.
+template<typename T>
+void gemmStrassen(size_t m, size_t n, size_t k,
+                  const T* a, size_t lda, const T* b, size_t ldb, T* c, size_t ldc,
+                  size_t cutoff = gemmConfig().strassenCutoff)
+{
+    if (m == 0 || n == 0) return;
+    if (!std::is_arithmetic<T>::value || cutoff == 0 || std::min({ m, n, k }) <= cutoff) {
+        gemm(m, n, k, T(1), a, ptrdiff_t(lda), ptrdiff_t(1), b, ptrdiff_t(ldb), ptrdiff_t(1), T(), c, ldc);
+        return;
+    }
+    static thread_local utmatrix_detail::TAlignedBuffer<T> workspace;
+    T* work = workspace.reserve(utmatrix_detail::strassenWorkspace<T>(m, n, k, cutoff));
+    utmatrix_detail::strassenRecursive(m, n, k, a, lda, b, ldb, c, ldc, cutoff, work);
+}
+
+// y = A x, где A — m x n по строкам с шагом lda. Строки обрабатываются четвёрками:
+// x читается из кэша один раз на четыре строки, у каждой строки по два векторных
+// аккумулятора, так что сложения не ждут друг друга. Блоки строк делятся между
+// потоками; на больших матрицах скорость ограничена пропускной способностью памяти.
+template<typename T>
+void gemv(size_t m, size_t n, const T* a, size_t lda, const T* x, T* y)
+{
+    const TSimdKernels<T>* k = simdKernels<T>();
+    const auto dotRows4 = k ? k->dotRows4 : &utmatrix_detail::TScalarKernels<T>::dotRows4;
+    const auto dot = k ? k->dot : &utmatrix_detail::TScalarKernels<T>::dot;
+    utmatrix_detail::TExprEval::forRows(m, n, [&](size_t rb, size_t re) {
+        size_t i = rb;
+        for (; i + 4 <= re; i += 4)
+            dotRows4(a + i * lda, lda, x, y + i, n);
+        for (; i < re; i++)
+            y[i] = dot(a + i * lda, x, n);
+    });
+}
+
+// y = A^T x, где A — m x n по строкам с шагом lda, x — m элементов, y — n.
+// A читается по строкам: к отрезку y прибавляются сразу четыре строки, взвешенные
+// элементами x. Широкая матрица делится между потоками по отрезкам столбцов,
+// узкая — по строкам с частичными суммами потоков.
+template<typename T>
+void gemvTransposed(size_t m, size_t n, const T* a, size_t lda, const T* x, T* y)
+{
+    const TSimdKernels<T>* k = simdKernels<T>();
+    const auto axpyRows4 = k ? k->axpyRows4 : &utmatrix_detail::TScalarKernels<T>::axpyRows4;
+    const auto axpy = k ? k->axpy : &utmatrix_detail::TScalarKernels<T>::axpy;
+    // y[cb, ce) += сумма по строкам [rb, re) от x[i] * A[i][cb, ce)
+    auto accumulate = [&](size_t rb, size_t re, size_t cb, size_t ce, T* ys) {
+        size_t i = rb;
+        for (; i + 4 <= re; i += 4)
+            axpyRows4(x + i, a + i * lda + cb, lda, ys, ce - cb);
+        for (; i < re; i++)
+            axpy(x[i], a + i * lda + cb, ys, ce - cb);
+    };
+    TThreadPool& pool = TThreadPool::instance();
+    const size_t colBlock = 2048; // отрезок y остаётся в L1/L2, пока через него проходят строки
+    const size_t colBlocks = (n + colBlock - 1) / colBlock;
+    const size_t threads = pool.threadCount();
+    const size_t minWork = 1 << 15;
+    std::fill_n(y, n, T());
+    if (threads == 1 || colBlocks >= threads || m * n < minWork * threads) {
+        pool.parallelFor(0, colBlocks, 1, [&](size_t bb, size_t be) {
+            for (size_t b = bb; b < be; b++) {
+                const size_t cb = b * colBlock, ce = std::min(n, cb + colBlock);
+                accumulate(0, m, cb, ce, y + cb);
+            }
+        });
+        return;
+    }
+    std::vector<T> partial(threads * n, T());
+    const size_t rowsPerPart = (m + threads - 1) / threads;
+    pool.parallelFor(0, threads, 1, [&](size_t pb, size_t pe) {
+        for (size_t p = pb; p < pe; p++) {
+            const size_t rb = std::min(m, p * rowsPerPart), re = std::min(m, rb + rowsPerPart);
+            for (size_t cb = 0; cb < n; cb += colBlock)
+                accumulate(rb, re, cb, std::min(n, cb + colBlock), partial.data() + p * n + cb);
+        }
+    });
+    for (size_t p = 0; p < threads; p++)
+        utmatrix_detail::TExprEval::binary(y, partial.data() + p * n, y, n, TAddOp());
+}
+
+namespace utmatrix_detail {
+
+#ifdef UTMATRIX_X86
+// Транспонирование блока 4 x 4 в регистрах: b[j][i] = a[i][j]. Элементы копируются
+// побитно, поэтому ядро по размеру элемента подходит любому тривиально копируемому типу.
+UTMATRIX_TARGET("sse2") inline void transpose4x4(const float* a, size_t lda, float* b, size_t ldb)
+{
+    __m128 r0 = _mm_loadu_ps(a), r1 = _mm_loadu_ps(a + lda), r2 = _mm_loadu_ps(a + 2 * lda), r3 = _mm_loadu_ps(a + 3 * lda);
+    const __m128 t0 = _mm_unpacklo_ps(r0, r1), t1 = _mm_unpacklo_ps(r2, r3);
+    const __m128 t2 = _mm_unpackhi_ps(r0, r1), t3 = _mm_unpackhi_ps(r2, r3);
+    _mm_storeu_ps(b, _mm_movelh_ps(t0, t1));
+    _mm_storeu_ps(b + ldb, _mm_movehl_ps(t1, t0));
+    _mm_storeu_ps(b + 2 * ldb, _mm_movelh_ps(t2, t3));
+    _mm_storeu_ps(b + 3 * ldb, _mm_movehl_ps(t3, t2));
+}
+
+UTMATRIX_TARGET("avx2") inline void transpose4x4(const double* a, size_t lda, double* b, size_t ldb)
+{
+    const __m256d r0 = _mm256_loadu_pd(a), r1 = _mm256_loadu_pd(a + lda);
+    const __m256d r2 = _mm256_loadu_pd(a + 2 * lda), r3 = _mm256_loadu_pd(a + 3 * lda);
+    const __m256d t0 = _mm256_unpacklo_pd(r0, r1), t1 = _mm256_unpackhi_pd(r0, r1);
+    const __m256d t2 = _mm256_unpacklo_pd(r2, r3), t3 = _mm256_unpackhi_pd(r2, r3);
+    _mm256_storeu_pd(b, _mm256_permute2f128_pd(t0, t2, 0x20));
+    _mm256_storeu_pd(b + ldb, _mm256_permute2f128_pd(t1, t3, 0x20));
+    _mm256_storeu_pd(b + 2 * ldb, _mm256_permute2f128_pd(t0, t2, 0x31));
+    _mm256_storeu_pd(b + 3 * ldb, _mm256_permute2f128_pd(t1, t3, 0x31));
+}
+#endif
+
+// Регистровое ядро для элементов типа T: 0 — нет, иначе его тип-носитель
+template<typename T>
+struct TTransposeCarrier
+{
+#ifdef UTMATRIX_X86
+    static const bool trivial = std::is_trivially_copyable<T>::value;
+    typedef typename std::conditional<trivial && sizeof(T) == 4 && alignof(T) <= 4, float,
+        typename std::conditional<trivial && sizeof(T) == 8 && alignof(T) <= 8, double, void>::type>::type type;
+#else
+    typedef void type;
+#endif
+};
+
+// Лист рекурсии: блоки 4 x 4 в регистрах, края — поэлементно
+template<typename T>
+void transposeLeaf(size_t m, size_t n, const T* a, size_t lda, T* b, size_t ldb, bool simd)
+{
+    typedef typename TTransposeCarrier<T>::type C;
+    size_t i = 0;
+    if constexpr (!std::is_void<C>::value) {
+        if (simd)
+            for (; i + 4 <= m; i += 4) {
+                size_t j = 0;
+                for (; j + 4 <= n; j += 4)
+                    transpose4x4(reinterpret_cast<const C*>(a + i * lda + j), lda, reinterpret_cast<C*>(b + j * ldb + i), ldb);
+                for (; j < n; j++)
+                    for (size_t q = i; q < i + 4; q++)
+                        b[j * ldb + q] = a[q * lda + j];
+            }
+    }
+    for (; i < m; i++)
+        for (size_t j = 0; j < n; j++)
+            b[j * ldb + i] = a[i * lda + j];
+}
+
+// Кэш-независимая рекурсия: делится большая сторона, пока блок не поместится
+// в L1 вместе с результатом; границы деления кратны 4 ради регистровых блоков
+template<typename T>
+void transposeRecursive(size_t m, size_t n, const T* a, size_t lda, T* b, size_t ldb, bool simd)
+{
+    const size_t leaf = 32;
+    if (m <= leaf && n <= leaf) {
+        transposeLeaf(m, n, a, lda, b, ldb, simd);
+        return;
+    }
+    if (m >= n) {
+        const size_t h = (m / 2 + 3) & ~size_t(3);
+        transposeRecursive(h, n, a, lda, b, ldb, simd);
+        transposeRecursive(m - h, n, a + h * lda, lda, b + h, ldb, simd);
+    }
+    else {
+        const size_t h = (n / 2 + 3) & ~size_t(3);
+        transposeRecursive(m, h, a, lda, b, ldb, simd);
+        transposeRecursive(m, n - h, a + h, lda, b + h * ldb, ldb, simd);
+    }
+}
+
+template<typename T>
+bool transposeSimd() noexcept
+{
+    typedef typename TTransposeCarrier<T>::type C;
+    if (std::is_same<C, float>::value) return simdLevel() >= TSimdLevel::SSE2;
+    if (std::is_same<C, double>::value) return simdLevel() >= TSimdLevel::AVX2;
+    return false;
+}
+
+} // namespace utmatrix_detail
+
+// B = A^T, где A — m x n по строкам с шагом lda, B — n x m с шагом ldb; A и B
+// не перекрываются. Полосы столбцов A делятся между потоками, внутри полосы —
+// кэш-независимая рекурсия с регистровыми блоками 4 x 4 в листьях.
+template<typename T>
+void transpose(size_t m, size_t n, const T* a, size_t lda, T* b, size_t ldb)
+{
+    const bool simd = utmatrix_detail::transposeSimd<T>();
+    const size_t strip = 256;
+    const size_t grain = std::max<size_t>(1, (size_t(1) << 16) / std::max<size_t>(1, m * strip));
+    TThreadPool::instance().parallelFor(0, (n + strip - 1) / strip, grain, [&](size_t sb, size_t se) {
+        for (size_t s = sb; s < se; s++) {
+            const size_t cb = s * strip, ce = std::min(n, cb + strip);
+            utmatrix_detail::transposeRecursive(m, ce - cb, a + cb, lda, b + cb * ldb, ldb, simd);
+        }
+    });
+}
+
+// Транспонирование квадратной матрицы n x n на месте: диагональные блоки
+// транспонируются внутри себя, симметричные внедиагональные — попарно через
+// буфер одного блока в стеке
+template<typename T>
+void transposeInPlace(size_t n, T* a, size_t lda)
+{
+    const bool simd = utmatrix_detail::transposeSimd<T>();
+    const size_t nb = 32;
+    const size_t blocks = (n + nb - 1) / nb;
+    TThreadPool::instance().parallelFor(0, blocks, 1, [&](size_t bb, size_t be) {
+        T tmp[nb * nb];
+        for (size_t bi = bb; bi < be; bi++) {
+            const size_t i0 = bi * nb, hi = std::min(nb, n - i0);
+            for (size_t i = 0; i < hi; i++)
+                for (size_t j = i + 1; j < hi; j++)
+                    std::swap(a[(i0 + i) * lda + i0 + j], a[(i0 + j) * lda + i0 + i]);
+            for (size_t bj = bi + 1; bj < blocks; bj++) {
+                const size_t j0 = bj * nb, wj = std::min(nb, n - j0);
+                T* upper = a + i0 * lda + j0; // hi x wj
+                T* lower = a + j0 * lda + i0; // wj x hi
+                utmatrix_detail::transposeLeaf(hi, wj, upper, lda, tmp, nb, simd);
+                utmatrix_detail::transposeLeaf(wj, hi, lower, lda, upper, lda, simd);
+                for (size_t r = 0; r < wj; r++)
+                    std::copy_n(tmp + r * nb, hi, lower + r * lda);
+            }
+        }
+    });
+}
+
+// Транспонирование непрерывной матрицы m x n на месте следованием по циклам
+// перестановки: элемент с индексом k переходит в k * m mod (mn - 1). Посещённые
+// позиции отмечаются битами (mn бит дополнительной памяти); доступ к памяти
+// произвольный, поэтому для квадратных матриц используется transposeInPlace.
+template<typename T>
+void transposeInPlace(size_t m, size_t n, T* a)
+{
+    if (m == n) {
+        transposeInPlace(n, a, n);
+        return;
+    }
+    const size_t total = utmatrix_detail::checkedMul(m, n);
+    if (total < 3) return;
+    const size_t last = total - 1;
+    std::vector<bool> visited(total, false);
+    for (size_t start = 1; start < last; start++) {
+        if (visited[start]) continue;
+        size_t k = start;
+        T carried = a[k];
+        do {
+            // элемент, стоящий в k, переходит в позицию k * m mod (mn - 1)
+            const size_t next = size_t(utmatrix_detail::mulMod(k, m, last));
+            std::swap(carried, a[next]);
+            visited[next] = true;
+            k = next;
+        } while (k != start);
+    }
+}
+
+namespace utmatrix_detail {
+
+// C = A * B для плотных операндов: GEMM или, если задан порог, Штрассен–Виноград
+template<typename T>
+void denseProduct(size_t m, size_t n, size_t k, const T* a, size_t lda, const T* b, size_t ldb, T* c, size_t ldc)
+{
+    if (gemmConfig().strassenCutoff > 0)
+        gemmStrassen(m, n, k, a, lda, b, ldb, c, ldc);
+    else
+        gemm(m, n, k, T(1), a, ptrdiff_t(lda), ptrdiff_t(1), b, ptrdiff_t(ldb), ptrdiff_t(1), T(), c, ldc);
+}
+
+} // namespace utmatrix_detail
+
+// Строка матрицы: легковесное представление участка общего буфера
+template<typename T>
+class TMatrixRow
+{
+    T* pMem;
+    size_t sz;
+
+public:
+    typedef typename std::remove_const<T>::type value_type;
+
+    TMatrixRow(T* p, size_t size) noexcept : pMem(p), sz(size) {}
+    TMatrixRow(const TMatrixRow&) = default;
+
+    // Присваивание копирует элементы, а не перенаправляет представление
+    TMatrixRow& operator=(const TMatrixRow& r)
+    {
+        if (sz != r.sz) throw invalid_argument("Строки должны быть одного размера");
+        std::copy(r.pMem, r.pMem + sz, pMem);
+        return *this;
+    }
+
+    template<typename E, typename = typename std::enable_if<TIsVectorExpr<E>::value>::type>
+    TMatrixRow& operator=(const E& e)
+    {
+        if (sz != e.size()) throw invalid_argument("Строка и вектор должны быть одного размера");
+        utmatrix_detail::TExprEval::assign(pMem, e);
+        return *this;
+    }
+
+    template<typename E, typename = typename std::enable_if<TIsVectorExpr<E>::value>::type>
+    const TMatrixRow& operator+=(const E& e) const
+    {
+        if (sz != e.size()) throw invalid_argument("Строка и вектор должны быть одного размера");
+        utmatrix_detail::TExprEval::update(pMem, e, TAddOp());
+        return *this;
+    }
+
+    template<typename E, typename = typename std::enable_if<TIsVectorExpr<E>::value>::type>
+    const TMatrixRow& operator-=(const E& e) const
+    {
+        if (sz != e.size()) throw invalid_argument("Строка и вектор должны быть одного размера");
+        utmatrix_detail::TExprEval::update(pMem, e, TSubOp());
+        return *this;
+    }
+
+    const TMatrixRow& operator*=(const value_type& val) const
+    {
+        utmatrix_detail::TExprEval::updateScalar(pMem, sz, val, TMulOp());
+        return *this;
+    }
+
+    template<typename E, typename = typename std::enable_if<TIsVectorExpr<E>::value>::type>
+    const TMatrixRow& axpy(const value_type& alpha, const E& x) const
+    {
+        if (sz != x.size()) throw invalid_argument("Строка и вектор должны быть одного размера");
+        utmatrix_detail::TExprEval::axpy(pMem, alpha, x);
+        return *this;
+    }
+
+    size_t size() const noexcept { return sz; }
+    value_type eval(size_t ind) const { return pMem[ind]; }
+    T* data() const noexcept { return pMem; }
+    T* begin() const noexcept { return pMem; }
+    T* end() const noexcept { return pMem + sz; }
+
+    T& operator[](size_t ind) const {
+        if (ind >= sz) throw out_of_range("Индекс вне диапазона");
+        return pMem[ind];
+    }
+
+    T& at(size_t ind) const {
+        if (ind >= sz) throw out_of_range("Индекс вне диапазона");
+        return pMem[ind];
+    }
+
+    T& operator()(size_t ind) const noexcept {
+        assert(ind < sz && "Индекс вне диапазона");
+        return pMem[ind];
+    }
+
+    template<typename U>
+    bool operator==(const TMatrixRow<U>& r) const noexcept
+    {
+        if (sz != r.size()) return false;
+        return std::equal(pMem, pMem + sz, r.data());
+    }
+
+    template<typename U>
+    bool operator!=(const TMatrixRow<U>& r) const noexcept
+    {
+        return !(*this == r);
+    }
+
+    friend istream& operator>>(istream& istr, const TMatrixRow& r)
+    {
+        utmatrix_detail::readText(istr, r.pMem, r.sz);
+        return istr;
+    }
+
+    friend ostream& operator<<(ostream& ostr, const TMatrixRow& r)
+    {
+        utmatrix_detail::writeText(ostr, static_cast<const T*>(r.pMem), 1, r.sz, r.sz, false);
+        return ostr;
+    }
+};
+
+// Представление участка вектора или матрицы: size элементов с шагом stride
+// (столбец матрицы — представление с шагом строк). Не владеет памятью;
+// присваивание копирует элементы, а не перенаправляет представление.
+template<typename T>
+class TVectorView
+{
+    T* pMem;
+    size_t sz;
+    size_t step;
+
+    template<typename E, typename Op>
+    void update(const E& e, Op) const
+    {
+        if (sz != e.size()) throw invalid_argument("Представление и вектор должны быть одного размера");
+        if (step == 1) {
+            utmatrix_detail::TExprEval::update(pMem, e, Op());
+            return;
+        }
+        for (size_t i = 0; i < sz; i++)
+            pMem[i * step] = Op::apply(pMem[i * step], e.eval(i));
+    }
+
+public:
+    typedef typename std::remove_const<T>::type value_type;
+
+    TVectorView(T* p, size_t size, size_t stride = 1) noexcept : pMem(p), sz(size), step(stride) {}
+    TVectorView(const TVectorView&) = default;
+
+    // Изменяемое представление приводится к неизменяемому
+    template<typename U, typename = typename std::enable_if<std::is_same<const U, T>::value>::type>
+    TVectorView(const TVectorView<U>& v) noexcept : pMem(v.data()), sz(v.size()), step(v.stride()) {}
+
+    TVectorView& operator=(const TVectorView& v) { return assign(v); }
+
+    template<typename E, typename = typename std::enable_if<TIsVectorExpr<E>::value>::type>
+    TVectorView& operator=(const E& e) { return assign(e); }
+
+    template<typename E>
+    TVectorView& assign(const E& e)
+    {
+        if (sz != e.size()) throw invalid_argument("Представление и вектор должны быть одного размера");
+        if (step == 1)
+            utmatrix_detail::TExprEval::assign(pMem, e);
+        else
+            for (size_t i = 0; i < sz; i++)
+                pMem[i * step] = e.eval(i);
+        return *this;
+    }
+
+    template<typename E, typename = typename std::enable_if<TIsVectorExpr<E>::value>::type>
+    const TVectorView& operator+=(const E& e) const
+    {
+        update(e, TAddOp());
+        return *this;
+    }
+
+    template<typename E, typename = typename std::enable_if<TIsVectorExpr<E>::value>::type>
+    const TVectorView& operator-=(const E& e) const
+    {
+        update(e, TSubOp());
+        return *this;
+    }
+
+    const TVectorView& operator*=(const value_type& val) const
+    {
+        if (step == 1)
+            utmatrix_detail::TExprEval::updateScalar(pMem, sz, val, TMulOp());
+        else
+            for (size_t i = 0; i < sz; i++)
+                pMem[i * step] *= val;
+        return *this;
+    }
+
+    template<typename E, typename = typename std::enable_if<TIsVectorExpr<E>::value>::type>
+    const TVectorView& axpy(const value_type& alpha, const E& x) const
+    {
+        if (sz != x.size()) throw invalid_argument("Представление и вектор должны быть одного размера");
+        if (step == 1)
+            utmatrix_detail::TExprEval::axpy(pMem, alpha, x);
+        else
+            for (size_t i = 0; i < sz; i++)
+                pMem[i * step] += alpha * x.eval(i);
+        return *this;
+    }
+
+    size_t size() const noexcept { return sz; }
+    size_t stride() const noexcept { return step; }
+    T* data() const noexcept { return pMem; }
+    value_type eval(size_t ind) const { return pMem[ind * step]; }
+
+    T& operator[](size_t ind) const {
+        if (ind >= sz) throw out_of_range("Индекс вне диапазона");
+        return pMem[ind * step];
+    }
+
+    T& at(size_t ind) const {
+        if (ind >= sz) throw out_of_range("Индекс вне диапазона");
+        return pMem[ind * step];
+    }
+
+    T& operator()(size_t ind) const noexcept {
+        assert(ind < sz && "Индекс вне диапазона");
+        return pMem[ind * step];
+    }
+
+    // Элементы offset, offset + stride, ... этого представления
+    TVectorView view(size_t offset, size_t size, size_t stride = 1) const
+    {
+        if (size == 0 || stride == 0 || offset >= sz || (size - 1) > (sz - 1 - offset) / stride)
+            throw out_of_range("Представление выходит за границы вектора");
+        return TVectorView(pMem + offset * step, size, stride * step);
+    }
+
+    template<typename E, typename = typename std::enable_if<TIsVectorExpr<E>::value>::type>
+    bool operator==(const E& e) const
+    {
+        if (sz != e.size()) return false;
+        for (size_t i = 0; i < sz; i++)
+            if (!(pMem[i * step] == e.eval(i))) return false;
+        return true;
+    }
+
+    template<typename E, typename = typename std::enable_if<TIsVectorExpr<E>::value>::type>
+    bool operator!=(const E& e) const
+    {
+        return !(*this == e);
+    }
+
+    friend istream& operator>>(istream& istr, const TVectorView& v)
+    {
+        if (v.step == 1) {
+            utmatrix_detail::readText(istr, v.pMem, v.sz);
+            return istr;
+        }
+        TDynamicVector<value_type> tmp(v.sz, uninitialized);
+        utmatrix_detail::readText(istr, tmp.data(), v.sz);
+        for (size_t i = 0; i < v.sz; i++)
+            v.pMem[i * v.step] = tmp(i);
+        return istr;
+    }
+
+    // Элемент i — «строка» из одного числа с шагом stride
+    friend ostream& operator<<(ostream& ostr, const TVectorView& v)
+    {
+        utmatrix_detail::writeText(ostr, static_cast<const T*>(v.pMem), v.sz, 1, v.step, false);
+        return ostr;
+    }
+};
+
+// Представление прямоугольного блока плотной матрицы: rows x cols элементов,
+// строки с шагом stride. Не владеет памятью и подходит везде, где нужна плотная
+// матрица: в выражениях, GEMM/GEMV и вводе-выводе. Присваивание копирует
+// элементы; области источника и приёмника не должны частично перекрываться.
+template<typename T>
+class TMatrixView
+{
+    T* pMem;
+    size_t nRows, nCols, ld;
+
+    template<typename E>
+    void checkSize(const E& e) const
+    {
+        if (e.rows() != nRows || e.cols() != nCols) throw invalid_argument("Матрицы должны быть одного размера");
+    }
+
+public:
+    typedef typename std::remove_const<T>::type value_type;
+
+    TMatrixView(T* p, size_t r, size_t c, size_t stride) noexcept : pMem(p), nRows(r), nCols(c), ld(stride) {}
+    TMatrixView(const TMatrixView&) = default;
+
+    template<typename U, typename = typename std::enable_if<std::is_same<const U, T>::value>::type>
+    TMatrixView(const TMatrixView<U>& m) noexcept : pMem(m.data()), nRows(m.rows()), nCols(m.cols()), ld(m.stride()) {}
+
+    TMatrixView& operator=(const TMatrixView& m) { return assign(m); }
+
+    template<typename E, typename = typename std::enable_if<TIsMatrixExpr<E>::value>::type>
+    TMatrixView& operator=(const E& e) { return assign(e); }
+
+    template<typename E>
+    TMatrixView& assign(const E& e)
+    {
+        checkSize(e);
+        utmatrix_detail::TExprEval::assignMatrix(pMem, ld, e);
+        return *this;
+    }
+
+    template<typename E, typename = typename std::enable_if<TIsMatrixExpr<E>::value>::type>
+    const TMatrixView& operator+=(const E& e) const
+    {
+        checkSize(e);
+        utmatrix_detail::TExprEval::updateMatrix(pMem, ld, e, TAddOp());
+        return *this;
+    }
+
+    template<typename E, typename = typename std::enable_if<TIsMatrixExpr<E>::value>::type>
+    const TMatrixView& operator-=(const E& e) const
+    {
+        checkSize(e);
+        utmatrix_detail::TExprEval::updateMatrix(pMem, ld, e, TSubOp());
+        return *this;
+    }
+
+    const TMatrixView& operator*=(const value_type& val) const
+    {
+        utmatrix_detail::TExprEval::updateMatrixScalar(pMem, ld, nRows, nCols, val, TMulOp());
+        return *this;
+    }
+
+    template<typename E, typename = typename std::enable_if<TIsMatrixExpr<E>::value>::type>
+    const TMatrixView& axpy(const value_type& alpha, const E& x) const
+    {
+        checkSize(x);
+        utmatrix_detail::TExprEval::axpyMatrix(pMem, ld, alpha, x);
+        return *this;
+    }
+
+    size_t rows() const noexcept { return nRows; }
+    size_t cols() const noexcept { return nCols; }
+    size_t stride() const noexcept { return ld; }
+    T* data() const noexcept { return pMem; }
+    value_type eval(size_t i, size_t j) const { return pMem[i * ld + j]; }
+
+    T& operator()(size_t i, size_t j) const noexcept {
+        assert(i < nRows && j < nCols && "Индекс вне диапазона");
+        return pMem[i * ld + j];
+    }
+
+    T& at(size_t i, size_t j) const {
+        if (i >= nRows || j >= nCols) throw out_of_range("Индекс вне диапазона");
+        return pMem[i * ld + j];
+    }
+
+    TMatrixRow<T> operator[](size_t index) const {
+        if (index >= nRows) throw out_of_range("Индекс вне диапазона");
+        return TMatrixRow<T>(pMem + index * ld, nCols);
+    }
+
+    // Блок r x c с левым верхним углом (i, j)
+    TMatrixView block(size_t i, size_t j, size_t r, size_t c) const
+    {
+        if (r == 0 || c == 0 || i >= nRows || j >= nCols || r > nRows - i || c > nCols - j)
+            throw out_of_range("Блок выходит за границы матрицы");
+        return TMatrixView(pMem + i * ld + j, r, c, ld);
+    }
+
+    TVectorView<T> row(size_t i) const {
+        if (i >= nRows) throw out_of_range("Индекс вне диапазона");
+        return TVectorView<T>(pMem + i * ld, nCols, 1);
+    }
+
+    TVectorView<T> col(size_t j) const {
+        if (j >= nCols) throw out_of_range("Индекс вне диапазона");
+        return TVectorView<T>(pMem + j, nRows, ld);
+    }
+
+    template<typename A>
+    TDynamicVector<value_type> multiply(const TDynamicVector<value_type, A>& v) const
+    {
+        if (nCols != v.size()) throw invalid_argument("Число столбцов матрицы должно совпадать с размером вектора");
+        TDynamicVector<value_type> res(nRows, uninitialized);
+        gemv(nRows, nCols, static_cast<const value_type*>(pMem), ld, v.data(), res.data());
+        return res;
+    }
+
+    TDynamicMatrix<value_type> transposed() const
+    {
+        TDynamicMatrix<value_type> res(nCols, nRows, uninitialized);
+        ::transpose(nRows, nCols, static_cast<const value_type*>(pMem), ld, res.data(), res.stride());
+        return res;
+    }
+
+    // На месте можно транспонировать только квадратный блок
+    const TMatrixView& transpose() const
+    {
+        if (nRows != nCols) throw invalid_argument("Матрица должна быть квадратной");
+        transposeInPlace(nRows, pMem, ld);
+        return *this;
+    }
+
+    template<typename A>
+    TDynamicVector<value_type> multiplyTransposed(const TDynamicVector<value_type, A>& v) const
+    {
+        if (nRows != v.size()) throw invalid_argument("Число строк матрицы должно совпадать с размером вектора");
+        TDynamicVector<value_type> res(nCols, uninitialized);
+        gemvTransposed(nRows, nCols, static_cast<const value_type*>(pMem), ld, v.data(), res.data());
+        return res;
+    }
+
+    template<typename M, typename = typename std::enable_if<TIsDenseMatrix<M>::value>::type>
+    TDynamicMatrix<value_type> multiply(const M& m) const
+    {
+        if (nCols != m.rows()) throw invalid_argument("Число столбцов первой матрицы должно совпадать с количеством строк второй матрицы");
+        TDynamicMatrix<value_type> res(nRows, m.cols(), uninitialized);
+        utmatrix_detail::denseProduct(nRows, m.cols(), nCols, static_cast<const value_type*>(pMem), ld,
+                                      m.data(), m.stride(), res.data(), res.stride());
+        return res;
+    }
+
+    friend istream& operator>>(istream& istr, const TMatrixView& m)
+    {
+        if (m.ld == m.nCols) {
+            utmatrix_detail::readText(istr, m.pMem, m.nRows * m.nCols);
+            return istr;
+        }
+        TDynamicVector<value_type> tmp(m.nRows * m.nCols, uninitialized);
+        utmatrix_detail::readText(istr, tmp.data(), tmp.size());
+        for (size_t i = 0; i < m.nRows; i++)
+            std::copy_n(tmp.data() + i * m.nCols, m.nCols, m.pMem + i * m.ld);
+        return istr;
+    }
+
+    friend ostream& operator<<(ostream& ostr, const TMatrixView& m)
+    {
+        utmatrix_detail::writeText(ostr, static_cast<const T*>(m.pMem), m.nRows, m.nCols, m.ld, true);
+        return ostr;
+    }
+};
+
+// C = alpha * A * B + beta * C для плотных операндов, в том числе представлений:
+// блочные алгоритмы обновляют блоки результата на месте, без копирования
+template<typename MA, typename MB, typename MC>
+typename std::enable_if<TIsDenseMatrix<MA>::value && TIsDenseMatrix<MB>::value &&
+    TIsDenseMatrix<typename std::decay<MC>::type>::value>::type
+gemm(const typename MA::value_type& alpha, const MA& a, const MB& b, const typename MA::value_type& beta, MC&& c)
+{
+    if (a.cols() != b.rows() || c.rows() != a.rows() || c.cols() != b.cols())
+        throw invalid_argument("Размеры матриц не согласованы");
+    gemm(a.rows(), b.cols(), a.cols(), alpha, a.data(), ptrdiff_t(a.stride()), ptrdiff_t(1),
+         b.data(), ptrdiff_t(b.stride()), ptrdiff_t(1), beta, c.data(), c.stride());
+}
+
+// Матрица хранится в одном непрерывном выровненном буфере по строкам
+template<typename T, typename Alloc>
+class TDynamicMatrix : private TDynamicVector<T, Alloc>
+{
+    using TDynamicVector<T, Alloc>::pMem;
+    using TDynamicVector<T, Alloc>::sz;
+
+    size_t nRows;
+    size_t nCols;
+
+    static size_t checkedSize(size_t r, size_t c)
+    {
+        const size_t maxSize = sizeLimits().maxMatrixSize;
+        if (r == 0 || c == 0 || r > maxSize || c > maxSize)
+            throw out_of_range("Размер больше 0 и меньше максимального");
+        return utmatrix_detail::checkedMul(r, c);
+    }
+
+    TDynamicVector<T, Alloc>& base() noexcept { return *this; }
+    const TDynamicVector<T, Alloc>& base() const noexcept { return *this; }
+
+    friend struct utmatrix_detail::TExprEval;
+
+public:
+    typedef T value_type;
+    typedef Alloc allocator_type;
+
+    TDynamicMatrix(size_t r = 1, size_t c = 1, const Alloc& a = Alloc())
+        : TDynamicVector<T, Alloc>(checkedSize(r, c), a), nRows(r), nCols(c) {}
+
+    TDynamicMatrix(size_t r, size_t c, TUninitializedTag, const Alloc& a = Alloc())
+        : TDynamicVector<T, Alloc>(checkedSize(r, c), uninitialized, a), nRows(r), nCols(c) {}
+
+    TDynamicMatrix(size_t r, size_t c, const T& value, const Alloc& a = Alloc())
+        : TDynamicVector<T, Alloc>(checkedSize(r, c), value, a), nRows(r), nCols(c) {}
+
+    template<typename E, typename = typename std::enable_if<TIsMatrixExpr<E>::value && !std::is_same<E, TDynamicMatrix>::value>::type>
+    TDynamicMatrix(const E& e, const Alloc& a = Alloc()) : TDynamicMatrix(e.rows(), e.cols(), uninitialized, a)
+    {
+        utmatrix_detail::TExprEval::assignMatrix(pMem, nCols, e);
+    }
+
+    TDynamicMatrix(const TDynamicMatrix& m) = default;
+
+    TDynamicMatrix(TDynamicMatrix&& m) noexcept : TDynamicVector<T, Alloc>(std::move(m.base())), nRows(m.nRows), nCols(m.nCols)
+    {
+        m.nRows = 0;
+        m.nCols = 0;
+    }
+
+    TDynamicMatrix& operator=(const TDynamicMatrix& m) = default;
+
+    using TDynamicVector<T, Alloc>::get_allocator;
+
+    TDynamicMatrix& operator=(TDynamicMatrix&& m) noexcept
+    {
+        if (this != &m) {
+            base() = std::move(m.base());
+            nRows = m.nRows;
+            nCols = m.nCols;
+            m.nRows = 0;
+            m.nCols = 0;
+        }
+        return *this;
+    }
+
+    template<typename E, typename = typename std::enable_if<TIsMatrixExpr<E>::value && !std::is_same<E, TDynamicMatrix>::value>::type>
+    TDynamicMatrix& operator=(const E& e)
+    {
+        if (e.rows() == nRows && e.cols() == nCols) {
+            utmatrix_detail::TExprEval::assignMatrix(pMem, nCols, e);
+        }
+        else {
+            TDynamicMatrix tmp(e, get_allocator());
+            swap(*this, tmp);
+        }
+        return *this;
+    }
+
+    size_t rows() const noexcept { return nRows; }
+    size_t cols() const noexcept { return nCols; }
+    T eval(size_t i, size_t j) const { return pMem[i * nCols + j]; }
+
+    bool operator==(const TDynamicMatrix& m) const noexcept {
+        if (rows() != m.rows() || cols() != m.cols()) return false;
+        return base() == m.base();
+    }
+
+    bool operator!=(const TDynamicMatrix& m) const noexcept {
+        return !(*this == m);
+    }
+
+    template<typename E, typename = typename std::enable_if<TIsMatrixExpr<E>::value>::type>
+    TDynamicMatrix& operator+=(const E& e) {
+        if (rows() != e.rows() || cols() != e.cols()) throw invalid_argument("Матрицы должны быть одного размера");
+        utmatrix_detail::TExprEval::updateMatrix(pMem, nCols, e, TAddOp());
+        return *this;
+    }
+
+    template<typename E, typename = typename std::enable_if<TIsMatrixExpr<E>::value>::type>
+    TDynamicMatrix& operator-=(const E& e) {
+        if (rows() != e.rows() || cols() != e.cols()) throw invalid_argument("Матрицы должны быть одного размера");
+        utmatrix_detail::TExprEval::updateMatrix(pMem, nCols, e, TSubOp());
+        return *this;
+    }
+
+    TDynamicMatrix& operator*=(const T& val) {
+        utmatrix_detail::TExprEval::updateMatrixScalar(pMem, nCols, nRows, nCols, val, TMulOp());
+        return *this;
+    }
+
+    template<typename E, typename = typename std::enable_if<TIsMatrixExpr<E>::value>::type>
+    TDynamicMatrix& axpy(const T& alpha, const E& x) {
+        if (rows() != x.rows() || cols() != x.cols()) throw invalid_argument("Матрицы должны быть одного размера");
+        utmatrix_detail::TExprEval::axpyMatrix(pMem, nCols, alpha, x);
+        return *this;
+    }
+
+    // Результат произведений использует распределитель левого операнда
+    template<typename A>
+    TDynamicVector<T, Alloc> multiply(const TDynamicVector<T, A>& v) const {
+        if (cols() != v.size()) throw invalid_argument("Число столбцов матрицы должно совпадать с размером вектора");
+        TDynamicVector<T, Alloc> res(rows(), uninitialized, get_allocator());
+        gemv(nRows, nCols, pMem, nCols, v.data(), res.data());
+        return res;
+    }
+
+    // Транспонированная копия
+    TDynamicMatrix transposed() const {
+        TDynamicMatrix res(nCols, nRows, uninitialized, get_allocator());
+        ::transpose(nRows, nCols, pMem, nCols, res.pMem, res.nCols);
+        return res;
+    }
+
+    // Транспонирование на месте; у прямоугольной матрицы размеры меняются местами
+    TDynamicMatrix& transpose() {
+        transposeInPlace(nRows, nCols, pMem);
+        std::swap(nRows, nCols);
+        return *this;
+    }
+
+    // A^T v без построения транспонированной матрицы
+    template<typename A>
+    TDynamicVector<T, Alloc> multiplyTransposed(const TDynamicVector<T, A>& v) const {
+        if (rows() != v.size()) throw invalid_argument("Число строк матрицы должно совпадать с размером вектора");
+        TDynamicVector<T, Alloc> res(cols(), uninitialized, get_allocator());
+        gemvTransposed(nRows, nCols, pMem, nCols, v.data(), res.data());
+        return res;
+    }
+
+    // Правый операнд — любая плотная матрица (в том числе отображённая из файла)
+    template<typename M, typename = typename std::enable_if<TIsDenseMatrix<M>::value>::type>
+    TDynamicMatrix multiply(const M& m) const {
+        if (cols() != m.rows()) throw invalid_argument("Число столбцов первой матрицы должно совпадать с количеством строк второй матрицы");
+        TDynamicMatrix res(rows(), m.cols(), uninitialized, get_allocator()); // gemm с beta = 0 не читает C
+        utmatrix_detail::denseProduct(rows(), m.cols(), cols(), pMem, nCols, m.data(), m.stride(), res.pMem, res.nCols);
+        return res;
+    }
+
+    TMatrixRow<T> operator[](size_t index) {
+        if (index >= nRows) throw out_of_range("Индекс вне диапазона");
+        return TMatrixRow<T>(pMem + index * nCols, nCols);
+    }
+
+    TMatrixRow<const T> operator[](size_t index) const {
+        if (index >= nRows) throw out_of_range("Индекс вне диапазона");
+        return TMatrixRow<const T>(pMem + index * nCols, nCols);
+    }
+
+    TMatrixRow<T> at(size_t index) { return (*this)[index]; }
+    TMatrixRow<const T> at(size_t index) const { return (*this)[index]; }
+
+    T& at(size_t i, size_t j) {
+        if (i >= nRows || j >= nCols) throw out_of_range("Индекс вне диапазона");
+        return pMem[i * nCols + j];
+    }
+
+    const T& at(size_t i, size_t j) const {
+        if (i >= nRows || j >= nCols) throw out_of_range("Индекс вне диапазона");
+        return pMem[i * nCols + j];
+    }
+
+    // Доступ без проверки индексов; проверка только в отладочной сборке
+    T& operator()(size_t i, size_t j) noexcept {
+        assert(i < nRows && j < nCols && "Индекс вне диапазона");
+        return pMem[i * nCols + j];
+    }
+
+    const T& operator()(size_t i, size_t j) const noexcept {
+        assert(i < nRows && j < nCols && "Индекс вне диапазона");
+        return pMem[i * nCols + j];
+    }
+
+    // Элементы хранятся по строкам: элемент (i, j) находится в data()[i * stride() + j]
+    T* data() noexcept { return pMem; }
+    const T* data() const noexcept { return pMem; }
+    size_t stride() const noexcept { return nCols; }
+
+    // Представления без копирования: вся матрица, блок r x c с углом (i, j), строка, столбец
+    TMatrixView<T> view() noexcept { return TMatrixView<T>(pMem, nRows, nCols, nCols); }
+    TMatrixView<const T> view() const noexcept { return TMatrixView<const T>(pMem, nRows, nCols, nCols); }
+    TMatrixView<T> block(size_t i, size_t j, size_t r, size_t c) { return view().block(i, j, r, c); }
+    TMatrixView<const T> block(size_t i, size_t j, size_t r, size_t c) const { return view().block(i, j, r, c); }
+    TVectorView<T> row(size_t i) { return view().row(i); }
+    TVectorView<const T> row(size_t i) const { return view().row(i); }
+    TVectorView<T> col(size_t j) { return view().col(j); }
+    TVectorView<const T> col(size_t j) const { return view().col(j); }
+
+    friend void swap(TDynamicMatrix& lhs, TDynamicMatrix& rhs) noexcept
+    {
+        swap(lhs.base(), rhs.base());
+        std::swap(lhs.nRows, rhs.nRows);
+        std::swap(lhs.nCols, rhs.nCols);
+    }
+
+    friend istream& operator>>(istream& istr, TDynamicMatrix& m) {
+        return istr >> m.base();
+    }
+
+    friend ostream& operator<<(ostream& ostr, const TDynamicMatrix& m) {
+        utmatrix_detail::writeText(ostr, m.pMem, m.nRows, m.nCols, m.nCols, true);
+        return ostr;
+    }
+};
+
+// Треугольная матрица порядка n в упакованном виде: хранятся только n(n+1)/2
+// элементов треугольника, по строкам подряд. Элементы вне треугольника равны нулю
+// и не хранятся. Upper == true — верхняя треугольная, иначе нижняя.
+template<typename T, bool Upper>
+class TTriangularMatrix : private TDynamicVector<T>
+{
+    using TDynamicVector<T>::pMem;
+    using TDynamicVector<T>::sz;
+
+    size_t n;
+
+    static size_t checkedSize(size_t order)
+    {
+        if (order == 0 || order > sizeLimits().maxMatrixSize)
+            throw out_of_range("Размер больше 0 и меньше максимального");
+        return order % 2 == 0 ? utmatrix_detail::checkedMul(order / 2, order + 1) : utmatrix_detail::checkedMul(order, (order + 1) / 2);
+    }
+
+    TDynamicVector<T>& base() noexcept { return *this; }
+    const TDynamicVector<T>& base() const noexcept { return *this; }
+
+    bool stored(size_t i, size_t j) const noexcept { return Upper ? j >= i : j <= i; }
+    size_t index(size_t i, size_t j) const noexcept { return rowOffset(i) + (j - rowBegin(i)); }
+
+    void checkSolvable(size_t rhsRows) const
+    {
+        if (rhsRows != n) throw invalid_argument("Размер правой части должен совпадать с порядком матрицы");
+        for (size_t i = 0; i < n; i++)
+            if (pMem[index(i, i)] == T()) throw invalid_argument("Матрица вырождена");
+    }
+
+    // Подстановка для столбцов [cb, ce) матрицы X (шаг строк ldx) на месте
+    void substitute(T* x, size_t ldx, size_t cb, size_t ce, bool transposed) const
+    {
+        const size_t w = ce - cb;
+        for (size_t s = 0; s < n; s++) {
+            const bool forward = Upper == transposed;
+            const size_t i = forward ? s : n - 1 - s;
+            const T* row = rowData(i);
+            const size_t first = rowBegin(i);
+            T* xi = x + i * ldx + cb;
+            if (!transposed)
+                for (size_t q = 0; q < rowLength(i); q++)
+                    if (first + q != i)
+                        utmatrix_detail::TExprEval::axpy(T() - row[q], x + (first + q) * ldx + cb, xi, w);
+            const T d = row[i - first];
+            for (size_t j = 0; j < w; j++)
+                xi[j] /= d;
+            if (transposed)
+                for (size_t q = 0; q < rowLength(i); q++)
+                    if (first + q != i)
+                        utmatrix_detail::TExprEval::axpy(T() - row[q], xi, x + (first + q) * ldx + cb, w);
+        }
+    }
+
+    TDynamicMatrix<T> solveColumns(const TDynamicMatrix<T>& b, bool transposed) const
+    {
+        checkSolvable(b.rows());
+        TDynamicMatrix<T> x(b);
+        const size_t m = b.cols();
+        const size_t grain = std::max<size_t>(16, m / (4 * TThreadPool::instance().threadCount()) + 1);
+        TThreadPool::instance().parallelFor(0, m, grain, [&](size_t cb, size_t ce) {
+            substitute(x.data(), m, cb, ce, transposed);
+        });
+        return x;
+    }
+
+public:
+    typedef T value_type;
+
+    explicit TTriangularMatrix(size_t order = 1) : TDynamicVector<T>(checkedSize(order)), n(order) {}
+    TTriangularMatrix(size_t order, TUninitializedTag) : TDynamicVector<T>(checkedSize(order), uninitialized), n(order) {}
+
+    // Треугольная часть квадратной плотной матрицы
+    explicit TTriangularMatrix(const TDynamicMatrix<T>& m) : TTriangularMatrix(m.rows(), uninitialized)
+    {
+        if (m.rows() != m.cols()) throw invalid_argument("Матрица должна быть квадратной");
+        for (size_t i = 0; i < n; i++)
+            std::copy_n(m.data() + i * m.stride() + rowBegin(i), rowLength(i), rowData(i));
+    }
+
+    TTriangularMatrix(const TTriangularMatrix&) = default;
+    TTriangularMatrix(TTriangularMatrix&& m) noexcept : TDynamicVector<T>(std::move(m.base())), n(m.n) { m.n = 0; }
+    TTriangularMatrix& operator=(const TTriangularMatrix&) = default;
+
+    TTriangularMatrix& operator=(TTriangularMatrix&& m) noexcept
+    {
+        if (this != &m) {
+            base() = std::move(m.base());
+            n = m.n;
+            m.n = 0;
+        }
+        return *this;
+    }
+
+    size_t size() const noexcept { return n; }
+    size_t rows() const noexcept { return n; }
+    size_t cols() const noexcept { return n; }
+
+    // Упакованная строка i: rowLength(i) элементов, начиная со столбца rowBegin(i)
+    size_t rowBegin(size_t i) const noexcept { return Upper ? i : 0; }
+    size_t rowLength(size_t i) const noexcept { return Upper ? n - i : i + 1; }
+    size_t rowOffset(size_t i) const noexcept { return Upper ? i * n - i * (i - 1) / 2 : i * (i + 1) / 2; }
+    T* rowData(size_t i) noexcept { return pMem + rowOffset(i); }
+    const T* rowData(size_t i) const noexcept { return pMem + rowOffset(i); }
+    T* data() noexcept { return pMem; }
+    const T* data() const noexcept { return pMem; }
+
+    T eval(size_t i, size_t j) const { return stored(i, j) ? pMem[index(i, j)] : T(); }
+
+    // Запись возможна только в хранимый треугольник
+    T& at(size_t i, size_t j) {
+        if (i >= n || j >= n || !stored(i, j)) throw out_of_range("Индекс вне диапазона");
+        return pMem[index(i, j)];
+    }
+
+    T at(size_t i, size_t j) const {
+        if (i >= n || j >= n) throw out_of_range("Индекс вне диапазона");
+        return eval(i, j);
+    }
+
+    // Доступ без проверки; (i, j) должен лежать в хранимом треугольнике
+    T& operator()(size_t i, size_t j) noexcept {
+        assert(i < n && j < n && stored(i, j) && "Индекс вне диапазона");
+        return pMem[index(i, j)];
+    }
+
+    const T& operator()(size_t i, size_t j) const noexcept {
+        assert(i < n && j < n && stored(i, j) && "Индекс вне диапазона");
+        return pMem[index(i, j)];
+    }
+
+    bool operator==(const TTriangularMatrix& m) const noexcept {
+        return n == m.n && base() == m.base();
+    }
+
+    bool operator!=(const TTriangularMatrix& m) const noexcept {
+        return !(*this == m);
+    }
+
+    // Поэлементные операции затрагивают только хранимую половину
+    TTriangularMatrix& operator+=(const TTriangularMatrix& m) {
+        if (n != m.n) throw invalid_argument("Матрицы должны быть одного размера");
+        base() += m.base();
+        return *this;
+    }
+
+    TTriangularMatrix& operator-=(const TTriangularMatrix& m) {
+        if (n != m.n) throw invalid_argument("Матрицы должны быть одного размера");
+        base() -= m.base();
+        return *this;
+    }
+
+    TTriangularMatrix& operator*=(const T& val) {
+        base() *= val;
+        return *this;
+    }
+
+    // Результат записывается один раз, без предварительного копирования операнда
+    TTriangularMatrix operator+(const TTriangularMatrix& m) const {
+        if (n != m.n) throw invalid_argument("Матрицы должны быть одного размера");
+        TTriangularMatrix res(n, uninitialized);
+        res.base() = base() + m.base();
+        return res;
+    }
+
+    TTriangularMatrix operator-(const TTriangularMatrix& m) const {
+        if (n != m.n) throw invalid_argument("Матрицы должны быть одного размера");
+        TTriangularMatrix res(n, uninitialized);
+        res.base() = base() - m.base();
+        return res;
+    }
+
+    TTriangularMatrix operator*(const T& val) const {
+        TTriangularMatrix res(n, uninitialized);
+        res.base() = base() * val;
+        return res;
+    }
+
+    // y_i = сумма по хранимой части строки i
+    TDynamicVector<T> multiply(const TDynamicVector<T>& v) const {
+        if (n != v.size()) throw invalid_argument("Число столбцов матрицы должно совпадать с размером вектора");
+        TDynamicVector<T> res(n, uninitialized);
+        const T* x = v.data();
+        T* y = res.data();
+        utmatrix_detail::TExprEval::forRows(n, n / 2 + 1, [&](size_t rb, size_t re) {
+            for (size_t i = rb; i < re; i++)
+                y[i] = utmatrix_detail::TExprEval::dot(rowData(i), x + rowBegin(i), rowLength(i));
+        });
+        return res;
+    }
+
+    // Произведение треугольных матриц одного вида остаётся треугольным:
+    // строка i результата — сумма a(i, k) * (строка k из m) по хранимым k,
+    // поэтому нулевые половины не читаются и не умножаются
+    TTriangularMatrix multiply(const TTriangularMatrix& m) const {
+        if (n != m.n) throw invalid_argument("Матрицы должны быть одного размера");
+        TTriangularMatrix res(n);
+        utmatrix_detail::TExprEval::forRows(n, n / 2 + 1, [&](size_t rb, size_t re) {
+            for (size_t i = rb; i < re; i++) {
+                const T* a = rowData(i);
+                T* c = res.rowData(i);
+                for (size_t p = 0; p < rowLength(i); p++) {
+                    const size_t k = rowBegin(i) + p;
+                    utmatrix_detail::TExprEval::axpy(a[p], m.rowData(k), c + (m.rowBegin(k) - res.rowBegin(i)), m.rowLength(k));
+                }
+            }
+        });
+        return res;
+    }
+
+    TDynamicVector<T> operator*(const TDynamicVector<T>& v) const { return multiply(v); }
+    TTriangularMatrix operator*(const TTriangularMatrix& m) const { return multiply(m); }
+
+    // Решение треугольной системы A x = b подстановкой по строкам
+    TDynamicVector<T> solve(const TDynamicVector<T>& b) const
+    {
+        checkSolvable(b.size());
+        TDynamicVector<T> x(b);
+        T* px = x.data();
+        for (size_t s = 0; s < n; s++) {
+            const size_t i = Upper ? n - 1 - s : s;
+            const T* row = rowData(i);
+            if (Upper)
+                px[i] = (px[i] - utmatrix_detail::TExprEval::dot(row + 1, px + i + 1, n - i - 1)) / row[0];
+            else
+                px[i] = (px[i] - utmatrix_detail::TExprEval::dot(row, px, i)) / row[i];
+        }
+        return x;
+    }
+
+    // Решение транспонированной системы A^T x = b: строка i матрицы — столбец A^T,
+    // поэтому найденный x_i сразу вычитается из оставшихся уравнений
+    TDynamicVector<T> solveTransposed(const TDynamicVector<T>& b) const
+    {
+        checkSolvable(b.size());
+        TDynamicVector<T> x(b);
+        T* px = x.data();
+        for (size_t s = 0; s < n; s++) {
+            const size_t i = Upper ? s : n - 1 - s;
+            const T* row = rowData(i);
+            if (Upper) {
+                px[i] /= row[0];
+                utmatrix_detail::TExprEval::axpy(T() - px[i], row + 1, px + i + 1, n - i - 1);
+            }
+            else {
+                px[i] /= row[i];
+                utmatrix_detail::TExprEval::axpy(T() - px[i], row, px, i);
+            }
+        }
+        return x;
+    }
+
+    // Несколько правых частей — столбцы B; потоки делят столбцы между собой
+    TDynamicMatrix<T> solve(const TDynamicMatrix<T>& b) const
+    {
+        return solveColumns(b, false);
+    }
+
+    TDynamicMatrix<T> solveTransposed(const TDynamicMatrix<T>& b) const
+    {
+        return solveColumns(b, true);
+    }
+
+    friend void swap(TTriangularMatrix& lhs, TTriangularMatrix& rhs) noexcept
+    {
+        swap(lhs.base(), rhs.base());
+        std::swap(lhs.n, rhs.n);
+    }
+
+    // Ввод — только хранимые элементы по строкам, вывод — полная матрица с нулями
+    friend istream& operator>>(istream& istr, TTriangularMatrix& m) {
+        return istr >> m.base();
+    }
+
+    friend ostream& operator<<(ostream& ostr, const TTriangularMatrix& m) {
+        for (size_t i = 0; i < m.n; i++) {
+            for (size_t j = 0; j < m.n; j++)
+                ostr << m.eval(i, j) << ' ';
+            ostr << endl;
+        }
+        return ostr;
+    }
+};
+
+template<typename T>
+using TUpperTriangularMatrix = TTriangularMatrix<T, true>;
+
+template<typename T>
+using TLowerTriangularMatrix = TTriangularMatrix<T, false>;
+
+// Разреженная матрица в формате CSR (сжатые строки) или CSC (сжатые столбцы).
+// Для CSR outer — строки, inner — столбцы; для CSC наоборот. Ненулевые элементы
+// строки (столбца) p лежат в values[outer[p] .. outer[p + 1]) с возрастающими
+// индексами inner. Явные нули не хранятся, поэтому память и время операций
+// пропорциональны числу ненулевых элементов, а не размерам матрицы.
+template<typename T>
+struct TSparseEntry
+{
+    size_t row, col;
+    T value;
+};
+
+template<typename T>
+class TSparseMatrix
+{
+    size_t nRows, nCols;
+    TSparseFormat fmt;
+    std::vector<size_t> outer; // nOuter() + 1 смещений
+    std::vector<size_t> inner;
+    std::vector<T> vals;
+
+    static void checkSize(size_t r, size_t c)
+    {
+        if (r == 0 || c == 0 || r > sizeLimits().maxVectorSize || c > sizeLimits().maxVectorSize)
+            throw out_of_range("Размер больше 0 и меньше максимального");
+    }
+
+    size_t nOuter() const noexcept { return fmt == TSparseFormat::CSR ? nRows : nCols; }
+    size_t nInner() const noexcept { return fmt == TSparseFormat::CSR ? nCols : nRows; }
+
+    // Слияние двух матриц одного формата: c = a op b по объединению шаблонов
+    template<typename Op>
+    static TSparseMatrix combine(const TSparseMatrix& a, const TSparseMatrix& b, Op)
+    {
+        TSparseMatrix res(a.nRows, a.nCols, a.fmt);
+        res.inner.reserve(a.inner.size() + b.inner.size());
+        res.vals.reserve(a.vals.size() + b.vals.size());
+        for (size_t p = 0; p < a.nOuter(); p++) {
+            size_t i = a.outer[p], ie = a.outer[p + 1];
+            size_t j = b.outer[p], je = b.outer[p + 1];
+            while (i < ie || j < je) {
+                size_t k;
+                T v;
+                if (j == je || (i < ie && a.inner[i] < b.inner[j])) {
+                    k = a.inner[i];
+                    v = Op::apply(a.vals[i++], T());
+                }
+                else if (i == ie || b.inner[j] < a.inner[i]) {
+                    k = b.inner[j];
+                    v = Op::apply(T(), b.vals[j++]);
+                }
+                else {
+                    k = a.inner[i];
+                    v = Op::apply(a.vals[i++], b.vals[j++]);
+                }
+                if (v != T()) {
+                    res.inner.push_back(k);
+                    res.vals.push_back(v);
+                }
+            }
+            res.outer[p + 1] = res.inner.size();
+        }
+        return res;
+    }
+
+public:
+    typedef T value_type;
+
+    TSparseMatrix(size_t r = 1, size_t c = 1, TSparseFormat f = TSparseFormat::CSR) : nRows(r), nCols(c), fmt(f)
+    {
+        checkSize(r, c);
+        outer.assign(nOuter() + 1, 0);
+    }
+
+    // Сборка из списка (строка, столбец, значение); повторяющиеся позиции суммируются
+    TSparseMatrix(size_t r, size_t c, const std::vector<TSparseEntry<T>>& entries,
+                  TSparseFormat f = TSparseFormat::CSR) : TSparseMatrix(r, c, f)
+    {
+        const bool csr = fmt == TSparseFormat::CSR;
+        for (const auto& e : entries) {
+            if (e.row >= nRows || e.col >= nCols) throw out_of_range("Индекс вне диапазона");
+            outer[(csr ? e.row : e.col) + 1]++;
+        }
+        for (size_t p = 0; p < nOuter(); p++)
+            outer[p + 1] += outer[p];
+        std::vector<size_t> pos(outer.begin(), outer.end() - 1);
+        std::vector<size_t> idx(entries.size());
+        std::vector<T> val(entries.size());
+        for (const auto& e : entries) {
+            size_t q = pos[csr ? e.row : e.col]++;
+            idx[q] = csr ? e.col : e.row;
+            val[q] = e.value;
+        }
+        // Сортировка внутри строк, сложение повторов и удаление нулей
+        std::vector<size_t> order;
+        size_t start = 0;
+        for (size_t p = 0; p < nOuter(); p++) {
+            const size_t b = start, e = outer[p + 1];
+            order.resize(e - b);
+            for (size_t q = 0; q < order.size(); q++) order[q] = b + q;
+            std::sort(order.begin(), order.end(), [&](size_t x, size_t y) { return idx[x] < idx[y]; });
+            for (size_t q = 0; q < order.size();) {
+                const size_t k = idx[order[q]];
+                T sum = T();
+                for (; q < order.size() && idx[order[q]] == k; q++)
+                    sum += val[order[q]];
+                if (sum != T()) {
+                    inner.push_back(k);
+                    vals.push_back(sum);
+                }
+            }
+            start = e;
+            outer[p + 1] = inner.size();
+        }
+    }
+
+    explicit TSparseMatrix(const TDynamicMatrix<T>& m, TSparseFormat f = TSparseFormat::CSR)
+        : TSparseMatrix(m.rows(), m.cols(), f)
+    {
+        const bool csr = fmt == TSparseFormat::CSR;
+        for (size_t p = 0; p < nOuter(); p++) {
+            for (size_t k = 0; k < nInner(); k++) {
+                const T& v = csr ? m(p, k) : m(k, p);
+                if (v != T()) {
+                    inner.push_back(k);
+                    vals.push_back(v);
+                }
+            }
+            outer[p + 1] = inner.size();
+        }
+    }
+
+    size_t rows() const noexcept { return nRows; }
+    size_t cols() const noexcept { return nCols; }
+    size_t nonZeros() const noexcept { return vals.size(); }
+    TSparseFormat format() const noexcept { return fmt; }
+
+    const std::vector<size_t>& outerIndex() const noexcept { return outer; }
+    const std::vector<size_t>& innerIndex() const noexcept { return inner; }
+    const std::vector<T>& values() const noexcept { return vals; }
+
+    // Та же матрица в другом формате: сортировка подсчётом за O(nnz + n)
+    TSparseMatrix convert(TSparseFormat f) const
+    {
+        if (f == fmt) return *this;
+        TSparseMatrix res(nRows, nCols, f);
+        res.inner.resize(inner.size());
+        res.vals.resize(vals.size());
+        for (size_t q = 0; q < inner.size(); q++)
+            res.outer[inner[q] + 1]++;
+        for (size_t p = 0; p < res.nOuter(); p++)
+            res.outer[p + 1] += res.outer[p];
+        std::vector<size_t> pos(res.outer.begin(), res.outer.end() - 1);
+        for (size_t p = 0; p < nOuter(); p++)
+            for (size_t q = outer[p]; q < outer[p + 1]; q++) {
+                const size_t d = pos[inner[q]]++;
+                res.inner[d] = p;
+                res.vals[d] = vals[q];
+            }
+        return res;
+    }
+
+    T eval(size_t i, size_t j) const
+    {
+        const bool csr = fmt == TSparseFormat::CSR;
+        const size_t p = csr ? i : j, k = csr ? j : i;
+        auto b = inner.begin() + ptrdiff_t(outer[p]), e = inner.begin() + ptrdiff_t(outer[p + 1]);
+        auto it = std::lower_bound(b, e, k);
+        return (it != e && *it == k) ? vals[size_t(it - inner.begin())] : T();
+    }
+
+    T at(size_t i, size_t j) const {
+        if (i >= nRows || j >= nCols) throw out_of_range("Индекс вне диапазона");
+        return eval(i, j);
+    }
+
+    bool operator==(const TSparseMatrix& m) const
+    {
+        if (nRows != m.nRows || nCols != m.nCols) return false;
+        if (fmt != m.fmt) return *this == m.convert(fmt);
+        return outer == m.outer && inner == m.inner && vals == m.vals;
+    }
+
+    bool operator!=(const TSparseMatrix& m) const { return !(*this == m); }
+
+    // Сумма и разность получают формат левого операнда
+    TSparseMatrix operator+(const TSparseMatrix& m) const
+    {
+        if (nRows != m.nRows || nCols != m.nCols) throw invalid_argument("Матрицы должны быть одного размера");
+        return fmt == m.fmt ? combine(*this, m, TAddOp()) : combine(*this, m.convert(fmt), TAddOp());
+    }
+
+    TSparseMatrix operator-(const TSparseMatrix& m) const
+    {
+        if (nRows != m.nRows || nCols != m.nCols) throw invalid_argument("Матрицы должны быть одного размера");
+        return fmt == m.fmt ? combine(*this, m, TSubOp()) : combine(*this, m.convert(fmt), TSubOp());
+    }
+
+    TSparseMatrix operator*(const T& val) const
+    {
+        if (val == T()) return TSparseMatrix(nRows, nCols, fmt);
+        TSparseMatrix res(*this);
+        for (T& v : res.vals) v *= val;
+        return res;
+    }
+
+    // SpMV: в CSR строки независимы и делятся между потоками,
+    // в CSC столбец разносится по строкам результата
+    TDynamicVector<T> multiply(const TDynamicVector<T>& v) const
+    {
+        if (nCols != v.size()) throw invalid_argument("Число столбцов матрицы должно совпадать с размером вектора");
+        const bool csr = fmt == TSparseFormat::CSR;
+        TDynamicVector<T> res = csr ? TDynamicVector<T>(nRows, uninitialized) : TDynamicVector<T>(nRows);
+        const T* x = v.data();
+        T* y = res.data();
+        if (csr) {
+            utmatrix_detail::TExprEval::forRows(nRows, vals.size() / nRows + 1, [&](size_t rb, size_t re) {
+                for (size_t i = rb; i < re; i++) {
+                    T sum = T();
+                    for (size_t q = outer[i]; q < outer[i + 1]; q++)
+                        sum += vals[q] * x[inner[q]];
+                    y[i] = sum;
+                }
+            });
+        }
+        else {
+            for (size_t j = 0; j < nCols; j++)
+                for (size_t q = outer[j]; q < outer[j + 1]; q++)
+                    y[inner[q]] += vals[q] * x[j];
+        }
+        return res;
+    }
+
+    // SpMM: строка результата — сумма строк плотной матрицы с весами ненулевых элементов
+    TDynamicMatrix<T> multiply(const TDynamicMatrix<T>& m) const
+    {
+        if (nCols != m.rows()) throw invalid_argument("Число столбцов первой матрицы должно совпадать с количеством строк второй матрицы");
+        const size_t n = m.cols();
+        TDynamicMatrix<T> res(nRows, n);
+        const T* b = m.data();
+        T* c = res.data();
+        if (fmt == TSparseFormat::CSR) {
+            utmatrix_detail::TExprEval::forRows(nRows, (vals.size() / nRows + 1) * n, [&](size_t rb, size_t re) {
+                for (size_t i = rb; i < re; i++)
+                    for (size_t q = outer[i]; q < outer[i + 1]; q++)
+                        utmatrix_detail::TExprEval::axpy(vals[q], b + inner[q] * n, c + i * n, n);
+            });
+        }
+        else {
+            for (size_t j = 0; j < nCols; j++)
+                for (size_t q = outer[j]; q < outer[j + 1]; q++)
+                    utmatrix_detail::TExprEval::axpy(vals[q], b + j * n, c + inner[q] * n, n);
+        }
+        return res;
+    }
+
+    TDynamicVector<T> operator*(const TDynamicVector<T>& v) const { return multiply(v); }
+    TDynamicMatrix<T> operator*(const TDynamicMatrix<T>& m) const { return multiply(m); }
+
+    friend void swap(TSparseMatrix& lhs, TSparseMatrix& rhs) noexcept
+    {
+        std::swap(lhs.nRows, rhs.nRows);
+        std::swap(lhs.nCols, rhs.nCols);
+        std::swap(lhs.fmt, rhs.fmt);
+        lhs.outer.swap(rhs.outer);
+        lhs.inner.swap(rhs.inner);
+        lhs.vals.swap(rhs.vals);
+    }
+
+    // Текстовый формат: "строки столбцы число_элементов", затем тройки "i j значение"
+    friend istream& operator>>(istream& istr, TSparseMatrix& m)
+    {
+        size_t r, c, nnz;
+        if (!(istr >> r >> c >> nnz)) return istr;
+        std::vector<TSparseEntry<T>> entries(nnz);
+        for (auto& e : entries)
+            istr >> e.row >> e.col >> e.value;
+        if (istr) m = TSparseMatrix(r, c, entries, m.fmt);
+        return istr;
+    }
+
+    friend ostream& operator<<(ostream& ostr, const TSparseMatrix& m)
+    {
+        const bool csr = m.fmt == TSparseFormat::CSR;
+        ostr << m.nRows << ' ' << m.nCols << ' ' << m.nonZeros() << endl;
+        for (size_t p = 0; p < m.nOuter(); p++)
+            for (size_t q = m.outer[p]; q < m.outer[p + 1]; q++)
+                ostr << (csr ? p : m.inner[q]) << ' ' << (csr ? m.inner[q] : p) << ' ' << m.vals[q] << endl;
+        return ostr;
+    }
+};
+
+// Поэлементные операции над векторами
+
+template<typename L, typename R>
+typename std::enable_if<TIsVectorExpr<L>::value && TIsVectorExpr<R>::value,
+    TVectorBinaryExpr<L, R, TAddOp>>::type operator+(const L& l, const R& r)
+{
+    static_assert(std::is_same<typename L::value_type, typename R::value_type>::value, "Векторы должны иметь один тип элементов");
+    return TVectorBinaryExpr<L, R, TAddOp>(l, r);
+}
+
+template<typename L, typename R>
+typename std::enable_if<TIsVectorExpr<L>::value && TIsVectorExpr<R>::value,
+    TVectorBinaryExpr<L, R, TSubOp>>::type operator-(const L& l, const R& r)
+{
+    static_assert(std::is_same<typename L::value_type, typename R::value_type>::value, "Векторы должны иметь один тип элементов");
+    return TVectorBinaryExpr<L, R, TSubOp>(l, r);
+}
+
+template<typename E>
+typename std::enable_if<TIsVectorExpr<E>::value,
+    TVectorScalarExpr<E, TAddOp>>::type operator+(const E& e, const typename E::value_type& val)
+{
+    return TVectorScalarExpr<E, TAddOp>(e, val);
+}
+
+template<typename E>
+typename std::enable_if<TIsVectorExpr<E>::value,
+    TVectorScalarExpr<E, TSubOp>>::type operator-(const E& e, const typename E::value_type& val)
+{
+    return TVectorScalarExpr<E, TSubOp>(e, val);
+}
+
+template<typename E>
+typename std::enable_if<TIsVectorExpr<E>::value,
+    TVectorScalarExpr<E, TMulOp>>::type operator*(const E& e, const typename E::value_type& val)
+{
+    return TVectorScalarExpr<E, TMulOp>(e, val);
+}
+
+// Скалярное произведение вычисляется сразу, без промежуточных векторов
+template<typename L, typename R>
+typename std::enable_if<TIsVectorExpr<L>::value && TIsVectorExpr<R>::value,
+    typename L::value_type>::type operator*(const L& l, const R& r)
+{
+    static_assert(std::is_same<typename L::value_type, typename R::value_type>::value, "Векторы должны иметь один тип элементов");
+    if (l.size() != r.size()) throw invalid_argument("Векторы должны быть одного размера");
+    return utmatrix_detail::TExprEval::dot(l, r);
+}
+
+// Поэлементные операции над матрицами
+
+template<typename L, typename R>
+typename std::enable_if<TIsMatrixExpr<L>::value && TIsMatrixExpr<R>::value,
+    TMatrixBinaryExpr<L, R, TAddOp>>::type operator+(const L& l, const R& r)
+{
+    static_assert(std::is_same<typename L::value_type, typename R::value_type>::value, "Матрицы должны иметь один тип элементов");
+    return TMatrixBinaryExpr<L, R, TAddOp>(l, r);
+}
+
+template<typename L, typename R>
+typename std::enable_if<TIsMatrixExpr<L>::value && TIsMatrixExpr<R>::value,
+    TMatrixBinaryExpr<L, R, TSubOp>>::type operator-(const L& l, const R& r)
+{
+    static_assert(std::is_same<typename L::value_type, typename R::value_type>::value, "Матрицы должны иметь один тип элементов");
+    return TMatrixBinaryExpr<L, R, TSubOp>(l, r);
+}
+
+template<typename E>
+typename std::enable_if<TIsMatrixExpr<E>::value,
+    TMatrixScalarExpr<E, TMulOp>>::type operator*(const E& e, const typename E::value_type& val)
+{
+    return TMatrixScalarExpr<E, TMulOp>(e, val);
+}
+
+// Произведения с участием узлов: операнды вычисляются один раз, затем GEMM/GEMV
+template<typename L, typename R>
+auto operator*(const L& l, const R& r) -> typename std::enable_if<TIsMatrixExpr<L>::value && TIsMatrixExpr<R>::value,
+    decltype(utmatrix_detail::materialize(l).multiply(utmatrix_detail::materialize(r)))>::type
+{
+    const auto& lm = utmatrix_detail::materialize(l);
+    const auto& rm = utmatrix_detail::materialize(r);
+    return lm.multiply(rm);
+}
+
+template<typename L, typename R>
+auto operator*(const L& l, const R& r) -> typename std::enable_if<TIsMatrixExpr<L>::value && TIsVectorExpr<R>::value,
+    decltype(utmatrix_detail::materialize(l).multiply(utmatrix_detail::materialize(r)))>::type
+{
+    const auto& lm = utmatrix_detail::materialize(l);
+    const auto& rv = utmatrix_detail::materialize(r);
+    return lm.multiply(rv);
+}
+
+// Перегрузки для временных операндов: результат пишется в буфер временного
+// объекта и возвращается перемещением, поэтому (a * b) + c не выделяет память
+// под сумму, а узел выражения не ссылается на уничтожаемый временный объект.
+
+template<typename T, typename A, typename R>
+typename std::enable_if<TIsVectorExpr<R>::value, TDynamicVector<T, A>>::type operator+(TDynamicVector<T, A>&& l, const R& r)
+{
+    static_assert(std::is_same<T, typename R::value_type>::value, "Векторы должны иметь один тип элементов");
+    l += r;
+    return std::move(l);
+}
+
+template<typename T, typename A, typename L>
+typename std::enable_if<TIsVectorExpr<L>::value, TDynamicVector<T, A>>::type operator+(const L& l, TDynamicVector<T, A>&& r)
+{
+    static_assert(std::is_same<T, typename L::value_type>::value, "Векторы должны иметь один тип элементов");
+    r += l;
+    return std::move(r);
+}
+
+template<typename T, typename A>
+TDynamicVector<T, A> operator+(TDynamicVector<T, A>&& l, TDynamicVector<T, A>&& r)
+{
+    l += r;
+    return std::move(l);
+}
+
+template<typename T, typename A, typename R>
+typename std::enable_if<TIsVectorExpr<R>::value, TDynamicVector<T, A>>::type operator-(TDynamicVector<T, A>&& l, const R& r)
+{
+    static_assert(std::is_same<T, typename R::value_type>::value, "Векторы должны иметь один тип элементов");
+    l -= r;
+    return std::move(l);
+}
+
+template<typename T, typename A, typename L>
+typename std::enable_if<TIsVectorExpr<L>::value, TDynamicVector<T, A>>::type operator-(const L& l, TDynamicVector<T, A>&& r)
+{
+    static_assert(std::is_same<T, typename L::value_type>::value, "Векторы должны иметь один тип элементов");
+    r = l - r;
+    return std::move(r);
+}
+
+template<typename T, typename A>
+TDynamicVector<T, A> operator-(TDynamicVector<T, A>&& l, TDynamicVector<T, A>&& r)
+{
+    l -= r;
+    return std::move(l);
+}
+
+template<typename T, typename A>
+TDynamicVector<T, A> operator+(TDynamicVector<T, A>&& l, const typename TDynamicVector<T, A>::value_type& val)
+{
+    l += val;
+    return std::move(l);
+}
+
+template<typename T, typename A>
+TDynamicVector<T, A> operator-(TDynamicVector<T, A>&& l, const typename TDynamicVector<T, A>::value_type& val)
+{
+    l -= val;
+    return std::move(l);
+}
+
+template<typename T, typename A>
+TDynamicVector<T, A> operator*(TDynamicVector<T, A>&& l, const typename TDynamicVector<T, A>::value_type& val)
+{
+    l *= val;
+    return std::move(l);
+}
+
+template<typename T, typename A, typename R>
+typename std::enable_if<TIsMatrixExpr<R>::value, TDynamicMatrix<T, A>>::type operator+(TDynamicMatrix<T, A>&& l, const R& r)
+{
+    static_assert(std::is_same<T, typename R::value_type>::value, "Матрицы должны иметь один тип элементов");
+    l += r;
+    return std::move(l);
+}
+
+template<typename T, typename A, typename L>
+typename std::enable_if<TIsMatrixExpr<L>::value, TDynamicMatrix<T, A>>::type operator+(const L& l, TDynamicMatrix<T, A>&& r)
+{
+    static_assert(std::is_same<T, typename L::value_type>::value, "Матрицы должны иметь один тип элементов");
+    r += l;
+    return std::move(r);
+}
+
+template<typename T, typename A>
+TDynamicMatrix<T, A> operator+(TDynamicMatrix<T, A>&& l, TDynamicMatrix<T, A>&& r)
+{
+    l += r;
+    return std::move(l);
+}
+
+template<typename T, typename A, typename R>
+typename std::enable_if<TIsMatrixExpr<R>::value, TDynamicMatrix<T, A>>::type operator-(TDynamicMatrix<T, A>&& l, const R& r)
+{
+    static_assert(std::is_same<T, typename R::value_type>::value, "Матрицы должны иметь один тип элементов");
+    l -= r;
+    return std::move(l);
+}
+
+template<typename T, typename A, typename L>
+typename std::enable_if<TIsMatrixExpr<L>::value, TDynamicMatrix<T, A>>::type operator-(const L& l, TDynamicMatrix<T, A>&& r)
+{
+    static_assert(std::is_same<T, typename L::value_type>::value, "Матрицы должны иметь один тип элементов");
+    r = l - r;
+    return std::move(r);
+}
+
+template<typename T, typename A>
+TDynamicMatrix<T, A> operator-(TDynamicMatrix<T, A>&& l, TDynamicMatrix<T, A>&& r)
+{
+    l -= r;
+    return std::move(l);
+}
+
+template<typename T, typename A>
+TDynamicMatrix<T, A> operator*(TDynamicMatrix<T, A>&& l, const typename TDynamicMatrix<T, A>::value_type& val)
+{
+    l *= val;
+    return std::move(l);
+}
+
+// Треугольная матрица на векторное выражение: выражение вычисляется один раз
+template<typename T, bool U, typename R>
+typename std::enable_if<TIsVectorExpr<R>::value && !TIsExprLeaf<R>::value,
+    TDynamicVector<T>>::type operator*(const TTriangularMatrix<T, U>& l, const R& r)
+{
+    return l.multiply(utmatrix_detail::materialize(r));
+}
+
+// Разреженная матрица на векторное выражение
+template<typename T, typename R>
+typename std::enable_if<TIsVectorExpr<R>::value && !TIsExprLeaf<R>::value,
+    TDynamicVector<T>>::type operator*(const TSparseMatrix<T>& l, const R& r)
+{
+    return l.multiply(utmatrix_detail::materialize(r));
+}
+
+// LU-разложение с частичным выбором ведущего элемента: PA = LU, где L — нижняя
+// треугольная с единичной диагональю, U — верхняя треугольная. Оба множителя
+// хранятся на месте A. Разложение блочное (right-looking): узкая панель столбцов
+// раскладывается построчно, а обновление оставшейся подматрицы A22 -= L21 * U12
+// выполняет многопоточный GEMM, на который приходится почти вся работа.
+// Разложение вычисляется один раз и используется для любого числа правых частей.
+template<typename T>
+class TLUFactorization
+{
+    TDynamicMatrix<T> lu;
+    std::vector<size_t> perm; // строка i результата — строка perm[i] исходной матрицы
+    int sign = 1;
+    bool isSingular = false;
+
+    static const size_t defaultBlockSize = 64;
+
+    // Панель из столбцов [k, k + kb): выбор ведущего элемента по всему столбцу,
+    // перестановка строк целиком и исключение только внутри панели
+    void factorPanel(size_t k, size_t kb)
+    {
+        const size_t n = lu.rows();
+        T* a = lu.data();
+        for (size_t j = k; j < k + kb; j++) {
+            size_t p = j;
+            auto best = std::abs(a[j * n + j]);
+            for (size_t i = j + 1; i < n; i++) {
+                auto v = std::abs(a[i * n + j]);
+                if (v > best) {
+                    best = v;
+                    p = i;
+                }
+            }
+            if (p != j) {
+                std::swap_ranges(a + p * n, a + p * n + n, a + j * n);
+                std::swap(perm[p], perm[j]);
+                sign = -sign;
+            }
+            const T pivot = a[j * n + j];
+            if (pivot == T()) {
+                isSingular = true;
+                continue;
+            }
+            const T* rowJ = a + j * n + j + 1;
+            const size_t width = k + kb - j - 1;
+            utmatrix_detail::TExprEval::forRows(n - j - 1, width + 1, [&](size_t rb, size_t re) {
+                for (size_t i = j + 1 + rb; i < j + 1 + re; i++) {
+                    T* rowI = a + i * n + j;
+                    rowI[0] /= pivot;
+                    utmatrix_detail::TExprEval::axpy(T() - rowI[0], rowJ, rowI + 1, width);
+                }
+            });
+        }
+    }
+
+    void factor(size_t nb)
+    {
+        const size_t n = lu.rows();
+        T* a = lu.data();
+        for (size_t k = 0; k < n; k += nb) {
+            const size_t kb = std::min(nb, n - k);
+            factorPanel(k, kb);
+            const size_t rest = n - k - kb;
+            if (rest == 0) break;
+            // U12 = L11^-1 * A12: прямая подстановка по строкам панели
+            for (size_t i = k + 1; i < k + kb; i++)
+                for (size_t p = k; p < i; p++)
+                    utmatrix_detail::TExprEval::axpy(T() - a[i * n + p], a + p * n + k + kb, a + i * n + k + kb, rest);
+            // A22 -= L21 * U12
+            gemm(rest, rest, kb, T(-1), a + (k + kb) * n + k, ptrdiff_t(n), ptrdiff_t(1),
+                 a + k * n + k + kb, ptrdiff_t(n), ptrdiff_t(1), T(1), a + (k + kb) * n + k + kb, n);
+        }
+    }
+
+    void checkSolvable(size_t rhsRows) const
+    {
+        if (rhsRows != lu.rows()) throw invalid_argument("Размер правой части должен совпадать с порядком матрицы");
+        if (isSingular) throw invalid_argument("Матрица вырождена");
+    }
+
+    // Решение L U X = X для столбцов [cb, ce) матрицы X (шаг строк ldx) на месте
+    void substitute(T* x, size_t ldx, size_t cb, size_t ce) const
+    {
+        const size_t n = lu.rows();
+        const T* a = lu.data();
+        const size_t w = ce - cb;
+        for (size_t i = 1; i < n; i++)
+            for (size_t p = 0; p < i; p++)
+                utmatrix_detail::TExprEval::axpy(T() - a[i * n + p], x + p * ldx + cb, x + i * ldx + cb, w);
+        for (size_t i = n; i-- > 0;) {
+            for (size_t p = i + 1; p < n; p++)
+                utmatrix_detail::TExprEval::axpy(T() - a[i * n + p], x + p * ldx + cb, x + i * ldx + cb, w);
+            const T d = a[i * n + i];
+            for (size_t j = cb; j < ce; j++)
+                x[i * ldx + j] /= d;
+        }
+    }
+
+public:
+    explicit TLUFactorization(const TDynamicMatrix<T>& a, size_t blockSize = defaultBlockSize) : lu(a), perm(a.rows())
+    {
+        if (a.rows() != a.cols()) throw invalid_argument("Матрица должна быть квадратной");
+        for (size_t i = 0; i < perm.size(); i++) perm[i] = i;
+        factor(std::max<size_t>(1, blockSize));
+    }
+
+    size_t size() const noexcept { return lu.rows(); }
+    bool singular() const noexcept { return isSingular; }
+
+    // Множители L (ниже диагонали) и U (на диагонали и выше) в одной матрице
+    const TDynamicMatrix<T>& factors() const noexcept { return lu; }
+    const std::vector<size_t>& permutation() const noexcept { return perm; }
+
+    T determinant() const
+    {
+        T det = T(sign);
+        for (size_t i = 0; i < lu.rows(); i++)
+            det *= lu(i, i);
+        return det;
+    }
+
+    TDynamicVector<T> solve(const TDynamicVector<T>& b) const
+    {
+        checkSolvable(b.size());
+        const size_t n = lu.rows();
+        const T* a = lu.data();
+        TDynamicVector<T> x(n, uninitialized);
+        for (size_t i = 0; i < n; i++)
+            x(i) = b(perm[i]);
+        T* px = x.data();
+        for (size_t i = 1; i < n; i++)
+            px[i] -= utmatrix_detail::TExprEval::dot(a + i * n, px, i);
+        for (size_t i = n; i-- > 0;) {
+            const size_t tail = n - i - 1;
+            if (tail > 0)
+                px[i] -= utmatrix_detail::TExprEval::dot(a + i * n + i + 1, px + i + 1, tail);
+            px[i] /= a[i * n + i];
+        }
+        return x;
+    }
+
+    // Несколько правых частей — столбцы B; потоки делят столбцы между собой
+    TDynamicMatrix<T> solve(const TDynamicMatrix<T>& b) const
+    {
+        checkSolvable(b.rows());
+        const size_t n = lu.rows(), m = b.cols();
+        TDynamicMatrix<T> x(n, m, uninitialized);
+        for (size_t i = 0; i < n; i++)
+            std::copy_n(b.data() + perm[i] * b.stride(), m, x.data() + i * m);
+        const size_t grain = std::max<size_t>(16, m / (4 * TThreadPool::instance().threadCount()) + 1);
+        TThreadPool::instance().parallelFor(0, m, grain, [&](size_t cb, size_t ce) {
+            substitute(x.data(), m, cb, ce);
+        });
+        return x;
+    }
+};
+
+// Разложение Холецкого симметричной положительно определённой матрицы: A = L L^T.
+// Используется только нижний треугольник A. Разложение блочное (right-looking):
+// диагональный блок раскладывается поэлементно, блок L21 находится подстановкой,
+// а оставшаяся подматрица обновляется A22 -= L21 * L21^T вызовами GEMM только
+// для нижней трапеции блочных строк, поэтому работы вдвое меньше, чем у LU.
+// Множитель L хранится в упакованной треугольной матрице.
+template<typename T>
+class TCholeskyFactorization
+{
+    TLowerTriangularMatrix<T> l;
+
+    static const size_t defaultBlockSize = 64;
+
+    static void notPositiveDefinite()
+    {
+        throw invalid_argument("Матрица не является положительно определённой");
+    }
+
+    // Разложение на месте нижнего треугольника плотной матрицы a порядка n
+    static void decompose(T* a, size_t n, size_t nb)
+    {
+        for (size_t k = 0; k < n; k += nb) {
+            const size_t kb = std::min(nb, n - k);
+            // L11: столбцовый вариант внутри диагонального блока
+            for (size_t j = k; j < k + kb; j++) {
+                T* rowJ = a + j * n;
+                const T d = rowJ[j] - utmatrix_detail::TExprEval::dot(rowJ + k, rowJ + k, j - k);
+                if (!(d > T())) notPositiveDefinite();
+                rowJ[j] = std::sqrt(d);
+                for (size_t i = j + 1; i < k + kb; i++) {
+                    T* rowI = a + i * n;
+                    rowI[j] = (rowI[j] - utmatrix_detail::TExprEval::dot(rowI + k, rowJ + k, j - k)) / rowJ[j];
+                }
+            }
+            const size_t rest = n - k - kb;
+            if (rest == 0) break;
+            // L21 = A21 * L11^-T: строки независимы и делятся между потоками
+            utmatrix_detail::TExprEval::forRows(rest, kb * kb / 2 + 1, [&](size_t rb, size_t re) {
+                for (size_t i = k + kb + rb; i < k + kb + re; i++) {
+                    T* rowI = a + i * n;
+                    for (size_t j = k; j < k + kb; j++) {
+                        const T* rowJ = a + j * n;
+                        rowI[j] = (rowI[j] - utmatrix_detail::TExprEval::dot(rowI + k, rowJ + k, j - k)) / rowJ[j];
+                    }
+                }
+            });
+            // A22 -= L21 * L21^T по блочным строкам высотой nb, только до диагонали
+            const T* l21 = a + (k + kb) * n + k;
+            for (size_t r = 0; r < rest; r += nb) {
+                const size_t h = std::min(nb, rest - r);
+                gemm(h, r + h, kb, T(-1), l21 + r * n, ptrdiff_t(n), ptrdiff_t(1),
+                     l21, ptrdiff_t(1), ptrdiff_t(n), T(1), a + (k + kb + r) * n + k + kb, n);
+            }
+        }
+    }
+
+    // Разложение идёт в рабочей плотной копии, после чего упаковывается
+    static TLowerTriangularMatrix<T> decompose(const TDynamicMatrix<T>& a, size_t blockSize)
+    {
+        if (a.rows() != a.cols()) throw invalid_argument("Матрица должна быть квадратной");
+        TDynamicMatrix<T> work(a);
+        decompose(work.data(), work.rows(), std::max<size_t>(1, blockSize));
+        return TLowerTriangularMatrix<T>(work);
+    }
+
+public:
+    explicit TCholeskyFactorization(const TDynamicMatrix<T>& a, size_t blockSize = defaultBlockSize)
+        : l(decompose(a, blockSize)) {}
+
+    size_t size() const noexcept { return l.size(); }
+    const TLowerTriangularMatrix<T>& factor() const noexcept { return l; }
+
+    T determinant() const
+    {
+        T det = T(1);
+        for (size_t i = 0; i < l.size(); i++)
+            det *= l(i, i) * l(i, i);
+        return det;
+    }
+
+    // A x = b: L y = b, затем L^T x = y
+    TDynamicVector<T> solve(const TDynamicVector<T>& b) const
+    {
+        return l.solveTransposed(l.solve(b));
+    }
+
+    TDynamicMatrix<T> solve(const TDynamicMatrix<T>& b) const
+    {
+        return l.solveTransposed(l.solve(b));
+    }
+};
+
+// QR-разложение отражениями Хаусхолдера: A = Q R для m x n матрицы при m >= n.
+// Векторы отражений хранятся под диагональю на месте A (единица на диагонали
+// подразумевается), R — на диагонали и выше. Разложение блочное: панель из nb
+// столбцов раскладывается по одному отражению, после чего произведение отражений
+// панели записывается в компактной WY-форме H = I - V T V^T (T — верхняя
+// треугольная nb x nb), и обновление оставшихся столбцов сводится к GEMM.
+// Матрицы T хранятся для каждой панели и используются при умножении на Q и Q^T.
+template<typename T>
+class TQRFactorization
+{
+    TDynamicMatrix<T> qr;
+    TDynamicMatrix<T> tf;  // T панели со столбцов [k, k + nb) — в столбцах [k, k + nb) строк [0, nb)
+    size_t nb;
+    bool rankDeficient = false;
+
+    static const size_t defaultBlockSize = 32;
+
+    // Отражения для столбцов [k, k + kb) по одному: x -> beta e1, tau = (beta - alpha) / beta
+    void factorPanel(size_t k, size_t kb)
+    {
+        const size_t m = qr.rows(), n = qr.cols();
+        T* a = qr.data();
+        TDynamicVector<T> w(kb);
+        for (size_t j = k; j < k + kb; j++) {
+            T* tau = tf.data() + (j - k) * n + j;
+            const T alpha = a[j * n + j];
+            T sigma = T();
+            for (size_t i = j + 1; i < m; i++)
+                sigma += a[i * n + j] * a[i * n + j];
+            if (sigma == T()) {
+                *tau = T();
+                continue;
+            }
+            T beta = std::sqrt(alpha * alpha + sigma);
+            if (alpha > T()) beta = -beta;
+            *tau = (beta - alpha) / beta;
+            const T scale = T(1) / (alpha - beta);
+            for (size_t i = j + 1; i < m; i++)
+                a[i * n + j] *= scale;
+            a[j * n + j] = beta;
+
+            // Остальные столбцы панели: A -= tau v (v^T A)
+            const size_t width = k + kb - j - 1;
+            if (width == 0) continue;
+            T* pw = w.data();
+            std::copy_n(a + j * n + j + 1, width, pw);
+            for (size_t i = j + 1; i < m; i++)
+                utmatrix_detail::TExprEval::axpy(a[i * n + j], a + i * n + j + 1, pw, width);
+            const T t = *tau;
+            utmatrix_detail::TExprEval::axpy(T() - t, pw, a + j * n + j + 1, width);
+            utmatrix_detail::TExprEval::forRows(m - j - 1, width + 1, [&](size_t rb, size_t re) {
+                for (size_t i = j + 1 + rb; i < j + 1 + re; i++)
+                    utmatrix_detail::TExprEval::axpy(T() - t * a[i * n + j], pw, a + i * n + j + 1, width);
+            });
+        }
+    }
+
+    // T панели: T(0:i, i) = -tau_i T(0:i, 0:i) V(:, 0:i)^T v_i через матрицу Грама V^T V
+    void formBlockReflector(size_t k, size_t kb)
+    {
+        const size_t m = qr.rows(), n = qr.cols();
+        const T* v = qr.data() + k * n + k;
+        const size_t below = m - k - kb;
+        TDynamicMatrix<T> g(kb, kb);
+        if (below > 0)
+            gemm(kb, kb, below, T(1), v + kb * n, ptrdiff_t(1), ptrdiff_t(n),
+                 v + kb * n, ptrdiff_t(n), ptrdiff_t(1), T(0), g.data(), kb);
+        for (size_t r = 0; r < kb; r++)
+            for (size_t q = 0; q <= r; q++)
+                for (size_t i = q; i <= r; i++)
+                    g(q, i) += (r == q ? T(1) : v[r * n + q]) * (r == i ? T(1) : v[r * n + i]);
+        T* t = tf.data() + k;
+        for (size_t i = 0; i < kb; i++) {
+            const T tau = t[i * n + i];
+            for (size_t q = 0; q < i; q++) {
+                T z = T();
+                for (size_t s = q; s < i; s++)
+                    z += t[q * n + s] * g(s, i);
+                t[q * n + i] = T() - tau * z;
+            }
+        }
+    }
+
+    // C -= V T' V^T C для панели [k, k + kb), где T' = T^T при transposed (умножение на Q^T)
+    // и T' = T иначе (умножение на Q); c указывает на строку k матрицы из nc столбцов
+    void applyBlock(size_t k, size_t kb, T* c, size_t ldc, size_t nc, bool transposed) const
+    {
+        const size_t m = qr.rows(), n = qr.cols();
+        const T* v = qr.data() + k * n + k;
+        const T* t = tf.data() + k;
+        const size_t below = m - k - kb;
+        TDynamicMatrix<T> w(kb, nc);
+        T* pw = w.data();
+        // W = V^T C: плотная часть V2 через GEMM, единичная треугольная V1 — построчно
+        if (below > 0)
+            gemm(kb, nc, below, T(1), v + kb * n, ptrdiff_t(1), ptrdiff_t(n),
+                 c + kb * ldc, ptrdiff_t(ldc), ptrdiff_t(1), T(0), pw, nc);
+        for (size_t i = 0; i < kb; i++) {
+            const T* ci = c + i * ldc;
+            utmatrix_detail::TExprEval::axpy(T(1), ci, pw + i * nc, nc);
+            for (size_t p = 0; p < i; p++)
+                utmatrix_detail::TExprEval::axpy(v[i * n + p], ci, pw + p * nc, nc);
+        }
+        // W = T' W на месте: порядок обхода строк не затирает ещё нужные строки
+        if (transposed) {
+            for (size_t p = kb; p-- > 0;) {
+                utmatrix_detail::TExprEval::scalar(pw + p * nc, t[p * n + p], pw + p * nc, nc, TMulOp());
+                for (size_t q = 0; q < p; q++)
+                    utmatrix_detail::TExprEval::axpy(t[q * n + p], pw + q * nc, pw + p * nc, nc);
+            }
+        }
+        else {
+            for (size_t p = 0; p < kb; p++) {
+                utmatrix_detail::TExprEval::scalar(pw + p * nc, t[p * n + p], pw + p * nc, nc, TMulOp());
+                for (size_t q = p + 1; q < kb; q++)
+                    utmatrix_detail::TExprEval::axpy(t[p * n + q], pw + q * nc, pw + p * nc, nc);
+            }
+        }
+        // C -= V W
+        if (below > 0)
+            gemm(below, nc, kb, T(-1), v + kb * n, ptrdiff_t(n), ptrdiff_t(1),
+                 pw, ptrdiff_t(nc), ptrdiff_t(1), T(1), c + kb * ldc, ldc);
+        for (size_t i = 0; i < kb; i++) {
+            T* ci = c + i * ldc;
+            utmatrix_detail::TExprEval::axpy(T(-1), pw + i * nc, ci, nc);
+            for (size_t p = 0; p < i; p++)
+                utmatrix_detail::TExprEval::axpy(T() - v[i * n + p], pw + p * nc, ci, nc);
+        }
+    }
+
+    void factor()
+    {
+        const size_t n = qr.cols();
+        for (size_t k = 0; k < n; k += nb) {
+            const size_t kb = std::min(nb, n - k);
+            factorPanel(k, kb);
+            formBlockReflector(k, kb);
+            const size_t rest = n - k - kb;
+            if (rest > 0)
+                applyBlock(k, kb, qr.data() + k * n + k + kb, n, rest, true);
+        }
+        for (size_t i = 0; i < n; i++)
+            if (qr(i, i) == T()) rankDeficient = true;
+    }
+
+    // Q^T C (transposed) или Q C на месте для матрицы из m строк
+    void apply(T* c, size_t ldc, size_t nc, bool transposed) const
+    {
+        const size_t n = qr.cols();
+        const size_t blocks = (n + nb - 1) / nb;
+        for (size_t b = 0; b < blocks; b++) {
+            const size_t k = (transposed ? b : blocks - 1 - b) * nb;
+            applyBlock(k, std::min(nb, n - k), c + k * ldc, ldc, nc, transposed);
+        }
+    }
+
+    void checkRows(size_t rhsRows) const
+    {
+        if (rhsRows != qr.rows()) throw invalid_argument("Число строк правой части должно совпадать с числом строк матрицы");
+    }
+
+    void checkSolvable(size_t rhsRows) const
+    {
+        checkRows(rhsRows);
+        if (rankDeficient) throw invalid_argument("Матрица не имеет полного столбцового ранга");
+    }
+
+    // R x = y для первых n строк y (шаг строк ldy, nc столбцов) на месте
+    void backSubstitute(T* y, size_t ldy, size_t nc) const
+    {
+        const size_t n = qr.cols();
+        const T* a = qr.data();
+        for (size_t i = n; i-- > 0;) {
+            T* yi = y + i * ldy;
+            for (size_t p = i + 1; p < n; p++)
+                utmatrix_detail::TExprEval::axpy(T() - a[i * n + p], y + p * ldy, yi, nc);
+            utmatrix_detail::TExprEval::scalar(yi, T(1) / a[i * n + i], yi, nc, TMulOp());
+        }
+    }
+
+    void init()
+    {
+        if (qr.rows() < qr.cols()) throw invalid_argument("Число строк должно быть не меньше числа столбцов");
+        nb = std::max<size_t>(1, std::min(nb, qr.cols()));
+        tf = TDynamicMatrix<T>(nb, qr.cols());
+        factor();
+    }
+
+public:
+    explicit TQRFactorization(const TDynamicMatrix<T>& a, size_t blockSize = defaultBlockSize)
+        : qr(a), tf(1, 1), nb(blockSize) { init(); }
+    // Без копирования: разложение выполняется в памяти a
+    explicit TQRFactorization(TDynamicMatrix<T>&& a, size_t blockSize = defaultBlockSize)
+        : qr(std::move(a)), tf(1, 1), nb(blockSize) { init(); }
+
+    size_t rows() const noexcept { return qr.rows(); }
+    size_t cols() const noexcept { return qr.cols(); }
+    bool fullRank() const noexcept { return !rankDeficient; }
 
-template<typename T>
-class TDynamicVector
-{
-protected:
-    size_t sz;
-    T* pMem;
+    // Векторы отражений (под диагональю) и R (на диагонали и выше) в одной матрице
+    const TDynamicMatrix<T>& factors() const noexcept { return qr; }
 
-public:
-    TDynamicVector(size_t size = 1) : sz(size) {
-        if (sz == 0 || sz > MAX_VECTOR_SIZE)
-            throw out_of_range("Вектор должен быть больше нуля, но меньше максимального значения");
-        pMem = new T[sz]();
+    TUpperTriangularMatrix<T> r() const
+    {
+        const size_t n = qr.cols();
+        TUpperTriangularMatrix<T> res(n, uninitialized);
+        for (size_t i = 0; i < n; i++)
+            std::copy_n(qr.data() + i * n + i, n - i, res.rowData(i));
+        return res;
     }
 
-    TDynamicVector(T* arr, size_t s) : sz(s)
+    // Экономная Q: первые n столбцов, m x n
+    TDynamicMatrix<T> q() const
     {
-        assert(arr != nullptr && "Конструктор TDynamicVector требует ненулевой аргумент");
-        pMem = new T[sz];
-        std::copy(arr, arr + sz, pMem);
+        TDynamicMatrix<T> res(qr.rows(), qr.cols());
+        for (size_t i = 0; i < qr.cols(); i++)
+            res(i, i) = T(1);
+        apply(res.data(), res.stride(), res.cols(), false);
+        return res;
     }
 
-    TDynamicVector(const TDynamicVector& v) : sz(v.sz)
+    TDynamicVector<T> multiplyQ(const TDynamicVector<T>& b) const
     {
-        pMem = new T[sz];
-        std::copy(v.pMem, v.pMem + sz, pMem);
+        checkRows(b.size());
+        TDynamicVector<T> res(b);
+        apply(res.data(), 1, 1, false);
+        return res;
     }
 
-    TDynamicVector(TDynamicVector&& v) noexcept : sz(v.sz), pMem(v.pMem)
+    TDynamicMatrix<T> multiplyQ(const TDynamicMatrix<T>& b) const
     {
-        v.sz = 0;
-        v.pMem = nullptr;
+        checkRows(b.rows());
+        TDynamicMatrix<T> res(b);
+        apply(res.data(), res.stride(), res.cols(), false);
+        return res;
     }
 
-    ~TDynamicVector()
+    TDynamicVector<T> multiplyQt(const TDynamicVector<T>& b) const
     {
-        delete[] pMem;
+        checkRows(b.size());
+        TDynamicVector<T> res(b);
+        apply(res.data(), 1, 1, true);
+        return res;
     }
 
-    TDynamicVector& operator=(const TDynamicVector& v)
+    TDynamicMatrix<T> multiplyQt(const TDynamicMatrix<T>& b) const
     {
-        if (this != &v) {
-            delete[] pMem;
-            sz = v.sz;
-            pMem = new T[sz];
-            std::copy(v.pMem, v.pMem + sz, pMem);
-        }
-        return *this;
+        checkRows(b.rows());
+        TDynamicMatrix<T> res(b);
+        apply(res.data(), res.stride(), res.cols(), true);
+        return res;
     }
 
-    TDynamicVector& operator=(TDynamicVector&& v) noexcept
+    // Решение задачи наименьших квадратов min ||A x - b||: R x = (Q^T b)[0:n]
+    TDynamicVector<T> solve(const TDynamicVector<T>& b) const
     {
-        if (this != &v) {
-            delete[] pMem;
-            sz = v.sz;
-            pMem = v.pMem;
-            v.sz = 0;
-            v.pMem = nullptr;
-        }
-        return *this;
+        checkSolvable(b.size());
+        TDynamicVector<T> y = multiplyQt(b);
+        backSubstitute(y.data(), 1, 1);
+        TDynamicVector<T> x(qr.cols(), uninitialized);
+        std::copy_n(y.data(), qr.cols(), x.data());
+        return x;
     }
 
-    size_t size() const noexcept { return sz; }
+    TDynamicMatrix<T> solve(const TDynamicMatrix<T>& b) const
+    {
+        checkSolvable(b.rows());
+        TDynamicMatrix<T> y = multiplyQt(b);
+        backSubstitute(y.data(), y.stride(), y.cols());
+        TDynamicMatrix<T> x(qr.cols(), b.cols(), uninitialized);
+        std::copy_n(y.data(), x.rows() * x.cols(), x.data());
+        return x;
+    }
+};
 
-    T& operator[](size_t ind) {
-        if (ind >= sz) throw out_of_range("Индекс вне диапазона");
-        return pMem[ind];
+// TSQR — QR-разложение высокой узкой матрицы (m >> n). Строки делятся на блоки
+// не меньше n строк, каждый блок раскладывается независимо в своём потоке,
+// затем раскладывается матрица из уложенных друг на друга R блоков:
+// A = diag(Q_1, ..., Q_p) Q_0 R. Последовательной остаётся только работа
+// порядка p n^3 на малой матрице.
+template<typename T>
+class TTallSkinnyQR
+{
+    std::vector<std::unique_ptr<TQRFactorization<T>>> leaves;
+    std::unique_ptr<TQRFactorization<T>> root;
+    size_t m, n, leafRows;
+
+    size_t leafBegin(size_t i) const noexcept { return i * leafRows; }
+    size_t leafEnd(size_t i) const noexcept { return i + 1 == leaves.size() ? m : (i + 1) * leafRows; }
+
+    template<typename F>
+    void forLeaves(F&& f) const
+    {
+        TThreadPool::instance().parallelFor(0, leaves.size(), 1, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; i++)
+                f(i);
+        });
     }
 
-    const T& operator[](size_t ind) const {
-        if (ind >= sz) throw out_of_range("Индекс вне диапазона");
-        return pMem[ind];
+    // Первые n строк Q_i^T B_i каждого блока, уложенные друг на друга
+    TDynamicMatrix<T> reduce(const TDynamicMatrix<T>& b) const
+    {
+        if (b.rows() != m) throw invalid_argument("Число строк правой части должно совпадать с числом строк матрицы");
+        const size_t nc = b.cols();
+        TDynamicMatrix<T> stacked(leaves.size() * n, nc, uninitialized);
+        forLeaves([&](size_t i) {
+            TDynamicMatrix<T> part(leafEnd(i) - leafBegin(i), nc, uninitialized);
+            std::copy_n(b.data() + leafBegin(i) * b.stride(), part.rows() * nc, part.data());
+            part = leaves[i]->multiplyQt(part);
+            std::copy_n(part.data(), n * nc, stacked.data() + i * n * nc);
+        });
+        return stacked;
     }
 
-    T& at(size_t ind)
+public:
+    // blockRows = 0 — по одному блоку строк на поток пула
+    explicit TTallSkinnyQR(const TDynamicMatrix<T>& a, size_t blockRows = 0)
+        : m(a.rows()), n(a.cols())
     {
-        if (ind >= sz) throw out_of_range("Индекс вне диапазона");
-        return pMem[ind];
+        if (m < n) throw invalid_argument("Число строк должно быть не меньше числа столбцов");
+        if (blockRows == 0) {
+            const size_t threads = TThreadPool::instance().threadCount();
+            blockRows = (m + threads - 1) / threads;
+        }
+        leafRows = std::max(blockRows, n);
+        leaves.resize(std::max<size_t>(1, m / leafRows));
+        TDynamicMatrix<T> stacked(leaves.size() * n, n);
+        forLeaves([&](size_t i) {
+            TDynamicMatrix<T> part(leafEnd(i) - leafBegin(i), n, uninitialized);
+            std::copy_n(a.data() + leafBegin(i) * a.stride(), part.rows() * n, part.data());
+            leaves[i].reset(new TQRFactorization<T>(std::move(part)));
+            const T* f = leaves[i]->factors().data();
+            for (size_t r = 0; r < n; r++)
+                std::copy_n(f + r * n + r, n - r, stacked.data() + (i * n + r) * n + r);
+        });
+        root.reset(new TQRFactorization<T>(std::move(stacked)));
     }
 
-    const T& at(size_t ind) const {
-        if (ind >= sz) throw out_of_range("Индекс вне диапазона");
-        return pMem[ind];
+    size_t rows() const noexcept { return m; }
+    size_t cols() const noexcept { return n; }
+    size_t leafCount() const noexcept { return leaves.size(); }
+    bool fullRank() const noexcept { return root->fullRank(); }
+
+    TUpperTriangularMatrix<T> r() const { return root->r(); }
+
+    // Экономная Q, m x n: блок i равен Q_i [Q_0 (блок i); 0]
+    TDynamicMatrix<T> q() const
+    {
+        const TDynamicMatrix<T> q0 = root->q();
+        TDynamicMatrix<T> res(m, n, uninitialized);
+        forLeaves([&](size_t i) {
+            TDynamicMatrix<T> part(leafEnd(i) - leafBegin(i), n);
+            std::copy_n(q0.data() + i * n * n, n * n, part.data());
+            part = leaves[i]->multiplyQ(part);
+            std::copy_n(part.data(), part.rows() * n, res.data() + leafBegin(i) * n);
+        });
+        return res;
     }
 
-    bool operator==(const TDynamicVector& v) const noexcept
+    TDynamicVector<T> solve(const TDynamicVector<T>& b) const
     {
-        if (sz != v.sz) return false;
-        return std::equal(pMem, pMem + sz, v.pMem);
+        if (b.size() != m) throw invalid_argument("Число строк правой части должно совпадать с числом строк матрицы");
+        TDynamicMatrix<T> col(m, 1, uninitialized);
+        std::copy_n(b.data(), m, col.data());
+        TDynamicMatrix<T> x = root->solve(reduce(col));
+        TDynamicVector<T> res(n, uninitialized);
+        std::copy_n(x.data(), n, res.data());
+        return res;
     }
 
-    bool operator!=(const TDynamicVector& v) const noexcept
+    TDynamicMatrix<T> solve(const TDynamicMatrix<T>& b) const
     {
-        return !(*this == v);
+        return root->solve(reduce(b));
+    }
+};
+
+// Двоичный формат матриц. Файл начинается с заголовка из 64 байт, за ним после
+// выравнивания до dataOffset идут элементы по строкам без разделителей.
+// Все поля заголовка записываются в порядке байтов записавшей системы;
+// byteOrder позволяет читателю обнаружить обратный порядок и переставить байты.
+enum class TBinaryType : std::uint32_t { Int32 = 1, Int64 = 2, Float32 = 3, Float64 = 4 };
+
+template<typename T> struct TBinaryTypeOf;
+template<> struct TBinaryTypeOf<std::int32_t> { static constexpr TBinaryType value = TBinaryType::Int32; };
+template<> struct TBinaryTypeOf<std::int64_t> { static constexpr TBinaryType value = TBinaryType::Int64; };
+template<> struct TBinaryTypeOf<float> { static constexpr TBinaryType value = TBinaryType::Float32; };
+template<> struct TBinaryTypeOf<double> { static constexpr TBinaryType value = TBinaryType::Float64; };
+
+struct TBinaryHeader
+{
+    static constexpr std::uint32_t currentVersion = 1;
+    static constexpr std::uint32_t nativeByteOrder = 0x01020304;
+
+    char magic[8];            // "UTMATRIX"
+    std::uint32_t version;
+    std::uint32_t byteOrder;  // 0x01020304 в порядке байтов записавшей системы
+    std::uint32_t dtype;      // TBinaryType
+    std::uint32_t elemSize;
+    std::uint32_t alignment;  // dataOffset кратен alignment
+    std::uint32_t reserved0;
+    std::uint64_t rows;
+    std::uint64_t cols;
+    std::uint64_t dataOffset;
+    std::uint64_t reserved1;
+};
+
+static_assert(sizeof(TBinaryHeader) == 64, "Заголовок двоичного формата должен занимать 64 байта");
+
+namespace utmatrix_detail {
+
+template<typename U>
+U byteSwapped(U v) noexcept
+{
+    unsigned char* p = reinterpret_cast<unsigned char*>(&v);
+    std::reverse(p, p + sizeof(U));
+    return v;
+}
+
+inline void byteSwapElements(void* data, size_t count, size_t elemSize) noexcept
+{
+    unsigned char* p = static_cast<unsigned char*>(data);
+    for (size_t i = 0; i < count; i++, p += elemSize)
+        std::reverse(p, p + elemSize);
+}
+
+template<typename T>
+TBinaryHeader makeBinaryHeader(size_t rows, size_t cols)
+{
+    TBinaryHeader h = {};
+    std::memcpy(h.magic, "UTMATRIX", 8);
+    h.version = TBinaryHeader::currentVersion;
+    h.byteOrder = TBinaryHeader::nativeByteOrder;
+    h.dtype = std::uint32_t(TBinaryTypeOf<T>::value);
+    h.elemSize = sizeof(T);
+    h.alignment = MEM_ALIGNMENT;
+    h.rows = rows;
+    h.cols = cols;
+    h.dataOffset = (sizeof(TBinaryHeader) + MEM_ALIGNMENT - 1) / MEM_ALIGNMENT * MEM_ALIGNMENT;
+    return h;
+}
+
+// Проверка заголовка; при обратном порядке байтов поля переставляются,
+// а возвращаемое значение сообщает, что переставлять нужно и данные
+template<typename T>
+bool checkBinaryHeader(TBinaryHeader& h)
+{
+    if (std::memcmp(h.magic, "UTMATRIX", 8) != 0) throw invalid_argument("Неверный формат файла матрицы");
+    const bool swapped = h.byteOrder == byteSwapped(TBinaryHeader::nativeByteOrder);
+    if (!swapped && h.byteOrder != TBinaryHeader::nativeByteOrder) throw invalid_argument("Неверный формат файла матрицы");
+    if (swapped) {
+        for (std::uint32_t* f : { &h.version, &h.byteOrder, &h.dtype, &h.elemSize, &h.alignment })
+            *f = byteSwapped(*f);
+        for (std::uint64_t* f : { &h.rows, &h.cols, &h.dataOffset })
+            *f = byteSwapped(*f);
     }
+    if (h.version == 0 || h.version > TBinaryHeader::currentVersion) throw invalid_argument("Неподдерживаемая версия формата матрицы");
+    if (h.dtype != std::uint32_t(TBinaryTypeOf<T>::value) || h.elemSize != sizeof(T))
+        throw invalid_argument("Тип элементов файла не совпадает с типом матрицы");
+    if (h.rows == 0 || h.cols == 0 || h.dataOffset < sizeof(TBinaryHeader)) throw invalid_argument("Неверный формат файла матрицы");
+    if (h.cols > SIZE_MAX / sizeof(T) / h.rows) throw invalid_argument("Размер матрицы в файле слишком велик");
+    return swapped;
+}
+
+// Отображение файла в память только для чтения
+class TFileMapping
+{
+    const unsigned char* addr = nullptr;
+    size_t len = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
 
-    TDynamicVector operator+(T val) const
+    void release() noexcept
     {
-        TDynamicVector result(sz);
-        std::transform(pMem, pMem + sz, result.pMem, [val](T elem) { return elem + val; });
-        return result;
+#ifdef _WIN32
+        if (addr) UnmapViewOfFile(addr);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        file = INVALID_HANDLE_VALUE;
+        mapping = nullptr;
+#else
+        if (addr) munmap(const_cast<unsigned char*>(addr), len);
+#endif
+        addr = nullptr;
+        len = 0;
     }
 
-    TDynamicVector operator-(T val) const
+public:
+    explicit TFileMapping(const string& path)
     {
-        TDynamicVector result(sz);
-        std::transform(pMem, pMem + sz, result.pMem, [val](T elem) { return elem - val; });
-        return result;
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) throw runtime_error("Не удалось открыть файл " + path);
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size)) {
+            release();
+            throw runtime_error("Не удалось определить размер файла " + path);
+        }
+        len = size_t(size.QuadPart);
+        if (len > 0) {
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            addr = mapping ? static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+            if (!addr) {
+                release();
+                throw runtime_error("Не удалось отобразить файл " + path);
+            }
+        }
+#else
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw runtime_error("Не удалось открыть файл " + path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw runtime_error("Не удалось определить размер файла " + path);
+        }
+        len = size_t(st.st_size);
+        if (len > 0) {
+            void* p = ::mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                throw runtime_error("Не удалось отобразить файл " + path);
+            }
+            addr = static_cast<const unsigned char*>(p);
+        }
+        ::close(fd); // отображение остаётся действительным после закрытия дескриптора
+#endif
     }
 
-    TDynamicVector operator*(T val) const
+    TFileMapping(const TFileMapping&) = delete;
+    TFileMapping& operator=(const TFileMapping&) = delete;
+
+    TFileMapping(TFileMapping&& m) noexcept
+        : addr(m.addr), len(m.len)
+#ifdef _WIN32
+        , file(m.file), mapping(m.mapping)
+#endif
     {
-        TDynamicVector result(sz);
-        std::transform(pMem, pMem + sz, result.pMem, [val](T elem) { return elem * val; });
-        return result;
+        m.addr = nullptr;
+        m.len = 0;
+#ifdef _WIN32
+        m.file = INVALID_HANDLE_VALUE;
+        m.mapping = nullptr;
+#endif
     }
 
-    TDynamicVector operator+(const TDynamicVector& v) const
+    ~TFileMapping() { release(); }
+
+    const unsigned char* data() const noexcept { return addr; }
+    size_t size() const noexcept { return len; }
+};
+
+} // namespace utmatrix_detail
+
+template<typename T, typename A>
+ostream& writeBinary(ostream& ostr, const TDynamicMatrix<T, A>& m)
+{
+    const TBinaryHeader h = utmatrix_detail::makeBinaryHeader<T>(m.rows(), m.cols());
+    ostr.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    for (size_t pad = sizeof(h); pad < h.dataOffset; pad++)
+        ostr.put('\0');
+    for (size_t i = 0; i < m.rows(); i++)
+        ostr.write(reinterpret_cast<const char*>(m.data() + i * m.stride()), std::streamsize(m.cols() * sizeof(T)));
+    return ostr;
+}
+
+// Чтение с копированием: работает и при обратном порядке байтов файла
+template<typename T>
+TDynamicMatrix<T> readBinary(istream& istr)
+{
+    TBinaryHeader h;
+    if (!istr.read(reinterpret_cast<char*>(&h), sizeof(h))) throw invalid_argument("Неверный формат файла матрицы");
+    const bool swapped = utmatrix_detail::checkBinaryHeader<T>(h);
+    istr.ignore(std::streamsize(h.dataOffset - sizeof(h)));
+    TDynamicMatrix<T> m(size_t(h.rows), size_t(h.cols), uninitialized);
+    if (!istr.read(reinterpret_cast<char*>(m.data()), std::streamsize(m.rows() * m.cols() * sizeof(T))))
+        throw invalid_argument("Файл матрицы обрезан");
+    if (swapped)
+        utmatrix_detail::byteSwapElements(m.data(), m.rows() * m.cols(), sizeof(T));
+    return m;
+}
+
+template<typename T, typename A>
+void saveBinary(const string& path, const TDynamicMatrix<T, A>& m)
+{
+    ofstream f(path, ios::binary);
+    if (!f) throw runtime_error("Не удалось создать файл " + path);
+    if (!writeBinary(f, m).flush()) throw runtime_error("Ошибка записи в файл " + path);
+}
+
+template<typename T>
+TDynamicMatrix<T> loadBinary(const string& path)
+{
+    ifstream f(path, ios::binary);
+    if (!f) throw runtime_error("Не удалось открыть файл " + path);
+    return readBinary<T>(f);
+}
+
+// Матрица только для чтения, элементы которой лежат прямо в отображённом в память
+// файле двоичного формата: открытие не читает данные, страницы подгружаются
+// системой при первом обращении. Файл должен иметь порядок байтов системы.
+// Участвует в выражениях и произведениях как обычная плотная матрица.
+template<typename T>
+class TMappedMatrix : public TMatrixExprBase<TMappedMatrix<T>>
+{
+    utmatrix_detail::TFileMapping file;
+    const T* pMem;
+    size_t nRows, nCols;
+
+public:
+    typedef T value_type;
+
+    explicit TMappedMatrix(const string& path) : file(path)
     {
-        if (sz != v.sz) throw invalid_argument("Векторы должны быть одного размера");
-        TDynamicVector result(sz);
-        std::transform(pMem, pMem + sz, v.pMem, result.pMem, std::plus<T>());
-        return result;
+        TBinaryHeader h;
+        if (file.size() < sizeof(h)) throw invalid_argument("Неверный формат файла матрицы");
+        std::memcpy(&h, file.data(), sizeof(h));
+        if (utmatrix_detail::checkBinaryHeader<T>(h))
+            throw invalid_argument("Порядок байтов файла не совпадает с порядком байтов системы");
+        if (h.dataOffset % alignof(T) != 0) throw invalid_argument("Данные в файле не выровнены");
+        if (h.dataOffset > file.size() || h.rows * h.cols * sizeof(T) > file.size() - h.dataOffset)
+            throw invalid_argument("Файл матрицы обрезан");
+        pMem = reinterpret_cast<const T*>(file.data() + h.dataOffset);
+        nRows = size_t(h.rows);
+        nCols = size_t(h.cols);
+    }
+
+    TMappedMatrix(TMappedMatrix&&) = default;
+
+    size_t rows() const noexcept { return nRows; }
+    size_t cols() const noexcept { return nCols; }
+    T eval(size_t i, size_t j) const { return pMem[i * nCols + j]; }
+
+    const T* data() const noexcept { return pMem; }
+    size_t stride() const noexcept { return nCols; }
+
+    TMatrixView<const T> view() const noexcept { return TMatrixView<const T>(pMem, nRows, nCols, nCols); }
+    TMatrixView<const T> block(size_t i, size_t j, size_t r, size_t c) const { return view().block(i, j, r, c); }
+
+    const T& operator()(size_t i, size_t j) const noexcept
+    {
+        assert(i < nRows && j < nCols);
+        return pMem[i * nCols + j];
     }
 
-    TDynamicVector operator-(const TDynamicVector& v) const
+    const T& at(size_t i, size_t j) const
     {
-        if (sz != v.sz) throw invalid_argument("Векторы должны быть одного размера");
-        TDynamicVector result(sz);
-        std::transform(pMem, pMem + sz, v.pMem, result.pMem, std::minus<T>());
-        return result;
+        if (i >= nRows || j >= nCols) throw out_of_range("Индекс вне диапазона");
+        return pMem[i * nCols + j];
     }
 
-    T operator*(const TDynamicVector& v) const noexcept(false) {
-        if (sz != v.sz) {
-            throw std::invalid_argument("Векторы должны быть одного размера");
-        }
+    TDynamicVector<T> multiply(const TDynamicVector<T>& v) const
+    {
+        if (nCols != v.size()) throw invalid_argument("Число столбцов матрицы должно совпадать с размером вектора");
+        TDynamicVector<T> res(nRows, uninitialized);
+        gemv(nRows, nCols, pMem, nCols, v.data(), res.data());
+        return res;
+    }
 
-        T result = T(); // Предполагаем, что T поддерживает оператор сложения и имеет конструктор по умолчанию
-        for (size_t i = 0; i < sz; ++i) {
-            result += pMem[i] * v.pMem[i]; // Умножаем соответствующие элементы
-        }
-        return result; // Возвращаем результат
+    TDynamicVector<T> multiplyTransposed(const TDynamicVector<T>& v) const
+    {
+        if (nRows != v.size()) throw invalid_argument("Число строк матрицы должно совпадать с размером вектора");
+        TDynamicVector<T> res(nCols, uninitialized);
+        gemvTransposed(nRows, nCols, pMem, nCols, v.data(), res.data());
+        return res;
     }
 
-    friend void swap(TDynamicVector& lhs, TDynamicVector& rhs) noexcept
+    template<typename M, typename = typename std::enable_if<TIsDenseMatrix<M>::value>::type>
+    TDynamicMatrix<T> multiply(const M& m) const
     {
-        std::swap(lhs.sz, rhs.sz);
-        std::swap(lhs.pMem, rhs.pMem);
+        if (nCols != m.rows()) throw invalid_argument("Число столбцов первой матрицы должно совпадать с количеством строк второй матрицы");
+        TDynamicMatrix<T> res(nRows, m.cols(), uninitialized);
+        utmatrix_detail::denseProduct(nRows, m.cols(), nCols, pMem, nCols, m.data(), m.stride(), res.data(), res.stride());
+        return res;
     }
+};
 
-    friend istream& operator>>(istream& istr, TDynamicVector& v)
+namespace utmatrix_detail {
+
+// Каталог временных файлов: переменная окружения UTMATRIX_TMPDIR, иначе системный
+inline string temporaryDirectory()
+{
+    if (const char* env = std::getenv("UTMATRIX_TMPDIR"))
+        if (*env) return env;
+#ifdef _WIN32
+    char buf[MAX_PATH + 1];
+    const DWORD n = GetTempPathA(MAX_PATH + 1, buf);
+    return n > 0 && n <= MAX_PATH ? string(buf, n) : string(".");
+#else
+    const char* env = std::getenv("TMPDIR");
+    return env && *env ? string(env) : string("/tmp");
+#endif
+}
+
+// Создаёт пустой файл с уникальным именем в каталоге временных файлов
+inline string createTemporaryFile()
+{
+    const string dir = temporaryDirectory();
+#ifdef _WIN32
+    char path[MAX_PATH + 1];
+    if (!GetTempFileNameA(dir.c_str(), "utm", 0, path)) throw runtime_error("Не удалось создать временный файл в " + dir);
+    return path;
+#else
+    string path = dir + "/utmatrixXXXXXX";
+    const int fd = ::mkstemp(&path[0]);
+    if (fd < 0) throw runtime_error("Не удалось создать временный файл в " + dir);
+    ::close(fd);
+    return path;
+#endif
+}
+
+// Новый временный файл из bytes нулевых байтов, отображённый для чтения и записи.
+// Имя файла удаляется сразу (POSIX) или при снятии отображения (Windows), поэтому
+// файл не переживает процесс.
+inline void* mapTemporaryFile(size_t bytes)
+{
+    const string path = createTemporaryFile();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                              FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+    if (file == INVALID_HANDLE_VALUE) throw runtime_error("Не удалось открыть файл " + path);
+    const std::uint64_t size = bytes;
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, DWORD(size >> 32), DWORD(size & 0xFFFFFFFFu), nullptr);
+    void* p = mapping ? MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes) : nullptr;
+    if (mapping) CloseHandle(mapping);
+    CloseHandle(file); // файл удалится, когда будет снято последнее отображение
+    if (!p) throw std::bad_alloc();
+    return p;
+#else
+    const int fd = ::open(path.c_str(), O_RDWR);
+    ::unlink(path.c_str());
+    if (fd < 0) throw runtime_error("Не удалось открыть файл " + path);
+    void* p = MAP_FAILED;
+    if (off_t(bytes) >= 0 && ::ftruncate(fd, off_t(bytes)) == 0)
+        p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) throw std::bad_alloc();
+    return p;
+#endif
+}
+
+inline void unmapTemporaryFile(void* p, size_t bytes) noexcept
+{
+#ifdef _WIN32
+    (void)bytes;
+    UnmapViewOfFile(p);
+#else
+    ::munmap(p, bytes);
+#endif
+}
+
+} // namespace utmatrix_detail
+
+// Распределитель для данных больше оперативной памяти: каждый буфер размещается
+// в отображённом временном файле, и ОС подкачивает его страницы с диска по мере
+// обращения. С ним векторы, матрицы и все алгоритмы над ними работают вне ядра
+// без изменений; последовательный и блочный доступ здесь гораздо выгоднее
+// произвольного. Адреса выровнены по странице, а значит и по MEM_ALIGNMENT.
+template<typename T>
+struct TFileAllocator
+{
+    typedef T value_type;
+    template<typename U> struct rebind { typedef TFileAllocator<U> other; };
+
+    TFileAllocator() noexcept = default;
+    template<typename U> TFileAllocator(const TFileAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n)
     {
-        for (size_t i = 0; i < v.sz; i++)
-            istr >> v.pMem[i];
-        return istr;
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T)) throw std::bad_array_new_length();
+        return static_cast<T*>(utmatrix_detail::mapTemporaryFile(std::max<size_t>(1, n * sizeof(T))));
     }
 
-    friend ostream& operator<<(ostream& ostr, const TDynamicVector& v)
+    void deallocate(T* p, size_t n) noexcept
     {
-        for (size_t i = 0; i < v.sz; i++)
-            ostr << v.pMem[i] << ' ';
-        return ostr;
+        utmatrix_detail::unmapTemporaryFile(p, std::max<size_t>(1, n * sizeof(T)));
     }
+
+    template<typename U> bool operator==(const TFileAllocator<U>&) const noexcept { return true; }
+    template<typename U> bool operator!=(const TFileAllocator<U>&) const noexcept { return false; }
+};
+
+// Счётчики обменов плиточной матрицы с файлом и попаданий в кэш плиток
+struct TTileIoStats
+{
+    std::uint64_t bytesRead = 0;
+    std::uint64_t bytesWritten = 0;
+    std::uint64_t tileReads = 0;
+    std::uint64_t tileWrites = 0;
+    std::uint64_t cacheHits = 0;
+    std::uint64_t cacheMisses = 0;
 };
 
+// Матрица вне ядра: квадратные плитки tileSize x tileSize (у правого и нижнего
+// краёв — меньше) хранятся во временном файле и подгружаются в кэш из не более
+// чем cacheTiles плиток с вытеснением давно не использованных (LRU). Изменённые
+// плитки записываются в файл при вытеснении и в flush(). Плитка в памяти — обычная
+// TDynamicMatrix; ссылка на неё действительна, пока плитка не вытеснена, то есть
+// не менее чем на cacheTiles - 1 последующих обращений к этой матрице.
+// Ни разу не записанные плитки нулевые и читаются без обращения к файлу.
 template<typename T>
-class TDynamicMatrix : private TDynamicVector<TDynamicVector<T>>
+class TTiledMatrix
 {
-    using TDynamicVector<TDynamicVector<T>>::pMem;
-    using TDynamicVector<TDynamicVector<T>>::sz;
+    struct TSlot
+    {
+        size_t id;
+        TDynamicMatrix<T> tile;
+        bool dirty;
+    };
 
-public:
-    TDynamicMatrix(size_t r = 1, size_t c = 1) : TDynamicVector<TDynamicVector<T>>(r) {
-        if (r == 0 || c == 0 || r > MAX_MATRIX_SIZE || c > MAX_MATRIX_SIZE)
-            throw out_of_range("Размер больше 0 и меньше максимального");
-        for (size_t i = 0; i < r; i++) {
-            pMem[i] = TDynamicVector<T>(c);
-        }
+    // Файл удаляется после закрытия потока: член объявлен раньше потока
+    struct TFileName
+    {
+        string path;
+        explicit TFileName(string p) : path(std::move(p)) {}
+        TFileName(TFileName&& f) noexcept : path(std::move(f.path)) { f.path.clear(); }
+        ~TFileName() { if (!path.empty()) std::remove(path.c_str()); }
+    };
+
+    size_t nRows, nCols, tileSz, nTileRows, nTileCols, capacity;
+    TFileName name;
+    mutable std::fstream file;
+    mutable std::vector<bool> stored;
+    mutable std::list<TSlot> lru; // в начале — последние использованные
+    mutable std::unordered_map<size_t, typename std::list<TSlot>::iterator> index;
+    mutable TTileIoStats ioStats;
+
+    size_t tileHeight(size_t ti) const noexcept { return std::min(tileSz, nRows - ti * tileSz); }
+    size_t tileWidth(size_t tj) const noexcept { return std::min(tileSz, nCols - tj * tileSz); }
+    std::streamoff offset(size_t id) const noexcept { return std::streamoff(id) * std::streamoff(tileSz * tileSz * sizeof(T)); }
+
+    void store(const TSlot& s) const
+    {
+        const size_t bytes = s.tile.rows() * s.tile.cols() * sizeof(T);
+        file.seekp(offset(s.id));
+        if (!file.write(reinterpret_cast<const char*>(s.tile.data()), std::streamsize(bytes)))
+            throw runtime_error("Ошибка записи в файл " + name.path);
+        stored[s.id] = true;
+        ioStats.bytesWritten += bytes;
+        ioStats.tileWrites++;
     }
 
-    size_t rows() const noexcept { return sz; }
-    size_t cols() const noexcept { return (sz > 0) ? pMem[0].size() : 0; } // Изменено для предотвращения доступа к pMem[0] при sz = 0
+    void load(TSlot& s) const
+    {
+        if (!stored[s.id]) {
+            std::fill_n(s.tile.data(), s.tile.rows() * s.tile.cols(), T());
+            return;
+        }
+        const size_t bytes = s.tile.rows() * s.tile.cols() * sizeof(T);
+        file.seekg(offset(s.id));
+        if (!file.read(reinterpret_cast<char*>(s.tile.data()), std::streamsize(bytes)))
+            throw runtime_error("Ошибка чтения из файла " + name.path);
+        ioStats.bytesRead += bytes;
+        ioStats.tileReads++;
+    }
 
-    bool operator==(const TDynamicMatrix& m) const noexcept {
-        if (rows() != m.rows() || cols() != m.cols()) return false;
-        return std::equal(pMem, pMem + rows(), m.pMem);
+    void evict() const
+    {
+        TSlot& s = lru.back();
+        if (s.dirty) store(s);
+        index.erase(s.id);
+        lru.pop_back();
     }
 
-    TDynamicMatrix operator*(const T& val) const {
-        TDynamicMatrix res(rows(), cols());
-        for (size_t i = 0; i < rows(); i++) {
-            for (size_t j = 0; j < cols(); j++) {
-                res[i][j] = pMem[i][j] * val;
+    TSlot& slot(size_t ti, size_t tj) const
+    {
+        if (ti >= nTileRows || tj >= nTileCols) throw out_of_range("Индекс плитки вне диапазона");
+        const size_t id = ti * nTileCols + tj;
+        auto it = index.find(id);
+        if (it != index.end()) {
+            lru.splice(lru.begin(), lru, it->second);
+            ioStats.cacheHits++;
+            return lru.front();
+        }
+        ioStats.cacheMisses++;
+        const size_t h = tileHeight(ti), w = tileWidth(tj);
+        if (lru.size() >= capacity) {
+            // Буфер вытесняемой плитки того же размера используется повторно
+            TSlot& victim = lru.back();
+            if (victim.dirty) store(victim);
+            index.erase(victim.id);
+            if (victim.tile.rows() == h && victim.tile.cols() == w)
+                lru.splice(lru.begin(), lru, std::prev(lru.end()));
+            else {
+                lru.pop_back();
+                lru.push_front(TSlot{ id, TDynamicMatrix<T>(h, w, uninitialized), false });
             }
         }
-        return res;
+        else
+            lru.push_front(TSlot{ id, TDynamicMatrix<T>(h, w, uninitialized), false });
+        TSlot& s = lru.front();
+        s.id = id;
+        s.dirty = false;
+        try {
+            load(s);
+        }
+        catch (...) {
+            lru.pop_front();
+            throw;
+        }
+        index[id] = lru.begin();
+        return s;
     }
 
-    TDynamicVector<T> operator*(const TDynamicVector<T>& v) const {
-        if (cols() != v.size()) throw invalid_argument("Число столбцов матрицы должно совпадать с размером вектора");
-        TDynamicVector<T> res(rows());
-        for (size_t i = 0; i < rows(); i++) {
-            res[i] = 0;
-            for (size_t j = 0; j < cols(); j++) {
-                res[i] += pMem[i][j] * v[j];
+    void checkSameShape(const TTiledMatrix& m) const
+    {
+        if (nRows != m.nRows || nCols != m.nCols) throw invalid_argument("Матрицы должны быть одного размера");
+        if (tileSz != m.tileSz) throw invalid_argument("Размеры плиток должны совпадать");
+    }
+
+    template<typename Op>
+    TTiledMatrix& update(const TTiledMatrix& m, Op)
+    {
+        checkSameShape(m);
+        for (size_t ti = 0; ti < nTileRows; ti++)
+            for (size_t tj = 0; tj < nTileCols; tj++) {
+                const TDynamicMatrix<T>& src = m.tile(ti, tj);
+                TDynamicMatrix<T>& dst = tile(ti, tj);
+                utmatrix_detail::TExprEval::updateMatrix(dst.data(), dst.stride(), src, Op());
             }
-        }
-        return res;
+        return *this;
     }
 
-    TDynamicMatrix operator+(const TDynamicMatrix& m) const {
-        if (rows() != m.rows() || cols() != m.cols()) throw invalid_argument("Матрицы должны быть одного размера");
-        TDynamicMatrix res(rows(), cols());
-        for (size_t i = 0; i < rows(); i++) {
-            res[i] = pMem[i] + m.pMem[i];
-        }
-        return res;
+public:
+    typedef T value_type;
+
+    static constexpr size_t defaultTileSize = 512;
+    static constexpr size_t defaultCacheTiles = 64;
+
+    TTiledMatrix(size_t r, size_t c, size_t tileSize = defaultTileSize, size_t cacheTiles = defaultCacheTiles)
+        : nRows(r), nCols(c), tileSz(tileSize), capacity(cacheTiles), name(utmatrix_detail::createTemporaryFile())
+    {
+        if (r == 0 || c == 0 || tileSize == 0) throw out_of_range("Размер больше 0");
+        if (tileSize > sizeLimits().maxMatrixSize) throw out_of_range("Размер плитки больше максимального");
+        if (cacheTiles < 3) throw invalid_argument("Кэш должен вмещать не менее трёх плиток");
+        nTileRows = (r - 1) / tileSize + 1;
+        nTileCols = (c - 1) / tileSize + 1;
+        stored.assign(utmatrix_detail::checkedMul(nTileRows, nTileCols), false);
+        file.open(name.path, ios::in | ios::out | ios::binary | ios::trunc);
+        if (!file) throw runtime_error("Не удалось открыть файл " + name.path);
     }
 
-    TDynamicMatrix operator-(const TDynamicMatrix& m) const {
-        if (rows() != m.rows() || cols() != m.cols()) throw invalid_argument("Матрицы должны быть одного размера");
-        TDynamicMatrix res(rows(), cols());
-        for (size_t i = 0; i < rows(); i++) {
-            res[i] = pMem[i] - m.pMem[i];
-        }
-        return res;
+    explicit TTiledMatrix(const TDynamicMatrix<T>& m, size_t tileSize = defaultTileSize, size_t cacheTiles = defaultCacheTiles)
+        : TTiledMatrix(m.rows(), m.cols(), tileSize, cacheTiles)
+    {
+        for (size_t ti = 0; ti < nTileRows; ti++)
+            for (size_t tj = 0; tj < nTileCols; tj++)
+                tile(ti, tj) = m.block(ti * tileSz, tj * tileSz, tileHeight(ti), tileWidth(tj));
     }
 
-    TDynamicMatrix operator*(const TDynamicMatrix& m) const {
-        if (cols() != m.rows()) throw invalid_argument("Число столбцов первой матрицы должно совпадать с количеством строк второй матрицы");
-        TDynamicMatrix res(rows(), m.cols());
-        for (size_t i = 0; i < rows(); i++) {
-            for (size_t j = 0; j < m.cols(); j++) {
-                res[i][j] = 0;
-                for (size_t k = 0; k < cols(); k++) {
-                    res[i][j] += pMem[i][k] * m.pMem[k][j];
-                }
+    TTiledMatrix(TTiledMatrix&&) = default;
+    TTiledMatrix(const TTiledMatrix&) = delete;
+    TTiledMatrix& operator=(const TTiledMatrix&) = delete;
+
+    size_t rows() const noexcept { return nRows; }
+    size_t cols() const noexcept { return nCols; }
+    size_t tileSize() const noexcept { return tileSz; }
+    size_t tileRows() const noexcept { return nTileRows; }
+    size_t tileCols() const noexcept { return nTileCols; }
+    size_t cacheTiles() const noexcept { return capacity; }
+
+    void setCacheTiles(size_t cacheTiles)
+    {
+        if (cacheTiles < 3) throw invalid_argument("Кэш должен вмещать не менее трёх плиток");
+        capacity = cacheTiles;
+        while (lru.size() > capacity)
+            evict();
+    }
+
+    // Плитка (ti, tj); неконстантный доступ помечает её изменённой
+    TDynamicMatrix<T>& tile(size_t ti, size_t tj)
+    {
+        TSlot& s = slot(ti, tj);
+        s.dirty = true;
+        return s.tile;
+    }
+
+    const TDynamicMatrix<T>& tile(size_t ti, size_t tj) const { return slot(ti, tj).tile; }
+
+    T get(size_t i, size_t j) const
+    {
+        if (i >= nRows || j >= nCols) throw out_of_range("Индекс вне диапазона");
+        return tile(i / tileSz, j / tileSz)(i % tileSz, j % tileSz);
+    }
+
+    void set(size_t i, size_t j, const T& val)
+    {
+        if (i >= nRows || j >= nCols) throw out_of_range("Индекс вне диапазона");
+        tile(i / tileSz, j / tileSz)(i % tileSz, j % tileSz) = val;
+    }
+
+    // Запись всех изменённых плиток; кэш сохраняется
+    void flush()
+    {
+        for (TSlot& s : lru)
+            if (s.dirty) {
+                store(s);
+                s.dirty = false;
             }
-        }
+        if (!file.flush()) throw runtime_error("Ошибка записи в файл " + name.path);
+    }
+
+    // Запись изменённых плиток и освобождение памяти кэша
+    void clearCache()
+    {
+        while (!lru.empty())
+            evict();
+    }
+
+    const TTileIoStats& stats() const noexcept { return ioStats; }
+    void resetStats() noexcept { ioStats = TTileIoStats(); }
+
+    TDynamicMatrix<T> toDense() const
+    {
+        TDynamicMatrix<T> res(nRows, nCols, uninitialized);
+        for (size_t ti = 0; ti < nTileRows; ti++)
+            for (size_t tj = 0; tj < nTileCols; tj++)
+                res.block(ti * tileSz, tj * tileSz, tileHeight(ti), tileWidth(tj)) = tile(ti, tj);
         return res;
     }
 
-    TDynamicVector<T>& operator[](size_t index) {
-        if (index >= sz) throw out_of_range("Индекс вне диапазона");
-        return pMem[index];
+    TTiledMatrix& operator+=(const TTiledMatrix& m) { return update(m, TAddOp()); }
+    TTiledMatrix& operator-=(const TTiledMatrix& m) { return update(m, TSubOp()); }
+
+    TTiledMatrix operator+(const TTiledMatrix& m) const
+    {
+        checkSameShape(m);
+        TTiledMatrix res(nRows, nCols, tileSz, capacity);
+        for (size_t ti = 0; ti < nTileRows; ti++)
+            for (size_t tj = 0; tj < nTileCols; tj++) {
+                const TDynamicMatrix<T>& a = tile(ti, tj);
+                const TDynamicMatrix<T>& b = m.tile(ti, tj);
+                res.tile(ti, tj) = a + b;
+            }
+        return res;
     }
 
-    const TDynamicVector<T>& operator[](size_t index) const {
-        if (index >= sz) throw out_of_range("Индекс вне диапазона");
-        return pMem[index];
+    TTiledMatrix operator-(const TTiledMatrix& m) const
+    {
+        checkSameShape(m);
+        TTiledMatrix res(nRows, nCols, tileSz, capacity);
+        for (size_t ti = 0; ti < nTileRows; ti++)
+            for (size_t tj = 0; tj < nTileCols; tj++) {
+                const TDynamicMatrix<T>& a = tile(ti, tj);
+                const TDynamicMatrix<T>& b = m.tile(ti, tj);
+                res.tile(ti, tj) = a - b;
+            }
+        return res;
     }
 
-    friend istream& operator>>(istream& istr, TDynamicMatrix& m) {
-        for (size_t i = 0; i < m.rows(); i++) {
-            istr >> m[i];
-        }
-        return istr;
+    // y = A x: каждая плитка читается один раз и умножается GEMV
+    TDynamicVector<T> multiply(const TDynamicVector<T>& x) const
+    {
+        if (nCols != x.size()) throw invalid_argument("Число столбцов матрицы должно совпадать с размером вектора");
+        TDynamicVector<T> y(nRows);
+        TDynamicVector<T> part(std::min(tileSz, nRows), uninitialized);
+        for (size_t ti = 0; ti < nTileRows; ti++)
+            for (size_t tj = 0; tj < nTileCols; tj++) {
+                const TDynamicMatrix<T>& a = tile(ti, tj);
+                gemv(a.rows(), a.cols(), a.data(), a.stride(), x.data() + tj * tileSz, part.data());
+                utmatrix_detail::TExprEval::binary(y.data() + ti * tileSz, static_cast<const T*>(part.data()),
+                                                  y.data() + ti * tileSz, a.rows(), TAddOp());
+            }
+        return y;
     }
 
-    friend ostream& operator<<(ostream& ostr, const TDynamicMatrix& m) {
-        for (size_t i = 0; i < m.rows(); i++) {
-            ostr << m[i] << endl;
-        }
-        return ostr;
+    // C = A B плитками: плитка C накапливается в кэше, пока по k перебираются
+    // плитки строки A и столбца B. Плитки C обходятся змейкой, и порядок k
+    // чередуется, поэтому начало каждого прохода использует плитки A и B,
+    // оставшиеся в кэше от конца предыдущего.
+    TTiledMatrix multiply(const TTiledMatrix& m) const
+    {
+        if (nCols != m.nRows) throw invalid_argument("Число столбцов первой матрицы должно совпадать с количеством строк второй матрицы");
+        if (tileSz != m.tileSz) throw invalid_argument("Размеры плиток должны совпадать");
+        TTiledMatrix res(nRows, m.nCols, tileSz, capacity);
+        const size_t kt = nTileCols;
+        bool forwardK = true;
+        for (size_t ti = 0; ti < nTileRows; ti++)
+            for (size_t q = 0; q < res.nTileCols; q++) {
+                const size_t tj = ti % 2 == 0 ? q : res.nTileCols - 1 - q;
+                TDynamicMatrix<T>& c = res.tile(ti, tj);
+                for (size_t p = 0; p < kt; p++) {
+                    const size_t tk = forwardK ? p : kt - 1 - p;
+                    const TDynamicMatrix<T>& a = tile(ti, tk);
+                    const TDynamicMatrix<T>& b = m.tile(tk, tj);
+                    gemm(T(1), a, b, T(1), c);
+                }
+                forwardK = !forwardK;
+            }
+        return res;
     }
+
+    TTiledMatrix operator*(const TTiledMatrix& m) const { return multiply(m); }
+    TDynamicVector<T> operator*(const TDynamicVector<T>& v) const { return multiply(v); }
 };
 
 #endif
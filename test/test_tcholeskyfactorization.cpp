@@ -0,0 +1,103 @@
+﻿#include "utmatrix.h"
+#include <gtest.h>
+
+// Симметричная положительно определённая матрица A = B B^T + n I
+static TDynamicMatrix<double> spdMatrix(size_t n, unsigned seed)
+{
+    TDynamicMatrix<double> b(n, n);
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < n; j++)
+            b(i, j) = double((i * 29 + j * 13 + seed * 5) % 17) / 17.0 - 0.5;
+    TDynamicMatrix<double> a(n, n);
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < n; j++) {
+            double s = i == j ? double(n) : 0.0;
+            for (size_t k = 0; k < n; k++)
+                s += b(i, k) * b(j, k);
+            a(i, j) = s;
+        }
+    return a;
+}
+
+static double maxAbsDiff(const TDynamicMatrix<double>& a, const TDynamicMatrix<double>& b)
+{
+    double d = 0;
+    for (size_t i = 0; i < a.rows(); i++)
+        for (size_t j = 0; j < a.cols(); j++)
+            d = std::max(d, std::abs(a(i, j) - b(i, j)));
+    return d;
+}
+
+TEST(TCholeskyFactorization, can_factor_positive_definite_matrix)
+{
+    ASSERT_NO_THROW(TCholeskyFactorization<double> c(spdMatrix(5, 1)));
+}
+
+TEST(TCholeskyFactorization, throws_when_matrix_is_not_square)
+{
+    ASSERT_ANY_THROW(TCholeskyFactorization<double> c(TDynamicMatrix<double>(3, 4)));
+}
+
+TEST(TCholeskyFactorization, throws_when_matrix_is_not_positive_definite)
+{
+    TDynamicMatrix<double> a = spdMatrix(70, 2);
+    a(60, 60) = -1.0;
+    ASSERT_ANY_THROW(TCholeskyFactorization<double> c(a, 16));
+}
+
+TEST(TCholeskyFactorization, factor_reproduces_matrix)
+{
+    const size_t n = 150;
+    TDynamicMatrix<double> a = spdMatrix(n, 3);
+    TCholeskyFactorization<double> c(a, 32);
+    TDynamicMatrix<double> l(c.factor()), lt(n, n);
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < n; j++)
+            lt(j, i) = l(i, j);
+    EXPECT_LT(maxAbsDiff(l * lt, a), 1e-9);
+}
+
+TEST(TCholeskyFactorization, factor_does_not_depend_on_block_size)
+{
+    TDynamicMatrix<double> a = spdMatrix(97, 4);
+    TDynamicMatrix<double> l1(TCholeskyFactorization<double>(a, 1).factor());
+    TDynamicMatrix<double> l8(TCholeskyFactorization<double>(a, 8).factor());
+    TDynamicMatrix<double> l200(TCholeskyFactorization<double>(a, 200).factor());
+    EXPECT_LT(maxAbsDiff(l1, l8), 1e-10);
+    EXPECT_LT(maxAbsDiff(l1, l200), 1e-10);
+}
+
+TEST(TCholeskyFactorization, can_solve_system)
+{
+    const size_t n = 120;
+    TDynamicMatrix<double> a = spdMatrix(n, 5);
+    TDynamicVector<double> x(n);
+    for (size_t i = 0; i < n; i++) x[i] = double(i % 7) - 3.0;
+    TDynamicVector<double> y = TCholeskyFactorization<double>(a, 16).solve(a * x);
+    for (size_t i = 0; i < n; i++)
+        EXPECT_NEAR(y[i], x[i], 1e-10);
+}
+
+TEST(TCholeskyFactorization, can_solve_with_several_right_hand_sides)
+{
+    const size_t n = 80;
+    TDynamicMatrix<double> a = spdMatrix(n, 6), x(n, 5);
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < 5; j++)
+            x(i, j) = double((i + 3 * j) % 9) - 4.0;
+    TDynamicMatrix<double> y = TCholeskyFactorization<double>(a, 24).solve(a * x);
+    EXPECT_LT(maxAbsDiff(y, x), 1e-10);
+}
+
+TEST(TCholeskyFactorization, determinant_matches_lu)
+{
+    TDynamicMatrix<double> a = spdMatrix(12, 7);
+    const double lu = TLUFactorization<double>(a).determinant();
+    EXPECT_NEAR(TCholeskyFactorization<double>(a).determinant(), lu, std::abs(lu) * 1e-10);
+}
+
+TEST(TCholeskyFactorization, throws_when_solve_with_wrong_size)
+{
+    TCholeskyFactorization<double> c(spdMatrix(6, 1));
+    ASSERT_ANY_THROW(c.solve(TDynamicVector<double>(5)));
+}
@@ -0,0 +1,128 @@
+﻿#include "utmatrix.h"
+#include <gtest.h>
+
+// Хорошо обусловленная матрица со случайными элементами
+static TDynamicMatrix<double> testMatrix(size_t n, unsigned seed)
+{
+    TDynamicMatrix<double> a(n, n);
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < n; j++)
+            a(i, j) = double((i * 37 + j * 11 + seed * 7) % 19) / 19.0 - 0.5 + (i == j ? 2.0 : 0.0);
+    return a;
+}
+
+static double maxAbsDiff(const TDynamicMatrix<double>& a, const TDynamicMatrix<double>& b)
+{
+    double d = 0;
+    for (size_t i = 0; i < a.rows(); i++)
+        for (size_t j = 0; j < a.cols(); j++)
+            d = std::max(d, std::abs(a(i, j) - b(i, j)));
+    return d;
+}
+
+TEST(TLUFactorization, can_factor_square_matrix)
+{
+    ASSERT_NO_THROW(TLUFactorization<double> lu(testMatrix(5, 1)));
+}
+
+TEST(TLUFactorization, throws_when_matrix_is_not_square)
+{
+    ASSERT_ANY_THROW(TLUFactorization<double> lu(TDynamicMatrix<double>(3, 4)));
+}
+
+TEST(TLUFactorization, factors_reproduce_permuted_matrix)
+{
+    const size_t n = 150;
+    TDynamicMatrix<double> a = testMatrix(n, 2);
+    TLUFactorization<double> lu(a, 32);
+    const TDynamicMatrix<double>& f = lu.factors();
+    TDynamicMatrix<double> l(n, n), u(n, n), pa(n, n);
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            if (j < i) l(i, j) = f(i, j);
+            else u(i, j) = f(i, j);
+            pa(i, j) = a(lu.permutation()[i], j);
+        }
+        l(i, i) = 1.0;
+    }
+    EXPECT_LT(maxAbsDiff(l * u, pa), 1e-12);
+}
+
+TEST(TLUFactorization, uses_partial_pivoting)
+{
+    TDynamicMatrix<double> a(2, 2);
+    a(0, 0) = 0.0; a(0, 1) = 1.0;
+    a(1, 0) = 2.0; a(1, 1) = 3.0;
+    TLUFactorization<double> lu(a);
+    EXPECT_EQ(lu.permutation()[0], 1);
+    EXPECT_EQ(lu.determinant(), -2.0);
+}
+
+TEST(TLUFactorization, can_solve_for_vector)
+{
+    const size_t n = 200;
+    TDynamicMatrix<double> a = testMatrix(n, 3);
+    TDynamicVector<double> x(n);
+    for (size_t i = 0; i < n; i++) x[i] = double(i % 5) - 2.0;
+    TDynamicVector<double> b = a * x;
+    TDynamicVector<double> r = TLUFactorization<double>(a, 48).solve(b);
+    for (size_t i = 0; i < n; i++)
+        EXPECT_NEAR(r[i], x[i], 1e-10);
+}
+
+TEST(TLUFactorization, can_solve_for_many_right_hand_sides)
+{
+    const size_t n = 130, m = 70;
+    TDynamicMatrix<double> a = testMatrix(n, 4), x(n, m);
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < m; j++)
+            x(i, j) = double((i + 3 * j) % 7) - 3.0;
+    TLUFactorization<double> lu(a);
+    TDynamicMatrix<double> b = a * x;
+    EXPECT_LT(maxAbsDiff(lu.solve(b), x), 1e-10);
+    ASSERT_ANY_THROW(lu.solve(TDynamicMatrix<double>(n + 1, 2)));
+    ASSERT_ANY_THROW(lu.solve(TDynamicVector<double>(n - 1)));
+}
+
+TEST(TLUFactorization, block_size_does_not_change_result)
+{
+    TDynamicMatrix<double> a = testMatrix(97, 5);
+    TLUFactorization<double> lu1(a, 1), lu2(a, 16), lu3(a, 200);
+    EXPECT_EQ(lu1.permutation(), lu3.permutation());
+    EXPECT_LT(maxAbsDiff(lu1.factors(), lu2.factors()), 1e-12);
+    EXPECT_LT(maxAbsDiff(lu1.factors(), lu3.factors()), 1e-12);
+}
+
+TEST(TLUFactorization, can_compute_determinant)
+{
+    TDynamicMatrix<double> a(3, 3);
+    a(0, 0) = 2; a(0, 1) = -1; a(0, 2) = 0;
+    a(1, 0) = -1; a(1, 1) = 2; a(1, 2) = -1;
+    a(2, 0) = 0; a(2, 1) = -1; a(2, 2) = 2;
+    EXPECT_NEAR(TLUFactorization<double>(a).determinant(), 4.0, 1e-12);
+}
+
+TEST(TLUFactorization, detects_singular_matrix)
+{
+    TDynamicMatrix<double> a(3, 3);
+    for (size_t i = 0; i < 3; i++)
+        for (size_t j = 0; j < 3; j++)
+            a(i, j) = double(i + j);
+    TLUFactorization<double> lu(a);
+    EXPECT_TRUE(lu.singular());
+    EXPECT_EQ(lu.determinant(), 0.0);
+    ASSERT_ANY_THROW(lu.solve(TDynamicVector<double>(3)));
+}
+
+TEST(TLUFactorization, parallel_factorization_matches_single_thread)
+{
+    TThreadPool& pool = TThreadPool::instance();
+    const size_t saved = pool.threadCount();
+    TDynamicMatrix<double> a = testMatrix(300, 6);
+    pool.setThreadCount(1);
+    TLUFactorization<double> lu1(a);
+    pool.setThreadCount(4);
+    TLUFactorization<double> lu4(a);
+    pool.setThreadCount(saved);
+    EXPECT_EQ(lu1.factors(), lu4.factors());
+}
@@ -0,0 +1,134 @@
+﻿#include "utmatrix.h"
+#include <gtest.h>
+#include <sstream>
+#include <cstdio>
+
+static TDynamicMatrix<double> testMatrix(size_t m, size_t n)
+{
+    TDynamicMatrix<double> a(m, n);
+    for (size_t i = 0; i < m; i++)
+        for (size_t j = 0; j < n; j++)
+            a(i, j) = double(i) * 0.5 - double(j) / 3.0;
+    return a;
+}
+
+// Временный файл, удаляемый в конце теста
+struct TTempFile
+{
+    string path;
+    explicit TTempFile(const char* name) : path(name) {}
+    ~TTempFile() { std::remove(path.c_str()); }
+};
+
+TEST(TMappedMatrix, binary_stream_round_trip_keeps_matrix)
+{
+    TDynamicMatrix<double> a = testMatrix(13, 7);
+    stringstream s;
+    writeBinary(s, a);
+    EXPECT_EQ(s.str().size(), 64 + 13 * 7 * sizeof(double));
+    EXPECT_EQ(readBinary<double>(s), a);
+}
+
+TEST(TMappedMatrix, header_describes_matrix)
+{
+    stringstream s;
+    writeBinary(s, TDynamicMatrix<float>(3, 5));
+    TBinaryHeader h;
+    s.read(reinterpret_cast<char*>(&h), sizeof(h));
+    EXPECT_EQ(string(h.magic, 8), "UTMATRIX");
+    EXPECT_EQ(h.version, TBinaryHeader::currentVersion);
+    EXPECT_EQ(h.dtype, std::uint32_t(TBinaryType::Float32));
+    EXPECT_EQ(h.elemSize, sizeof(float));
+    EXPECT_EQ(h.rows, 3);
+    EXPECT_EQ(h.cols, 5);
+    EXPECT_EQ(h.dataOffset % MEM_ALIGNMENT, 0);
+}
+
+TEST(TMappedMatrix, throws_when_read_wrong_type_or_corrupted_data)
+{
+    stringstream s;
+    writeBinary(s, testMatrix(4, 4));
+    string bytes = s.str();
+    stringstream wrongType(bytes);
+    ASSERT_ANY_THROW(readBinary<float>(wrongType));
+    stringstream truncated(bytes.substr(0, bytes.size() - 1));
+    ASSERT_ANY_THROW(readBinary<double>(truncated));
+    bytes[0] = 'X';
+    stringstream badMagic(bytes);
+    ASSERT_ANY_THROW(readBinary<double>(badMagic));
+}
+
+TEST(TMappedMatrix, reads_file_with_opposite_byte_order)
+{
+    TDynamicMatrix<std::int32_t> a(2, 3);
+    for (size_t i = 0; i < 2; i++)
+        for (size_t j = 0; j < 3; j++)
+            a(i, j) = std::int32_t(i * 1000 + j * 7 + 1);
+    stringstream s;
+    writeBinary(s, a);
+    string bytes = s.str();
+    // Переставляем байты всех полей заголовка и всех элементов
+    const size_t fields32[] = { 8, 12, 16, 20, 24, 28 };
+    for (size_t off : fields32)
+        std::reverse(bytes.begin() + off, bytes.begin() + off + 4);
+    for (size_t off = 32; off < 64; off += 8)
+        std::reverse(bytes.begin() + off, bytes.begin() + off + 8);
+    for (size_t off = 64; off < bytes.size(); off += 4)
+        std::reverse(bytes.begin() + off, bytes.begin() + off + 4);
+    stringstream swapped(bytes);
+    EXPECT_EQ(readBinary<std::int32_t>(swapped), a);
+
+    TTempFile f("test_tmappedmatrix_swapped.bin");
+    ofstream(f.path, ios::binary).write(bytes.data(), std::streamsize(bytes.size()));
+    ASSERT_ANY_THROW(TMappedMatrix<std::int32_t> m(f.path));
+}
+
+TEST(TMappedMatrix, can_save_and_load_file)
+{
+    TTempFile f("test_tmappedmatrix_load.bin");
+    TDynamicMatrix<double> a = testMatrix(20, 30);
+    saveBinary(f.path, a);
+    EXPECT_EQ(loadBinary<double>(f.path), a);
+}
+
+TEST(TMappedMatrix, mapped_matrix_reads_elements_from_file)
+{
+    TTempFile f("test_tmappedmatrix_map.bin");
+    TDynamicMatrix<double> a = testMatrix(20, 30);
+    saveBinary(f.path, a);
+    TMappedMatrix<double> m(f.path);
+    EXPECT_EQ(m.rows(), 20);
+    EXPECT_EQ(m.cols(), 30);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(m.data()) % MEM_ALIGNMENT, 0);
+    EXPECT_EQ(m(19, 29), a(19, 29));
+    EXPECT_EQ(m.at(3, 4), a(3, 4));
+    ASSERT_ANY_THROW(m.at(20, 0));
+    EXPECT_EQ(TDynamicMatrix<double>(m), a);
+}
+
+TEST(TMappedMatrix, mapped_matrix_takes_part_in_expressions_and_products)
+{
+    TTempFile f("test_tmappedmatrix_ops.bin");
+    TDynamicMatrix<double> a = testMatrix(12, 12), b = testMatrix(12, 12) * 2.0;
+    saveBinary(f.path, a);
+    TMappedMatrix<double> m(f.path);
+    TDynamicVector<double> x(12);
+    for (size_t i = 0; i < 12; i++) x[i] = double(i);
+    EXPECT_EQ(TDynamicMatrix<double>(m + b), a + b);
+    EXPECT_EQ(m * b, a * b);
+    EXPECT_EQ(b * m, b * a);
+    EXPECT_EQ(m * m, a * a);
+    EXPECT_EQ(m * x, a * x);
+    EXPECT_EQ((m + b) * m, (a + b) * a);
+}
+
+TEST(TMappedMatrix, throws_when_map_missing_or_truncated_file)
+{
+    ASSERT_ANY_THROW(TMappedMatrix<double> m("test_tmappedmatrix_missing.bin"));
+    TTempFile f("test_tmappedmatrix_short.bin");
+    stringstream s;
+    writeBinary(s, testMatrix(5, 5));
+    const string bytes = s.str();
+    ofstream(f.path, ios::binary).write(bytes.data(), std::streamsize(bytes.size() - 8));
+    ASSERT_ANY_THROW(TMappedMatrix<double> m(f.path));
+}
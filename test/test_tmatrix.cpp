@@ -1,5 +1,6 @@
 #include "utmatrix.h"
 #include <gtest.h>
+#include <sstream>
 
 TEST(TDynamicMatrix, can_create_matrix_with_positive_length)
 {
@@ -149,3 +150,675 @@ TEST(TDynamicMatrix, cant_subtract_matrixes_with_not_equal_size)
     TDynamicMatrix<int> m2(3);
     ASSERT_ANY_THROW(m1 - m2); //     
 }
+
+TEST(TDynamicMatrix, can_get_rows_and_cols)
+{
+    TDynamicMatrix<int> m(3, 7);
+    EXPECT_EQ(m.rows(), 3);
+    EXPECT_EQ(m.cols(), 7);
+}
+
+TEST(TDynamicMatrix, rows_are_stored_contiguously)
+{
+    TDynamicMatrix<double> m(4, 5);
+    for (size_t i = 1; i < m.rows(); i++)
+        EXPECT_EQ(&m[i][0], &m[i - 1][0] + m.cols()); //      
+}
+
+TEST(TDynamicMatrix, storage_is_aligned)
+{
+    TDynamicMatrix<double> m(3, 3);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(&m[0][0]) % MEM_ALIGNMENT, 0);
+}
+
+TEST(TDynamicMatrix, can_assign_vector_to_row)
+{
+    TDynamicMatrix<int> m(2, 3);
+    TDynamicVector<int> v(3);
+    v[2] = 7;
+    m[1] = v;
+    EXPECT_EQ(m[1][2], 7);
+    EXPECT_EQ(m[0][2], 0);
+}
+
+TEST(TDynamicMatrix, cant_assign_vector_of_other_size_to_row)
+{
+    TDynamicMatrix<int> m(2, 3);
+    TDynamicVector<int> v(4);
+    ASSERT_ANY_THROW(m[0] = v);
+}
+
+TEST(TDynamicMatrix, moved_matrix_is_empty)
+{
+    TDynamicMatrix<int> m1(2, 3);
+    TDynamicMatrix<int> m2(std::move(m1));
+    EXPECT_EQ(m1.rows(), 0);
+    EXPECT_EQ(m2.rows(), 2);
+    EXPECT_EQ(m2.cols(), 3);
+}
+
+TEST(TDynamicMatrix, can_multiply_rectangular_matrices)
+{
+    TDynamicMatrix<int> a(2, 3), b(3, 2);
+    for (size_t i = 0; i < 2; i++)
+        for (size_t j = 0; j < 3; j++) {
+            a[i][j] = int(i * 3 + j + 1);
+            b[j][i] = int(j * 2 + i + 1);
+        }
+    TDynamicMatrix<int> c = a * b;
+    EXPECT_EQ(c.rows(), 2);
+    EXPECT_EQ(c.cols(), 2);
+    EXPECT_EQ(c[0][0], 22);
+    EXPECT_EQ(c[0][1], 28);
+    EXPECT_EQ(c[1][0], 49);
+    EXPECT_EQ(c[1][1], 64);
+}
+
+template<typename T>
+static TDynamicMatrix<T> referenceProduct(const TDynamicMatrix<T>& a, const TDynamicMatrix<T>& b)
+{
+    TDynamicMatrix<T> c(a.rows(), b.cols());
+    for (size_t i = 0; i < a.rows(); i++)
+        for (size_t j = 0; j < b.cols(); j++) {
+            T sum = T();
+            for (size_t k = 0; k < a.cols(); k++)
+                sum += a[i][k] * b[k][j];
+            c[i][j] = sum;
+        }
+    return c;
+}
+
+template<typename T>
+static void fillPattern(TDynamicMatrix<T>& m, int seed)
+{
+    for (size_t i = 0; i < m.rows(); i++)
+        for (size_t j = 0; j < m.cols(); j++)
+            m[i][j] = T(int(i * 7 + j * 3 + seed) % 11 - 5);
+}
+
+TEST(TDynamicMatrix, blocked_product_matches_reference_on_uneven_sizes)
+{
+    TGemmConfig saved = gemmConfig();
+    gemmConfig() = TGemmConfig{ 8, 5, 12, 0 }; //  ,     
+    TDynamicMatrix<int> a(37, 23), b(23, 29);
+    fillPattern(a, 1);
+    fillPattern(b, 2);
+    TDynamicMatrix<int> c = a * b;
+    gemmConfig() = saved;
+    EXPECT_EQ(c, referenceProduct(a, b));
+}
+
+TEST(TDynamicMatrix, blocked_product_of_large_double_matrices_is_correct)
+{
+    TDynamicMatrix<double> a(130, 140), b(140, 150);
+    fillPattern(a, 3);
+    fillPattern(b, 4);
+    EXPECT_EQ(a * b, referenceProduct(a, b)); //    double  
+}
+
+TEST(TDynamicMatrix, gemm_accepts_transposed_operand_and_beta)
+{
+    TDynamicMatrix<double> a(60, 70), b(60, 80), c(70, 80);
+    fillPattern(a, 5);
+    fillPattern(b, 6);
+    fillPattern(c, 7);
+    TDynamicMatrix<double> at(70, 60);
+    for (size_t i = 0; i < 60; i++)
+        for (size_t j = 0; j < 70; j++)
+            at[j][i] = a[i][j];
+    TDynamicMatrix<double> expected = referenceProduct(at, b) * 2.0 + c;
+    // A^T    (1, 70)  
+    gemm<double>(70, 80, 60, 2.0, &a[0][0], 1, 70, &b[0][0], 80, 1, 1.0, &c[0][0], 80);
+    EXPECT_EQ(c, expected);
+}
+
+TEST(TDynamicMatrix, chained_expression_reuses_destination_buffer)
+{
+    TDynamicMatrix<int> a(3, 4), b(3, 4), d(3, 4), c(3, 4);
+    fillPattern(a, 1);
+    fillPattern(b, 2);
+    fillPattern(d, 3);
+    const int* before = &c[0][0];
+    c = a + b * 2 - d;
+    EXPECT_EQ(&c[0][0], before); //     
+    for (size_t i = 0; i < 3; i++)
+        for (size_t j = 0; j < 4; j++)
+            EXPECT_EQ(c[i][j], a[i][j] + b[i][j] * 2 - d[i][j]);
+}
+
+TEST(TDynamicMatrix, can_index_expression_without_evaluating_it)
+{
+    TDynamicMatrix<int> a(2, 2), b(2, 2);
+    a[1][0] = 3;
+    b[1][0] = 4;
+    auto e = a + b;
+    EXPECT_EQ(e[1][0], 7);
+    ASSERT_ANY_THROW(e[2][0]);
+    ASSERT_ANY_THROW(e[0][2]);
+}
+
+TEST(TDynamicMatrix, can_multiply_expression_by_matrix)
+{
+    TDynamicMatrix<int> a(3, 3), b(3, 3), c(3, 3);
+    fillPattern(a, 1);
+    fillPattern(b, 2);
+    fillPattern(c, 3);
+    TDynamicMatrix<int> sum = a + b;
+    EXPECT_EQ((a + b) * c, sum * c);
+    EXPECT_EQ(c * (a + b), c * sum);
+}
+
+TEST(TDynamicMatrix, can_add_vector_to_matrix_row)
+{
+    TDynamicMatrix<int> m(2, 3);
+    TDynamicVector<int> v(3);
+    m[0][1] = 2;
+    v[1] = 5;
+    m[1] = m[0] + v;
+    EXPECT_EQ(m[1][1], 7);
+    TDynamicVector<int> r = m[1] * 2;
+    EXPECT_EQ(r[1], 14);
+}
+
+TEST(TDynamicMatrix, compound_operators_work_in_place)
+{
+    TDynamicMatrix<int> acc(3, 4), delta(3, 4);
+    fillPattern(acc, 1);
+    fillPattern(delta, 2);
+    TDynamicMatrix<int> expected = (acc + delta - delta * 3) * 2;
+    const int* before = &acc[0][0];
+    acc += delta;
+    acc -= delta * 3;
+    acc *= 2;
+    EXPECT_EQ(&acc[0][0], before);
+    EXPECT_EQ(acc, expected);
+}
+
+TEST(TDynamicMatrix, cant_add_assign_matrices_with_not_equal_size)
+{
+    TDynamicMatrix<int> m1(3, 4), m2(4, 3);
+    ASSERT_ANY_THROW(m1 += m2);
+    ASSERT_ANY_THROW(m1 -= m2);
+    ASSERT_ANY_THROW(m1.axpy(1, m2));
+}
+
+TEST(TDynamicMatrix, can_do_axpy_update)
+{
+    TDynamicMatrix<double> y(5, 6), x(5, 6);
+    fillPattern(y, 1);
+    fillPattern(x, 2);
+    TDynamicMatrix<double> expected = y + x * 1.5;
+    y.axpy(1.5, x);
+    EXPECT_EQ(y, expected);
+}
+
+TEST(TDynamicMatrix, can_update_row_in_place)
+{
+    TDynamicMatrix<double> m(3, 3);
+    fillPattern(m, 4);
+    TDynamicVector<double> r0 = m[0], r1 = m[1];
+    m[1].axpy(-2.0, m[0]);
+    m[2] += m[0];
+    m[0] *= 3.0;
+    for (size_t j = 0; j < 3; j++) {
+        EXPECT_EQ(m[1][j], r1[j] - 2.0 * r0[j]);
+        EXPECT_EQ(m[0][j], 3.0 * r0[j]);
+    }
+}
+
+TEST(TDynamicMatrix, sum_with_product_reuses_product_buffer)
+{
+    TDynamicMatrix<double> a(40, 40), b(40, 40), c(40, 40);
+    fillPattern(a, 1);
+    fillPattern(b, 2);
+    fillPattern(c, 3);
+    TDynamicMatrix<double> ab = a * b;
+    size_t before = allocationCount();
+    TDynamicMatrix<double> d = (a * b) + c - c * 2.0;
+    EXPECT_EQ(allocationCount() - before, 1); //   
+    EXPECT_EQ(d, ab - c);
+}
+
+TEST(TDynamicMatrix, can_subtract_temporary_from_matrix)
+{
+    TDynamicMatrix<int> a(2, 2), b(2, 2);
+    fillPattern(a, 1);
+    fillPattern(b, 2);
+    TDynamicMatrix<int> expected = a - b;
+    EXPECT_EQ(a - TDynamicMatrix<int>(b), expected);
+    EXPECT_EQ(TDynamicMatrix<int>(a) - TDynamicMatrix<int>(b), expected);
+}
+
+TEST(TDynamicMatrix, parallel_operations_match_single_thread)
+{
+    TThreadPool& pool = TThreadPool::instance();
+    const size_t saved = pool.threadCount();
+    TDynamicMatrix<double> a(301, 257), b(257, 203), c(301, 257);
+    fillPattern(a, 1);
+    fillPattern(b, 2);
+    fillPattern(c, 3);
+    TDynamicVector<double> x(257);
+    for (size_t i = 0; i < x.size(); i++) x[i] = double(i % 7) - 3.0;
+
+    pool.setThreadCount(1);
+    TDynamicMatrix<double> p1 = a * b, s1 = a + c * 2.0;
+    TDynamicVector<double> y1 = a * x;
+
+    pool.setThreadCount(4);
+    TDynamicMatrix<double> p4 = a * b, s4 = a + c * 2.0;
+    TDynamicVector<double> y4 = a * x;
+    pool.setThreadCount(saved);
+
+    EXPECT_EQ(p1, p4);
+    EXPECT_EQ(s1, s4);
+    EXPECT_EQ(y1, y4);
+    EXPECT_EQ(p4, referenceProduct(a, b));
+}
+
+TEST(TDynamicMatrix, unchecked_access_matches_checked_access)
+{
+    TDynamicMatrix<int> m(3, 4);
+    fillPattern(m, 5);
+    for (size_t i = 0; i < m.rows(); i++)
+        for (size_t j = 0; j < m.cols(); j++) {
+            EXPECT_EQ(m(i, j), m[i][j]);
+            EXPECT_EQ(m.at(i, j), m[i][j]);
+            EXPECT_EQ(m[i](j), m[i][j]);
+        }
+}
+
+TEST(TDynamicMatrix, data_and_stride_describe_row_major_layout)
+{
+    TDynamicMatrix<double> m(3, 5);
+    m(2, 1) = 7.0;
+    EXPECT_EQ(m.stride(), 5);
+    EXPECT_EQ(m.data()[2 * m.stride() + 1], 7.0);
+    EXPECT_EQ(&m(1, 0), m[1].data());
+}
+
+TEST(TDynamicMatrix, at_keeps_bounds_check)
+{
+    TDynamicMatrix<int> m(3, 4);
+    ASSERT_NO_THROW(m.at(2, 3));
+    ASSERT_ANY_THROW(m.at(3, 0));
+    ASSERT_ANY_THROW(m.at(0, 4));
+    ASSERT_ANY_THROW(m.at(3));
+}
+
+TEST(TDynamicMatrix, can_use_custom_allocator)
+{
+    typedef TAlignedAllocator<double, 128> TAlloc;
+    TDynamicMatrix<double, TAlloc> a(60, 50), b(50, 40);
+    for (size_t i = 0; i < 60; i++)
+        for (size_t j = 0; j < 50; j++)
+            a(i, j) = double((i + 2 * j) % 5);
+    for (size_t i = 0; i < 50; i++)
+        for (size_t j = 0; j < 40; j++)
+            b(i, j) = double((3 * i + j) % 7);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(a.data()) % 128, 0);
+
+    TDynamicMatrix<double> da = a, db = b;
+    TDynamicMatrix<double, TAlloc> c = a * b;
+    EXPECT_EQ(TDynamicMatrix<double>(c), da * db);
+    EXPECT_EQ(TDynamicMatrix<double>(a * db), da * db);
+    TDynamicMatrix<double, TAlloc> s = a + a * 2.0;
+    EXPECT_EQ(TDynamicMatrix<double>(s), da * 3.0);
+}
+
+TEST(TDynamicMatrix, can_create_matrix_filled_with_value)
+{
+    TDynamicMatrix<int> m(3, 4, 7);
+    for (size_t i = 0; i < 3; i++)
+        for (size_t j = 0; j < 4; j++)
+            EXPECT_EQ(m(i, j), 7);
+}
+
+TEST(TDynamicMatrix, can_create_uninitialized_matrix)
+{
+    TDynamicMatrix<double> m(2, 5, uninitialized);
+    EXPECT_EQ(m.rows(), 2);
+    EXPECT_EQ(m.cols(), 5);
+    ASSERT_ANY_THROW(TDynamicMatrix<double>(0, 5, uninitialized));
+}
+
+TEST(TDynamicMatrix, products_write_result_once)
+{
+    TDynamicMatrix<double> a(70, 70, 1.0), b(70, 70, 2.0);
+    TDynamicVector<double> x(70, 3.0);
+    size_t before = allocationCount();
+    TDynamicMatrix<double> c = a * b;
+    TDynamicVector<double> y = a * x;
+    EXPECT_EQ(allocationCount() - before, 2);
+    EXPECT_EQ(c, TDynamicMatrix<double>(70, 70, 140.0));
+    EXPECT_EQ(y, TDynamicVector<double>(70, 210.0));
+}
+
+TEST(TDynamicMatrix, construction_and_copy_allocate_once)
+{
+    for (size_t n : { 1, 10, 1000 }) {
+        size_t before = allocationCount();
+        TDynamicMatrix<int> m(n, 7);
+        EXPECT_EQ(allocationCount() - before, 1);
+
+        before = allocationCount();
+        TDynamicMatrix<int> c(m);
+        EXPECT_EQ(allocationCount() - before, 1);
+
+        before = allocationCount();
+        TDynamicMatrix<int> f(n, 7, 3), u(n, 7, uninitialized);
+        EXPECT_EQ(allocationCount() - before, 2);
+    }
+}
+
+TEST(TDynamicMatrix, assignment_reuses_buffer_of_same_size)
+{
+    TDynamicMatrix<int> a(500, 40), b(500, 40), c(40, 500), d(3, 3);
+    fillPattern(a, 1);
+    size_t before = allocationCount();
+    b = a;
+    c = a; //  ,    
+    EXPECT_EQ(allocationCount() - before, 0);
+    EXPECT_EQ(b, a);
+    EXPECT_EQ(c.rows(), 500);
+    EXPECT_EQ(c, a);
+
+    before = allocationCount();
+    d = a;
+    EXPECT_EQ(allocationCount() - before, 1);
+    EXPECT_EQ(d, a);
+}
+
+TEST(TDynamicMatrix, move_does_not_allocate)
+{
+    TDynamicMatrix<int> a(100, 100);
+    size_t before = allocationCount();
+    TDynamicMatrix<int> b(std::move(a));
+    a = std::move(b);
+    swap(a, b);
+    EXPECT_EQ(allocationCount() - before, 0);
+}
+
+TEST(TDynamicMatrix, strassen_product_matches_reference_on_uneven_sizes)
+{
+    TDynamicMatrix<int> a(67, 45), b(45, 53), c(67, 53);
+    fillPattern(a, 1);
+    fillPattern(b, 2);
+    gemmStrassen(67, 53, 45, a.data(), a.stride(), b.data(), b.stride(), c.data(), c.stride(), 4);
+    EXPECT_EQ(c, referenceProduct(a, b)); //    ,    
+}
+
+TEST(TDynamicMatrix, product_uses_strassen_when_cutoff_is_set)
+{
+    TDynamicMatrix<double> a(130, 140), b(140, 150);
+    fillPattern(a, 3);
+    fillPattern(b, 4);
+    TGemmConfig saved = gemmConfig();
+    gemmConfig().strassenCutoff = 16;
+    TDynamicMatrix<double> c = a * b;
+    gemmConfig() = saved;
+    EXPECT_EQ(c, referenceProduct(a, b));
+}
+
+TEST(TDynamicMatrix, strassen_error_is_close_to_classical)
+{
+    const size_t n = 256;
+    TDynamicMatrix<double> a(n, n), b(n, n), c(n, n);
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < n; j++) {
+            a[i][j] = std::sin(double(i * n + j));
+            b[i][j] = std::cos(double(i + j * n));
+        }
+    gemmStrassen(n, n, n, a.data(), a.stride(), b.data(), b.stride(), c.data(), c.stride(), 16);
+    TDynamicMatrix<double> ref = a * b;
+    double err = 0;
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < n; j++)
+            err = std::max(err, std::abs(c[i][j] - ref[i][j]));
+    EXPECT_LT(err, 1e-10);
+}
+
+TEST(TDynamicMatrix, text_output_writes_rows_on_separate_lines)
+{
+    TDynamicMatrix<int> m(2, 3);
+    fillPattern(m, 1);
+    stringstream s;
+    s << m;
+    EXPECT_EQ(s.str(), "-4 -1 2 \n3 -5 -2 \n");
+    TDynamicMatrix<int> r(2, 3);
+    s >> r;
+    EXPECT_EQ(r, m);
+}
+
+//       
+struct TMatrixLimitsGuard
+{
+    TSizeLimits saved = sizeLimits();
+    ~TMatrixLimitsGuard() { sizeLimits() = saved; }
+};
+
+TEST(TDynamicMatrix, can_create_matrix_beyond_default_limit_after_raising_it)
+{
+    TMatrixLimitsGuard guard;
+    ASSERT_ANY_THROW(TDynamicMatrix<int> m(MAX_MATRIX_SIZE + 1, 3));
+    sizeLimits().maxMatrixSize = MAX_MATRIX_SIZE * 5;
+    TDynamicMatrix<int> m(MAX_MATRIX_SIZE * 5, 3);
+    m(MAX_MATRIX_SIZE * 5 - 1, 2) = 7;
+    EXPECT_EQ(m.rows(), MAX_MATRIX_SIZE * 5);
+    EXPECT_EQ(m.at(MAX_MATRIX_SIZE * 5 - 1, 2), 7);
+}
+
+TEST(TDynamicMatrix, element_count_is_limited_separately)
+{
+    TMatrixLimitsGuard guard;
+    sizeLimits().maxMatrixSize = MAX_MATRIX_SIZE * 2;
+    ASSERT_ANY_THROW(TDynamicMatrix<char> m(MAX_MATRIX_SIZE * 2, MAX_MATRIX_SIZE * 2));
+}
+
+TEST(TDynamicMatrix, throws_when_element_count_overflows)
+{
+    TMatrixLimitsGuard guard;
+    sizeLimits().maxMatrixSize = std::numeric_limits<size_t>::max();
+    sizeLimits().maxVectorSize = std::numeric_limits<size_t>::max();
+    ASSERT_THROW(TDynamicMatrix<char> m(std::numeric_limits<size_t>::max() / 2 + 1, 2), overflow_error);
+}
+
+TEST(TDynamicMatrix, file_backed_matrix_product_matches_in_memory_product)
+{
+    const size_t n = 150;
+    TDynamicMatrix<double> a(n, n), b(n, n);
+    TDynamicMatrix<double, TFileAllocator<double>> fa(n, n), fb(n, n);
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < n; j++) {
+            fa(i, j) = a(i, j) = double(i + 2 * j) / n;
+            fb(i, j) = b(i, j) = double(i) - double(j) / 3;
+        }
+    TDynamicMatrix<double, TFileAllocator<double>> fc = fa * fb;
+    TDynamicMatrix<double> c = a * b;
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < n; j++)
+            EXPECT_EQ(fc(i, j), c(i, j));
+}
+
+//     
+static TDynamicVector<double> referenceGemv(const TDynamicMatrix<double>& a, const TDynamicVector<double>& x, bool transposed)
+{
+    TDynamicVector<double> y(transposed ? a.cols() : a.rows(), 0.0);
+    for (size_t i = 0; i < a.rows(); i++)
+        for (size_t j = 0; j < a.cols(); j++) {
+            if (transposed) y[j] += a(i, j) * x[i];
+            else y[i] += a(i, j) * x[j];
+        }
+    return y;
+}
+
+static TDynamicMatrix<double> gemvMatrix(size_t m, size_t n)
+{
+    TDynamicMatrix<double> a(m, n);
+    for (size_t i = 0; i < m; i++)
+        for (size_t j = 0; j < n; j++)
+            a(i, j) = double((i * 7 + j * 3) % 11) - 5.0;
+    return a;
+}
+
+static TDynamicVector<double> gemvVector(size_t n)
+{
+    TDynamicVector<double> x(n);
+    for (size_t i = 0; i < n; i++)
+        x[i] = double(i % 5) - 2.0;
+    return x;
+}
+
+TEST(TDynamicMatrix, matrix_vector_product_matches_reference_for_odd_sizes)
+{
+    for (size_t m : { 1, 3, 4, 5, 31 })
+        for (size_t n : { 1, 7, 16, 33 }) {
+            TDynamicMatrix<double> a = gemvMatrix(m, n);
+            TDynamicVector<double> x = gemvVector(n);
+            EXPECT_EQ(a * x, referenceGemv(a, x, false)); //     
+        }
+}
+
+TEST(TDynamicMatrix, can_multiply_transposed_matrix_by_vector)
+{
+    for (size_t m : { 1, 4, 6, 37 })
+        for (size_t n : { 1, 5, 64, 2100 }) {
+            TDynamicMatrix<double> a = gemvMatrix(m, n);
+            TDynamicVector<double> x = gemvVector(m);
+            EXPECT_EQ(a.multiplyTransposed(x), referenceGemv(a, x, true));
+        }
+}
+
+TEST(TDynamicMatrix, cant_multiply_transposed_matrix_by_vector_with_wrong_size)
+{
+    TDynamicMatrix<double> a(3, 4);
+    TDynamicVector<double> x(4);
+    ASSERT_ANY_THROW(a.multiplyTransposed(x));
+}
+
+TEST(TDynamicMatrix, transposed_product_of_tall_matrix_uses_all_threads)
+{
+    TThreadPool& pool = TThreadPool::instance();
+    const size_t saved = pool.threadCount();
+    pool.setThreadCount(4);
+    TDynamicMatrix<double> a = gemvMatrix(5003, 40);
+    TDynamicVector<double> x = gemvVector(5003);
+    EXPECT_EQ(a.multiplyTransposed(x), referenceGemv(a, x, true));
+    EXPECT_EQ(a * gemvVector(40), referenceGemv(a, gemvVector(40), false));
+    pool.setThreadCount(saved);
+}
+
+TEST(TDynamicMatrix, gemv_on_block_view_matches_copy)
+{
+    TDynamicMatrix<double> a = gemvMatrix(20, 30);
+    TDynamicMatrix<double> b = a.block(3, 5, 13, 17);
+    TDynamicVector<double> x = gemvVector(17), z = gemvVector(13);
+    EXPECT_EQ(a.block(3, 5, 13, 17).multiply(x), b * x);
+    EXPECT_EQ(a.block(3, 5, 13, 17).multiplyTransposed(z), b.multiplyTransposed(z));
+}
+
+TEST(TDynamicMatrix, gemv_works_for_types_without_simd)
+{
+    TDynamicMatrix<short> a(5, 6, short(2));
+    TDynamicVector<short> x(6, short(3)), z(5, short(1));
+    EXPECT_EQ((a * x)[4], 36);
+    EXPECT_EQ(a.multiplyTransposed(z)[5], 10);
+}
+
+// ,   ,  
+static TDynamicMatrix<double> indexMatrix(size_t m, size_t n)
+{
+    TDynamicMatrix<double> a(m, n);
+    for (size_t i = 0; i < m; i++)
+        for (size_t j = 0; j < n; j++)
+            a(i, j) = double(i * 100000 + j);
+    return a;
+}
+
+template<typename T>
+static void checkTransposed(size_t m, size_t n)
+{
+    TDynamicMatrix<T> a(m, n);
+    for (size_t i = 0; i < m; i++)
+        for (size_t j = 0; j < n; j++)
+            a(i, j) = T(i * 1000 + j);
+    TDynamicMatrix<T> b = a.transposed();
+    ASSERT_EQ(b.rows(), n);
+    ASSERT_EQ(b.cols(), m);
+    for (size_t i = 0; i < m; i++)
+        for (size_t j = 0; j < n; j++)
+            ASSERT_EQ(b(j, i), a(i, j));
+}
+
+TEST(TDynamicMatrix, transposed_copy_for_various_shapes_and_types)
+{
+    for (size_t m : { 1, 3, 4, 17, 64, 131 })
+        for (size_t n : { 1, 4, 7, 33, 300 }) {
+            checkTransposed<double>(m, n);
+            checkTransposed<float>(m, n);
+            checkTransposed<int64_t>(m, n);
+            checkTransposed<int>(m, n);
+            checkTransposed<short>(m, n);
+        }
+}
+
+TEST(TDynamicMatrix, transposed_copy_in_parallel)
+{
+    TThreadPool& pool = TThreadPool::instance();
+    const size_t saved = pool.threadCount();
+    pool.setThreadCount(4);
+    checkTransposed<double>(700, 1030);
+    pool.setThreadCount(saved);
+}
+
+TEST(TDynamicMatrix, can_transpose_square_matrix_in_place)
+{
+    for (size_t n : { 1, 2, 5, 32, 33, 100 }) {
+        TDynamicMatrix<double> a = indexMatrix(n, n);
+        TDynamicMatrix<double> expected = a.transposed();
+        a.transpose();
+        EXPECT_EQ(a, expected);
+    }
+}
+
+TEST(TDynamicMatrix, can_transpose_rectangular_matrix_in_place)
+{
+    for (size_t m : { 1, 2, 3, 7, 40 })
+        for (size_t n : { 1, 5, 64, 91 }) {
+            TDynamicMatrix<double> a = indexMatrix(m, n);
+            TDynamicMatrix<double> expected = a.transposed();
+            a.transpose();
+            EXPECT_EQ(a.rows(), n);
+            EXPECT_EQ(a.cols(), m);
+            EXPECT_EQ(a, expected);
+        }
+}
+
+TEST(TDynamicMatrix, double_transpose_restores_matrix)
+{
+    TDynamicMatrix<double> a = indexMatrix(37, 53);
+    EXPECT_EQ(a.transposed().transposed(), a);
+    TDynamicMatrix<double> b(a);
+    b.transpose().transpose();
+    EXPECT_EQ(b, a);
+}
+
+TEST(TDynamicMatrix, can_transpose_block_view)
+{
+    TDynamicMatrix<double> a = indexMatrix(20, 20);
+    TDynamicMatrix<double> expected = TDynamicMatrix<double>(a.block(2, 3, 9, 9)).transposed();
+    EXPECT_EQ(a.block(2, 3, 9, 5).transposed(), TDynamicMatrix<double>(a.block(2, 3, 9, 5)).transposed());
+    a.block(2, 3, 9, 9).transpose();
+    EXPECT_EQ(TDynamicMatrix<double>(a.block(2, 3, 9, 9)), expected);
+    EXPECT_EQ(a(1, 3), 100003);
+    ASSERT_ANY_THROW(a.block(0, 0, 2, 3).transpose());
+}
+
+TEST(TDynamicMatrix, transpose_index_arithmetic_does_not_overflow)
+{
+    //  m = n = 2^22  k * m     64 
+    const unsigned long long all = std::numeric_limits<unsigned long long>::max();
+    EXPECT_EQ(utmatrix_detail::mulMod(1ull << 32, 1ull << 32, all), 1ull);
+    EXPECT_EQ(utmatrix_detail::mulMod(all - 1, all - 1, all), 1ull);
+    EXPECT_EQ(utmatrix_detail::mulMod(1ull << 63, 3, (1ull << 63) + 1), (1ull << 63) - 2);
+    EXPECT_EQ(utmatrix_detail::mulMod(12345, 678, 1000), 12345ull * 678 % 1000);
+}
@@ -0,0 +1,307 @@
+﻿#include "utmatrix.h"
+#include <gtest.h>
+#include <sstream>
+
+static TDynamicMatrix<double> testMatrix(size_t m, size_t n)
+{
+    TDynamicMatrix<double> a(m, n);
+    for (size_t i = 0; i < m; i++)
+        for (size_t j = 0; j < n; j++)
+            a(i, j) = double(i) * 0.5 - double(j) / 3.0;
+    return a;
+}
+
+// Копия блока поэлементно, для сравнения с результатами через представления
+static TDynamicMatrix<double> copyBlock(const TDynamicMatrix<double>& a, size_t i, size_t j, size_t r, size_t c)
+{
+    TDynamicMatrix<double> res(r, c);
+    for (size_t p = 0; p < r; p++)
+        for (size_t q = 0; q < c; q++)
+            res(p, q) = a(i + p, j + q);
+    return res;
+}
+
+TEST(TMatrixView, block_refers_to_matrix_memory)
+{
+    TDynamicMatrix<double> a = testMatrix(6, 5);
+    TMatrixView<double> b = a.block(1, 2, 3, 2);
+    ASSERT_EQ(b.rows(), 3);
+    ASSERT_EQ(b.cols(), 2);
+    EXPECT_EQ(b.stride(), 5);
+    EXPECT_EQ(b.data(), &a(1, 2));
+    b(2, 1) = 42;
+    EXPECT_EQ(a(3, 3), 42);
+}
+
+TEST(TMatrixView, block_out_of_range_throws)
+{
+    TDynamicMatrix<double> a(4, 4);
+    ASSERT_ANY_THROW(a.block(0, 0, 5, 1));
+    ASSERT_ANY_THROW(a.block(2, 2, 3, 1));
+    ASSERT_ANY_THROW(a.block(4, 0, 1, 1));
+    ASSERT_ANY_THROW(a.block(0, 0, 0, 1));
+    ASSERT_ANY_THROW(a.block(1, 1, 2, 2).at(2, 0));
+}
+
+TEST(TMatrixView, nested_block_keeps_parent_stride)
+{
+    TDynamicMatrix<double> a = testMatrix(8, 8);
+    TMatrixView<double> b = a.block(2, 1, 5, 6).block(1, 2, 2, 3);
+    EXPECT_EQ(b.stride(), 8);
+    EXPECT_EQ(TDynamicMatrix<double>(b), copyBlock(a, 3, 3, 2, 3));
+}
+
+TEST(TMatrixView, const_matrix_gives_read_only_view)
+{
+    const TDynamicMatrix<double> a = testMatrix(3, 4);
+    TMatrixView<const double> b = a.block(1, 1, 2, 3);
+    EXPECT_TRUE((std::is_same<decltype(b(0, 0)), const double&>::value));
+    EXPECT_EQ(b(1, 2), a(2, 3));
+    TMatrixView<const double> c = TDynamicMatrix<double>(a).view();
+    EXPECT_EQ(c.rows(), 3);
+}
+
+TEST(TMatrixView, assignment_copies_elements_into_block)
+{
+    TDynamicMatrix<double> a(5, 5, 0.0);
+    TDynamicMatrix<double> b = testMatrix(2, 3);
+    a.block(2, 1, 2, 3) = b;
+    EXPECT_EQ(copyBlock(a, 2, 1, 2, 3), b);
+    EXPECT_EQ(a(1, 1), 0);
+    EXPECT_EQ(a(2, 0), 0);
+    EXPECT_EQ(a(2, 4), 0);
+}
+
+TEST(TMatrixView, assignment_with_different_size_throws)
+{
+    TDynamicMatrix<double> a(5, 5);
+    TDynamicMatrix<double> b(2, 2);
+    ASSERT_ANY_THROW(a.block(0, 0, 2, 3) = b);
+}
+
+TEST(TMatrixView, block_to_block_assignment_copies_between_matrices)
+{
+    TDynamicMatrix<double> a = testMatrix(6, 6);
+    TDynamicMatrix<double> b(4, 4, 0.0);
+    b.block(1, 1, 3, 3) = a.block(2, 3, 3, 3);
+    EXPECT_EQ(copyBlock(b, 1, 1, 3, 3), copyBlock(a, 2, 3, 3, 3));
+}
+
+TEST(TMatrixView, expression_of_blocks_matches_copies)
+{
+    TDynamicMatrix<double> a = testMatrix(9, 7);
+    TDynamicMatrix<double> c(9, 7, 1.0);
+    c.block(3, 2, 4, 5) = a.block(0, 0, 4, 5) + a.block(5, 2, 4, 5) * 2.0;
+    TDynamicMatrix<double> expected = copyBlock(a, 0, 0, 4, 5) + copyBlock(a, 5, 2, 4, 5) * 2.0;
+    EXPECT_EQ(copyBlock(c, 3, 2, 4, 5), expected);
+    EXPECT_EQ(c(2, 2), 1);
+}
+
+TEST(TMatrixView, mixed_view_and_matrix_expression)
+{
+    TDynamicMatrix<double> a = testMatrix(6, 6);
+    TDynamicMatrix<double> b = testMatrix(3, 3);
+    TDynamicMatrix<double> c = b - a.block(3, 3, 3, 3);
+    EXPECT_EQ(c, b - copyBlock(a, 3, 3, 3, 3));
+}
+
+TEST(TMatrixView, compound_operators_update_block_in_place)
+{
+    TDynamicMatrix<double> a = testMatrix(5, 6);
+    TDynamicMatrix<double> b = testMatrix(3, 2);
+    TDynamicMatrix<double> expected = (copyBlock(a, 1, 3, 3, 2) + b - b * 0.5) * 3.0;
+    a.block(1, 3, 3, 2) += b;
+    a.block(1, 3, 3, 2) -= b * 0.5;
+    a.block(1, 3, 3, 2) *= 3.0;
+    EXPECT_EQ(copyBlock(a, 1, 3, 3, 2), expected);
+    EXPECT_EQ(a(0, 3), testMatrix(5, 6)(0, 3));
+}
+
+TEST(TMatrixView, axpy_updates_block)
+{
+    TDynamicMatrix<double> a(4, 4, 1.0);
+    TDynamicMatrix<double> x = testMatrix(2, 2);
+    a.block(2, 2, 2, 2).axpy(2.0, x);
+    EXPECT_EQ(copyBlock(a, 2, 2, 2, 2), TDynamicMatrix<double>(2, 2, 1.0) + x * 2.0);
+}
+
+TEST(TMatrixView, product_of_blocks_matches_copies)
+{
+    TDynamicMatrix<double> a = testMatrix(40, 30);
+    TDynamicMatrix<double> b = testMatrix(30, 50);
+    TDynamicMatrix<double> c = a.block(5, 3, 20, 17) * b.block(10, 7, 17, 25);
+    EXPECT_EQ(c, copyBlock(a, 5, 3, 20, 17) * copyBlock(b, 10, 7, 17, 25));
+}
+
+TEST(TMatrixView, product_of_block_and_vector)
+{
+    TDynamicMatrix<double> a = testMatrix(10, 10);
+    TDynamicVector<double> x(4);
+    for (size_t i = 0; i < 4; i++)
+        x[i] = double(i) + 1;
+    EXPECT_EQ(a.block(2, 3, 5, 4) * x, copyBlock(a, 2, 3, 5, 4) * x);
+}
+
+TEST(TMatrixView, gemm_accumulates_into_block)
+{
+    TDynamicMatrix<double> a = testMatrix(12, 9);
+    TDynamicMatrix<double> b = testMatrix(9, 14);
+    TDynamicMatrix<double> c(20, 20, 1.0);
+    gemm(2.0, a.block(0, 0, 12, 9), b, 0.5, c.block(4, 5, 12, 14));
+    TDynamicMatrix<double> expected = (a * b) * 2.0 + TDynamicMatrix<double>(12, 14, 0.5);
+    TDynamicMatrix<double> got = copyBlock(c, 4, 5, 12, 14);
+    for (size_t i = 0; i < 12; i++)
+        for (size_t j = 0; j < 14; j++)
+            EXPECT_NEAR(got(i, j), expected(i, j), 1e-12);
+    EXPECT_EQ(c(3, 5), 1);
+    EXPECT_EQ(c(4, 4), 1);
+}
+
+TEST(TMatrixView, gemm_with_inconsistent_sizes_throws)
+{
+    TDynamicMatrix<double> a(3, 4), b(5, 2), c(3, 2);
+    ASSERT_ANY_THROW(gemm(1.0, a, b, 0.0, c));
+}
+
+TEST(TMatrixView, blocked_product_through_views_matches_direct_product)
+{
+    const size_t n = 48, nb = 16;
+    TDynamicMatrix<double> a = testMatrix(n, n);
+    TDynamicMatrix<double> b = testMatrix(n, n) * 0.25;
+    TDynamicMatrix<double> c(n, n, 0.0);
+    for (size_t i = 0; i < n; i += nb)
+        for (size_t j = 0; j < n; j += nb)
+            for (size_t k = 0; k < n; k += nb)
+                gemm(1.0, a.block(i, k, nb, nb), b.block(k, j, nb, nb), 1.0, c.block(i, j, nb, nb));
+    TDynamicMatrix<double> expected = a * b;
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < n; j++)
+            EXPECT_NEAR(c(i, j), expected(i, j), 1e-10);
+}
+
+TEST(TMatrixView, views_do_not_allocate)
+{
+    TDynamicMatrix<double> a = testMatrix(8, 8);
+    TDynamicMatrix<double> b = testMatrix(4, 4);
+    const size_t before = allocationCount();
+    a.block(0, 0, 4, 4) = b;
+    a.block(4, 4, 4, 4) += a.block(0, 0, 4, 4) * 2.0;
+    a.col(3) *= 2.0;
+    gemm(1.0, a.block(0, 0, 4, 4), b, 1.0, a.block(4, 0, 4, 4));
+    EXPECT_EQ(allocationCount(), before);
+}
+
+TEST(TMatrixView, rows_of_block_are_matrix_rows)
+{
+    TDynamicMatrix<double> a = testMatrix(5, 5);
+    TMatrixView<double> b = a.block(1, 1, 3, 3);
+    EXPECT_EQ(b[1].size(), 3);
+    b[1][2] = -1;
+    EXPECT_EQ(a(2, 3), -1);
+}
+
+TEST(TMatrixView, output_of_block_prints_only_block)
+{
+    TDynamicMatrix<double> a(3, 3, 0.0);
+    a(1, 1) = 1; a(1, 2) = 2; a(2, 1) = 3; a(2, 2) = 4;
+    stringstream s;
+    s << a.block(1, 1, 2, 2);
+    EXPECT_EQ(s.str(), "1 2 \n3 4 \n");
+}
+
+TEST(TMatrixView, input_into_block_keeps_other_elements)
+{
+    TDynamicMatrix<double> a(3, 4, 9.0);
+    stringstream s("1 2 3 4 5 6");
+    s >> a.block(1, 1, 2, 3);
+    EXPECT_EQ(a(1, 1), 1);
+    EXPECT_EQ(a(1, 3), 3);
+    EXPECT_EQ(a(2, 1), 4);
+    EXPECT_EQ(a(2, 3), 6);
+    EXPECT_EQ(a(1, 0), 9);
+    EXPECT_EQ(a(0, 1), 9);
+}
+
+TEST(TVectorView, column_view_walks_with_row_stride)
+{
+    TDynamicMatrix<double> a = testMatrix(4, 3);
+    TVectorView<double> c = a.col(2);
+    ASSERT_EQ(c.size(), 4);
+    EXPECT_EQ(c.stride(), 3);
+    for (size_t i = 0; i < 4; i++)
+        EXPECT_EQ(c[i], a(i, 2));
+    c[3] = 7;
+    EXPECT_EQ(a(3, 2), 7);
+}
+
+TEST(TVectorView, strided_view_of_vector)
+{
+    TDynamicVector<int> v(10);
+    for (size_t i = 0; i < 10; i++)
+        v[i] = int(i);
+    TVectorView<int> s = v.view(1, 4, 2);
+    EXPECT_EQ(s[0], 1);
+    EXPECT_EQ(s[3], 7);
+    ASSERT_ANY_THROW(s[4]);
+    ASSERT_ANY_THROW(v.view(1, 6, 2));
+    ASSERT_ANY_THROW(v.view(10, 1));
+    EXPECT_EQ(s.view(1, 2, 2)[1], 7);
+}
+
+TEST(TVectorView, arithmetic_with_views_and_vectors)
+{
+    TDynamicVector<int> v(6, 1);
+    TDynamicVector<int> w(3);
+    for (size_t i = 0; i < 3; i++)
+        w[i] = int(i) + 1;
+    v.view(0, 3, 2) += w;
+    v.view(0, 3, 2) *= 2;
+    TDynamicVector<int> expected(6, 1);
+    expected[0] = 4; expected[2] = 6; expected[4] = 8;
+    EXPECT_EQ(v, expected);
+    TDynamicVector<int> sum = v.view(1, 3, 2) + w;
+    EXPECT_EQ(sum[2], 4);
+    EXPECT_EQ(v.view(0, 3, 2) * w, 4 + 12 + 24);
+}
+
+TEST(TVectorView, assignment_between_row_and_column)
+{
+    TDynamicMatrix<double> a = testMatrix(4, 4);
+    TDynamicMatrix<double> b(4, 4, 0.0);
+    b.col(1) = a.row(2);
+    for (size_t i = 0; i < 4; i++)
+        EXPECT_EQ(b(i, 1), a(2, i));
+    EXPECT_EQ(b.col(1), a.row(2));
+    ASSERT_ANY_THROW(b.col(1) = TDynamicVector<double>(3));
+}
+
+TEST(TVectorView, vector_update_from_column)
+{
+    TDynamicMatrix<double> a = testMatrix(5, 3);
+    TDynamicVector<double> v(5, 1.0);
+    v += a.col(1);
+    v.axpy(2.0, a.col(0));
+    for (size_t i = 0; i < 5; i++)
+        EXPECT_EQ(v[i], 1.0 + a(i, 1) + 2.0 * a(i, 0));
+}
+
+TEST(TVectorView, matrix_times_column_view)
+{
+    TDynamicMatrix<double> a = testMatrix(6, 6);
+    TDynamicVector<double> x(6);
+    for (size_t i = 0; i < 6; i++)
+        x[i] = a(i, 4);
+    EXPECT_EQ(a * a.col(4), a * x);
+}
+
+TEST(TVectorView, io_of_strided_view)
+{
+    TDynamicVector<int> v(6, 0);
+    stringstream in("5 6 7");
+    in >> v.view(0, 3, 2);
+    stringstream out;
+    out << v.view(0, 3, 2);
+    EXPECT_EQ(out.str(), "5 6 7 ");
+    EXPECT_EQ(v[1], 0);
+    EXPECT_EQ(v[4], 7);
+}
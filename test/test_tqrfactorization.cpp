@@ -0,0 +1,159 @@
+﻿#include "utmatrix.h"
+#include <gtest.h>
+
+static TDynamicMatrix<double> testMatrix(size_t m, size_t n, unsigned seed)
+{
+    TDynamicMatrix<double> a(m, n);
+    for (size_t i = 0; i < m; i++)
+        for (size_t j = 0; j < n; j++)
+            a(i, j) = double((i * 37 + j * 11 + seed * 7) % 19) / 19.0 - 0.5 + (i == j ? 1.0 : 0.0);
+    return a;
+}
+
+static TDynamicMatrix<double> transposed(const TDynamicMatrix<double>& a)
+{
+    TDynamicMatrix<double> t(a.cols(), a.rows());
+    for (size_t i = 0; i < a.rows(); i++)
+        for (size_t j = 0; j < a.cols(); j++)
+            t(j, i) = a(i, j);
+    return t;
+}
+
+static double maxAbsDiff(const TDynamicMatrix<double>& a, const TDynamicMatrix<double>& b)
+{
+    double d = 0;
+    for (size_t i = 0; i < a.rows(); i++)
+        for (size_t j = 0; j < a.cols(); j++)
+            d = std::max(d, std::abs(a(i, j) - b(i, j)));
+    return d;
+}
+
+static TDynamicMatrix<double> identity(size_t n)
+{
+    TDynamicMatrix<double> e(n, n);
+    for (size_t i = 0; i < n; i++)
+        e(i, i) = 1.0;
+    return e;
+}
+
+TEST(TQRFactorization, can_factor_tall_matrix)
+{
+    ASSERT_NO_THROW(TQRFactorization<double> qr(testMatrix(7, 3, 1)));
+}
+
+TEST(TQRFactorization, throws_when_matrix_is_wide)
+{
+    ASSERT_ANY_THROW(TQRFactorization<double> qr(TDynamicMatrix<double>(3, 4)));
+}
+
+TEST(TQRFactorization, q_is_orthonormal_and_qr_reproduces_matrix)
+{
+    TDynamicMatrix<double> a = testMatrix(150, 70, 2);
+    TQRFactorization<double> qr(a, 16);
+    TDynamicMatrix<double> q = qr.q();
+    EXPECT_LT(maxAbsDiff(transposed(q) * q, identity(70)), 1e-12);
+    EXPECT_LT(maxAbsDiff(q * TDynamicMatrix<double>(qr.r()), a), 1e-12);
+}
+
+TEST(TQRFactorization, r_does_not_depend_on_block_size)
+{
+    TDynamicMatrix<double> a = testMatrix(90, 45, 3);
+    TDynamicMatrix<double> r1(TQRFactorization<double>(a, 1).r());
+    TDynamicMatrix<double> r7(TQRFactorization<double>(a, 7).r());
+    TDynamicMatrix<double> r64(TQRFactorization<double>(a, 64).r());
+    EXPECT_LT(maxAbsDiff(r1, r7), 1e-12);
+    EXPECT_LT(maxAbsDiff(r1, r64), 1e-12);
+}
+
+TEST(TQRFactorization, multiplication_by_q_and_qt_are_inverse)
+{
+    TQRFactorization<double> qr(testMatrix(60, 25, 4), 8);
+    TDynamicVector<double> b(60);
+    for (size_t i = 0; i < 60; i++) b[i] = double(i % 5) - 2.0;
+    TDynamicVector<double> c = qr.multiplyQ(qr.multiplyQt(b));
+    for (size_t i = 0; i < 60; i++)
+        EXPECT_NEAR(c[i], b[i], 1e-12);
+    ASSERT_ANY_THROW(qr.multiplyQt(TDynamicVector<double>(25)));
+}
+
+TEST(TQRFactorization, solves_consistent_system_exactly)
+{
+    TDynamicMatrix<double> a = testMatrix(200, 30, 5);
+    TDynamicVector<double> x(30);
+    for (size_t i = 0; i < 30; i++) x[i] = double(i % 7) - 3.0;
+    TDynamicVector<double> y = TQRFactorization<double>(a, 8).solve(a * x);
+    for (size_t i = 0; i < 30; i++)
+        EXPECT_NEAR(y[i], x[i], 1e-11);
+}
+
+TEST(TQRFactorization, least_squares_residual_is_orthogonal_to_columns)
+{
+    TDynamicMatrix<double> a = testMatrix(120, 20, 6), b(120, 3);
+    for (size_t i = 0; i < 120; i++)
+        for (size_t j = 0; j < 3; j++)
+            b(i, j) = double((i * 3 + j * 5) % 11) - 5.0;
+    TDynamicMatrix<double> x = TQRFactorization<double>(a, 8).solve(b);
+    EXPECT_EQ(x.rows(), 20);
+    EXPECT_EQ(x.cols(), 3);
+    TDynamicMatrix<double> r = a * x - b;
+    EXPECT_LT(maxAbsDiff(transposed(a) * r, TDynamicMatrix<double>(20, 3)), 1e-10);
+}
+
+TEST(TQRFactorization, square_solve_matches_lu)
+{
+    TDynamicMatrix<double> a = testMatrix(50, 50, 7);
+    TDynamicVector<double> b(50);
+    for (size_t i = 0; i < 50; i++) b[i] = double(i % 3);
+    TDynamicVector<double> x = TQRFactorization<double>(a).solve(b), y = TLUFactorization<double>(a).solve(b);
+    for (size_t i = 0; i < 50; i++)
+        EXPECT_NEAR(x[i], y[i], 1e-10);
+}
+
+TEST(TQRFactorization, throws_when_solve_rank_deficient_system)
+{
+    TDynamicMatrix<double> a = testMatrix(10, 4, 8);
+    for (size_t i = 0; i < 10; i++)
+        a(i, 3) = 0.0;
+    TQRFactorization<double> qr(a);
+    EXPECT_FALSE(qr.fullRank());
+    ASSERT_ANY_THROW(qr.solve(TDynamicVector<double>(10)));
+}
+
+TEST(TTallSkinnyQR, r_matches_householder_qr_up_to_row_signs)
+{
+    TDynamicMatrix<double> a = testMatrix(300, 20, 9);
+    TTallSkinnyQR<double> tsqr(a, 40);
+    EXPECT_EQ(tsqr.leafCount(), 7);
+    TDynamicMatrix<double> r1(tsqr.r()), r2(TQRFactorization<double>(a).r());
+    for (size_t i = 0; i < 20; i++) {
+        const double s = (r1(i, i) < 0) == (r2(i, i) < 0) ? 1.0 : -1.0;
+        for (size_t j = i; j < 20; j++)
+            EXPECT_NEAR(r1(i, j), s * r2(i, j), 1e-11);
+    }
+}
+
+TEST(TTallSkinnyQR, q_is_orthonormal_and_qr_reproduces_matrix)
+{
+    TDynamicMatrix<double> a = testMatrix(257, 16, 10);
+    TTallSkinnyQR<double> tsqr(a, 50);
+    TDynamicMatrix<double> q = tsqr.q();
+    EXPECT_LT(maxAbsDiff(transposed(q) * q, identity(16)), 1e-12);
+    EXPECT_LT(maxAbsDiff(q * TDynamicMatrix<double>(tsqr.r()), a), 1e-12);
+}
+
+TEST(TTallSkinnyQR, solve_matches_householder_qr)
+{
+    TDynamicMatrix<double> a = testMatrix(400, 12, 11);
+    TDynamicVector<double> b(400);
+    for (size_t i = 0; i < 400; i++) b[i] = double((i * 7) % 13) - 6.0;
+    TDynamicVector<double> x = TTallSkinnyQR<double>(a, 64).solve(b), y = TQRFactorization<double>(a).solve(b);
+    for (size_t i = 0; i < 12; i++)
+        EXPECT_NEAR(x[i], y[i], 1e-11);
+}
+
+TEST(TTallSkinnyQR, uses_at_least_n_rows_per_block)
+{
+    TTallSkinnyQR<double> tsqr(testMatrix(30, 10, 12), 3);
+    EXPECT_EQ(tsqr.leafCount(), 3);
+    ASSERT_ANY_THROW(TTallSkinnyQR<double>(TDynamicMatrix<double>(5, 6)));
+}
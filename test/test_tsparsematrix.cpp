@@ -0,0 +1,144 @@
+﻿#include "utmatrix.h"
+#include <gtest.h>
+#include <sstream>
+
+static TDynamicMatrix<double> sparsePattern(size_t r, size_t c, int seed)
+{
+    TDynamicMatrix<double> m(r, c);
+    for (size_t i = 0; i < r; i++)
+        for (size_t j = 0; j < c; j++)
+            m(i, j) = ((i * 5 + j * 3 + seed) % 7 == 0) ? double(i + 2 * j + 1) : 0.0;
+    return m;
+}
+
+TEST(TSparseMatrix, can_create_empty_sparse_matrix)
+{
+    TSparseMatrix<double> s(5, 7);
+    EXPECT_EQ(s.rows(), 5);
+    EXPECT_EQ(s.cols(), 7);
+    EXPECT_EQ(s.nonZeros(), 0);
+    EXPECT_EQ(s.at(4, 6), 0.0);
+}
+
+TEST(TSparseMatrix, dimensions_are_not_limited_by_dense_cap)
+{
+    const size_t n = 10 * MAX_MATRIX_SIZE;
+    std::vector<TSparseEntry<double>> entries;
+    for (size_t i = 0; i < n; i += 1000)
+        entries.push_back({ i, n - 1 - i, 2.0 });
+    TSparseMatrix<double> s(n, n, entries);
+    TDynamicVector<double> x(n);
+    x[n - 1] = 3.0;
+    TDynamicVector<double> y = s * x;
+    EXPECT_EQ(y[0], 6.0);
+    EXPECT_EQ(y[1000], 0.0);
+}
+
+TEST(TSparseMatrix, throws_when_create_matrix_with_zero_size)
+{
+    ASSERT_ANY_THROW(TSparseMatrix<double> s(0, 3));
+    ASSERT_ANY_THROW(TSparseMatrix<double> s(3, 0));
+}
+
+TEST(TSparseMatrix, triplets_are_sorted_and_duplicates_summed)
+{
+    std::vector<TSparseEntry<int>> entries = { { 1, 2, 4 }, { 0, 1, 1 }, { 1, 0, 2 }, { 1, 2, 3 }, { 0, 0, 5 }, { 0, 0, -5 } };
+    TSparseMatrix<int> s(2, 3, entries);
+    EXPECT_EQ(s.nonZeros(), 3);
+    EXPECT_EQ(s.at(1, 2), 7);
+    EXPECT_EQ(s.at(0, 0), 0);
+    std::vector<size_t> outer = { 0, 1, 3 }, inner = { 1, 0, 2 };
+    EXPECT_EQ(s.outerIndex(), outer);
+    EXPECT_EQ(s.innerIndex(), inner);
+}
+
+TEST(TSparseMatrix, throws_when_triplet_is_out_of_range)
+{
+    std::vector<TSparseEntry<int>> entries = { { 2, 0, 1 } };
+    ASSERT_ANY_THROW(TSparseMatrix<int> s(2, 2, entries));
+}
+
+TEST(TSparseMatrix, can_convert_to_and_from_dense_matrix)
+{
+    TDynamicMatrix<double> d = sparsePattern(6, 9, 1);
+    TSparseMatrix<double> csr(d), csc(d, TSparseFormat::CSC);
+    EXPECT_EQ(csc.format(), TSparseFormat::CSC);
+    EXPECT_EQ(TDynamicMatrix<double>(csr), d);
+    EXPECT_EQ(TDynamicMatrix<double>(csc), d);
+    for (size_t i = 0; i < 6; i++)
+        for (size_t j = 0; j < 9; j++)
+            EXPECT_EQ(csc.at(i, j), d[i][j]);
+}
+
+TEST(TSparseMatrix, formats_convert_into_each_other)
+{
+    TSparseMatrix<double> csr(sparsePattern(7, 5, 2));
+    TSparseMatrix<double> csc = csr.convert(TSparseFormat::CSC);
+    EXPECT_EQ(csc.nonZeros(), csr.nonZeros());
+    EXPECT_EQ(csc.outerIndex().size(), 6);
+    EXPECT_EQ(csc, csr);
+    EXPECT_EQ(csc.convert(TSparseFormat::CSR).innerIndex(), csr.innerIndex());
+}
+
+TEST(TSparseMatrix, can_multiply_by_vector)
+{
+    TDynamicMatrix<double> d = sparsePattern(11, 8, 3);
+    TDynamicVector<double> x(8);
+    for (size_t i = 0; i < 8; i++) x[i] = double(i) - 3.0;
+    TDynamicVector<double> expected = d * x;
+    EXPECT_EQ(TSparseMatrix<double>(d) * x, expected);
+    EXPECT_EQ(TSparseMatrix<double>(d, TSparseFormat::CSC) * x, expected);
+    EXPECT_EQ(TSparseMatrix<double>(d) * (x + x), d * (x + x));
+    ASSERT_ANY_THROW(TSparseMatrix<double>(d) * TDynamicVector<double>(7));
+}
+
+TEST(TSparseMatrix, can_multiply_by_dense_matrix)
+{
+    TDynamicMatrix<double> d = sparsePattern(9, 6, 4), b(6, 5);
+    for (size_t i = 0; i < 6; i++)
+        for (size_t j = 0; j < 5; j++)
+            b(i, j) = double(i * 5 + j);
+    TDynamicMatrix<double> expected = d * b;
+    EXPECT_EQ(TSparseMatrix<double>(d) * b, expected);
+    EXPECT_EQ(TSparseMatrix<double>(d, TSparseFormat::CSC) * b, expected);
+    ASSERT_ANY_THROW(TSparseMatrix<double>(d) * TDynamicMatrix<double>(5, 5));
+}
+
+TEST(TSparseMatrix, can_add_and_subtract_sparse_matrices)
+{
+    TDynamicMatrix<double> a = sparsePattern(8, 8, 1), b = sparsePattern(8, 8, 3);
+    TSparseMatrix<double> sa(a), sb(b, TSparseFormat::CSC);
+    TSparseMatrix<double> sum = sa + sb, diff = sa - sb;
+    EXPECT_EQ(sum.format(), TSparseFormat::CSR);
+    EXPECT_EQ(TDynamicMatrix<double>(sum), a + b);
+    EXPECT_EQ(TDynamicMatrix<double>(diff), a - b);
+    EXPECT_EQ((sa - sa).nonZeros(), 0);
+    ASSERT_ANY_THROW(sa + TSparseMatrix<double>(8, 7));
+}
+
+TEST(TSparseMatrix, can_scale_sparse_matrix)
+{
+    TDynamicMatrix<double> a = sparsePattern(5, 5, 1);
+    TSparseMatrix<double> s(a);
+    EXPECT_EQ(TDynamicMatrix<double>(s * 2.0), a * 2.0);
+    EXPECT_EQ((s * 0.0).nonZeros(), 0);
+}
+
+TEST(TSparseMatrix, mixed_with_dense_matrix_gives_dense_result)
+{
+    TDynamicMatrix<double> a = sparsePattern(4, 4, 1), b = sparsePattern(4, 4, 2);
+    TSparseMatrix<double> s(a);
+    TDynamicMatrix<double> sum = b + s;
+    EXPECT_EQ(sum, a + b);
+    EXPECT_EQ(b * s, b * a);
+}
+
+TEST(TSparseMatrix, can_write_and_read_sparse_matrix)
+{
+    TSparseMatrix<int> s(3, 4, { { 0, 3, 1 }, { 2, 1, -4 } });
+    std::stringstream ss;
+    ss << s;
+    TSparseMatrix<int> r;
+    ss >> r;
+    EXPECT_EQ(r, s);
+}
@@ -0,0 +1,68 @@
+﻿#include "utmatrix.h"
+#include <gtest.h>
+
+TEST(TThreadPool, has_at_least_one_thread)
+{
+    TThreadPool pool(1);
+    EXPECT_EQ(pool.threadCount(), 1);
+    EXPECT_GE(TThreadPool::instance().threadCount(), 1);
+}
+
+TEST(TThreadPool, can_change_thread_count)
+{
+    TThreadPool pool(2);
+    EXPECT_EQ(pool.threadCount(), 2);
+    pool.setThreadCount(4);
+    EXPECT_EQ(pool.threadCount(), 4);
+    pool.setThreadCount(0);
+    EXPECT_EQ(pool.threadCount(), 1);
+}
+
+TEST(TThreadPool, parallel_for_visits_each_index_once)
+{
+    TThreadPool pool(4);
+    std::vector<std::atomic<int>> hits(1000);
+    for (auto& h : hits) h = 0;
+    pool.parallelFor(0, hits.size(), 7, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; i++) hits[i]++;
+    });
+    for (size_t i = 0; i < hits.size(); i++)
+        EXPECT_EQ(hits[i], 1);
+}
+
+TEST(TThreadPool, parallel_for_respects_grain)
+{
+    TThreadPool pool(4);
+    std::atomic<size_t> calls{0};
+    pool.parallelFor(10, 20, 100, [&](size_t b, size_t e) {
+        EXPECT_EQ(b, 10);
+        EXPECT_EQ(e, 20);
+        calls++;
+    });
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(TThreadPool, nested_parallel_for_runs_serially)
+{
+    TThreadPool pool(3);
+    std::atomic<size_t> total{0};
+    pool.parallelFor(0, 30, 1, [&](size_t b, size_t e) {
+        pool.parallelFor(0, 10 * (e - b), 1, [&](size_t ib, size_t ie) { total += ie - ib; });
+    });
+    EXPECT_EQ(total, 300);
+}
+
+TEST(TThreadPool, parallel_for_rethrows_exception)
+{
+    TThreadPool pool(4);
+    ASSERT_ANY_THROW(pool.parallelFor(0, 100, 1, [](size_t b, size_t) {
+        if (b == 0) throw out_of_range("");
+    }));
+    size_t sum = 0;
+    std::mutex m;
+    pool.parallelFor(0, 100, 1, [&](size_t b, size_t e) {
+        std::lock_guard<std::mutex> lock(m);
+        sum += e - b;
+    });
+    EXPECT_EQ(sum, 100);
+}
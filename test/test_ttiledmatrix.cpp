@@ -0,0 +1,179 @@
+﻿#include "utmatrix.h"
+#include <gtest.h>
+
+static TDynamicMatrix<double> testMatrix(size_t m, size_t n, double shift = 0.0)
+{
+    TDynamicMatrix<double> a(m, n);
+    for (size_t i = 0; i < m; i++)
+        for (size_t j = 0; j < n; j++)
+            a(i, j) = double(i) * 0.5 - double(j) / 3.0 + shift;
+    return a;
+}
+
+static void expectNear(const TDynamicMatrix<double>& a, const TDynamicMatrix<double>& b, double eps)
+{
+    ASSERT_EQ(a.rows(), b.rows());
+    ASSERT_EQ(a.cols(), b.cols());
+    for (size_t i = 0; i < a.rows(); i++)
+        for (size_t j = 0; j < a.cols(); j++)
+            EXPECT_NEAR(a(i, j), b(i, j), eps);
+}
+
+TEST(TTiledMatrix, can_create_tiled_matrix)
+{
+    ASSERT_NO_THROW(TTiledMatrix<double> m(100, 70, 32, 4));
+}
+
+TEST(TTiledMatrix, tile_grid_covers_matrix_with_edge_tiles)
+{
+    TTiledMatrix<double> m(100, 70, 32, 4);
+    EXPECT_EQ(m.tileRows(), 4);
+    EXPECT_EQ(m.tileCols(), 3);
+    EXPECT_EQ(m.tile(3, 2).rows(), 4);
+    EXPECT_EQ(m.tile(3, 2).cols(), 6);
+    EXPECT_EQ(m.tile(0, 0).rows(), 32);
+}
+
+TEST(TTiledMatrix, throws_on_invalid_parameters)
+{
+    ASSERT_ANY_THROW(TTiledMatrix<double> m(0, 10));
+    ASSERT_ANY_THROW(TTiledMatrix<double> m(10, 10, 0));
+    ASSERT_ANY_THROW(TTiledMatrix<double> m(10, 10, 4, 2));
+    TTiledMatrix<double> m(10, 10, 4, 3);
+    ASSERT_ANY_THROW(m.tile(3, 0));
+    ASSERT_ANY_THROW(m.get(10, 0));
+}
+
+TEST(TTiledMatrix, new_matrix_is_zero_and_reads_nothing)
+{
+    TTiledMatrix<double> m(50, 50, 16, 4);
+    for (size_t i = 0; i < 50; i += 7)
+        for (size_t j = 0; j < 50; j += 5)
+            EXPECT_EQ(m.get(i, j), 0.0);
+    EXPECT_EQ(m.stats().bytesRead, 0);
+    EXPECT_EQ(m.stats().bytesWritten, 0);
+}
+
+TEST(TTiledMatrix, round_trip_through_file_keeps_elements)
+{
+    TDynamicMatrix<double> a = testMatrix(45, 38);
+    TTiledMatrix<double> t(a, 8, 3); // кэш много меньше матрицы: плитки вытесняются в файл
+    EXPECT_GT(t.stats().bytesWritten, 0);
+    EXPECT_EQ(t.toDense(), a);
+    EXPECT_GT(t.stats().bytesRead, 0);
+}
+
+TEST(TTiledMatrix, set_and_get_elements_across_evictions)
+{
+    TTiledMatrix<int> t(40, 40, 8, 3);
+    for (size_t i = 0; i < 40; i++)
+        for (size_t j = 0; j < 40; j++)
+            t.set(i, j, int(i * 40 + j));
+    for (size_t i = 0; i < 40; i++)
+        for (size_t j = 0; j < 40; j++)
+            ASSERT_EQ(t.get(i, j), int(i * 40 + j));
+}
+
+TEST(TTiledMatrix, stats_count_tile_traffic)
+{
+    TTiledMatrix<double> t(testMatrix(32, 32), 16, 4);
+    t.flush();
+    const size_t tileBytes = 16 * 16 * sizeof(double);
+    EXPECT_EQ(t.stats().bytesWritten, 4 * tileBytes);
+    EXPECT_EQ(t.stats().tileWrites, 4);
+    t.resetStats();
+    t.setCacheTiles(3);
+    t.tile(1, 1);
+    t.tile(1, 1);
+    EXPECT_EQ(t.stats().cacheHits, 2);
+    t.flush();
+    EXPECT_EQ(t.stats().bytesWritten, tileBytes); // только изменённая плитка
+    EXPECT_EQ(t.stats().bytesRead, 0);
+}
+
+TEST(TTiledMatrix, addition_matches_dense)
+{
+    TDynamicMatrix<double> a = testMatrix(70, 50), b = testMatrix(70, 50, 1.5);
+    TTiledMatrix<double> ta(a, 16, 3), tb(b, 16, 3);
+    EXPECT_EQ((ta + tb).toDense(), a + b);
+    EXPECT_EQ((ta - tb).toDense(), a - b);
+    ta += tb;
+    EXPECT_EQ(ta.toDense(), a + b);
+}
+
+TEST(TTiledMatrix, addition_with_different_tiles_throws)
+{
+    TTiledMatrix<double> a(20, 20, 8), b(20, 20, 4), c(20, 21, 8);
+    ASSERT_ANY_THROW(a + b);
+    ASSERT_ANY_THROW(a + c);
+}
+
+TEST(TTiledMatrix, matrix_vector_product_matches_dense)
+{
+    TDynamicMatrix<double> a = testMatrix(83, 61);
+    TDynamicVector<double> x(61);
+    for (size_t i = 0; i < 61; i++)
+        x[i] = 1.0 / double(i + 1);
+    TTiledMatrix<double> t(a, 16, 3);
+    TDynamicVector<double> y = t * x, expected = a * x;
+    for (size_t i = 0; i < 83; i++)
+        EXPECT_NEAR(y[i], expected[i], 1e-12);
+}
+
+TEST(TTiledMatrix, product_matches_dense)
+{
+    TDynamicMatrix<double> a = testMatrix(75, 50), b = testMatrix(50, 66, -2.0);
+    TTiledMatrix<double> ta(a, 16, 4), tb(b, 16, 4);
+    expectNear((ta * tb).toDense(), a * b, 1e-10);
+}
+
+TEST(TTiledMatrix, product_of_matrix_with_itself)
+{
+    TDynamicMatrix<double> a = testMatrix(40, 40);
+    TTiledMatrix<double> t(a, 16, 3);
+    expectNear((t * t).toDense(), a * a, 1e-10);
+}
+
+TEST(TTiledMatrix, product_reads_each_tile_once_when_cache_holds_operands)
+{
+    TTiledMatrix<double> a(testMatrix(64, 64), 16, 16), b(testMatrix(64, 64), 16, 16);
+    a.clearCache();
+    b.clearCache();
+    a.resetStats();
+    b.resetStats();
+    TTiledMatrix<double> c = a * b;
+    EXPECT_EQ(a.stats().tileReads, 16);
+    EXPECT_EQ(b.stats().tileReads, 16);
+}
+
+TEST(TTiledMatrix, serpentine_order_reduces_reads_with_small_cache)
+{
+    TTiledMatrix<double> a(testMatrix(96, 96), 16, 3), b(testMatrix(96, 96), 16, 3);
+    a.clearCache();
+    b.clearCache();
+    a.setCacheTiles(7);
+    b.setCacheTiles(7);
+    a.resetStats();
+    b.resetStats();
+    TTiledMatrix<double> c = a * b;
+    // Без повторного использования каждая из 6^3 пар плиток читалась бы заново
+    EXPECT_LT(a.stats().tileReads + b.stats().tileReads, 2u * 6 * 6 * 6);
+    expectNear(c.toDense(), testMatrix(96, 96) * testMatrix(96, 96), 1e-9);
+}
+
+TEST(TTiledMatrix, clear_cache_writes_back_changes)
+{
+    TTiledMatrix<int> t(20, 20, 8, 4);
+    t.set(19, 19, 5);
+    t.clearCache();
+    EXPECT_EQ(t.stats().tileWrites, 1);
+    EXPECT_EQ(t.get(19, 19), 5);
+    EXPECT_EQ(t.stats().tileReads, 1);
+}
+
+TEST(TTiledMatrix, can_move_tiled_matrix)
+{
+    TTiledMatrix<double> a(testMatrix(30, 30), 8, 3);
+    TTiledMatrix<double> b(std::move(a));
+    EXPECT_EQ(b.toDense(), testMatrix(30, 30));
+}
@@ -0,0 +1,214 @@
+﻿#include "utmatrix.h"
+#include <gtest.h>
+
+template<typename M>
+static void fillTriangle(M& m, int seed)
+{
+    for (size_t i = 0; i < m.rows(); i++)
+        for (size_t j = m.rowBegin(i); j < m.rowBegin(i) + m.rowLength(i); j++)
+            m(i, j) = double((i * 7 + j * 3 + seed) % 11) - 5.0;
+}
+
+TEST(TTriangularMatrix, can_create_triangular_matrix)
+{
+    ASSERT_NO_THROW(TUpperTriangularMatrix<int> m(5));
+    ASSERT_NO_THROW(TLowerTriangularMatrix<int> m(5));
+}
+
+TEST(TTriangularMatrix, throws_when_create_matrix_with_zero_or_too_large_size)
+{
+    ASSERT_ANY_THROW(TUpperTriangularMatrix<int> m(0));
+    ASSERT_ANY_THROW(TLowerTriangularMatrix<int> m(MAX_MATRIX_SIZE + 1));
+}
+
+TEST(TTriangularMatrix, stores_only_triangle)
+{
+    TUpperTriangularMatrix<double> u(7);
+    TLowerTriangularMatrix<double> l(7);
+    EXPECT_EQ(u.rowOffset(6) + u.rowLength(6), 7 * 8 / 2);
+    EXPECT_EQ(l.rowOffset(6) + l.rowLength(6), 7 * 8 / 2);
+    EXPECT_EQ(u.rowData(1), u.data() + 7);
+    EXPECT_EQ(l.rowData(2), l.data() + 3);
+}
+
+TEST(TTriangularMatrix, elements_outside_triangle_are_zero_and_read_only)
+{
+    TUpperTriangularMatrix<int> u(3);
+    u.at(0, 2) = 5;
+    const TUpperTriangularMatrix<int>& cu = u;
+    EXPECT_EQ(cu.at(0, 2), 5);
+    EXPECT_EQ(cu.at(2, 0), 0);
+    ASSERT_ANY_THROW(u.at(2, 0));
+    ASSERT_ANY_THROW(u.at(0, 3));
+
+    TLowerTriangularMatrix<int> l(3);
+    ASSERT_NO_THROW(l.at(2, 0));
+    ASSERT_ANY_THROW(l.at(0, 2));
+}
+
+TEST(TTriangularMatrix, can_convert_to_and_from_dense_matrix)
+{
+    TDynamicMatrix<double> d(4, 4);
+    for (size_t i = 0; i < 4; i++)
+        for (size_t j = 0; j < 4; j++)
+            d[i][j] = double(i * 4 + j + 1);
+    TUpperTriangularMatrix<double> u(d);
+    TDynamicMatrix<double> back = u;
+    for (size_t i = 0; i < 4; i++)
+        for (size_t j = 0; j < 4; j++)
+            EXPECT_EQ(back[i][j], j >= i ? d[i][j] : 0.0);
+    ASSERT_ANY_THROW(TLowerTriangularMatrix<double> l(TDynamicMatrix<double>(2, 3)));
+}
+
+TEST(TTriangularMatrix, arithmetic_keeps_triangular_type)
+{
+    TUpperTriangularMatrix<double> a(6), b(6);
+    fillTriangle(a, 1);
+    fillTriangle(b, 2);
+    TUpperTriangularMatrix<double> s = a + b, d = a - b, m = a * 2.0;
+    for (size_t i = 0; i < 6; i++)
+        for (size_t j = i; j < 6; j++) {
+            EXPECT_EQ(s(i, j), a(i, j) + b(i, j));
+            EXPECT_EQ(d(i, j), a(i, j) - b(i, j));
+            EXPECT_EQ(m(i, j), a(i, j) * 2.0);
+        }
+    ASSERT_ANY_THROW(a + TUpperTriangularMatrix<double>(5));
+}
+
+TEST(TTriangularMatrix, mixed_with_dense_matrix_gives_dense_result)
+{
+    TUpperTriangularMatrix<double> u(3);
+    TLowerTriangularMatrix<double> l(3);
+    fillTriangle(u, 1);
+    fillTriangle(l, 2);
+    TDynamicMatrix<double> s = u + l;
+    for (size_t i = 0; i < 3; i++)
+        for (size_t j = 0; j < 3; j++)
+            EXPECT_EQ(s[i][j], u.eval(i, j) + l.eval(i, j));
+}
+
+TEST(TTriangularMatrix, can_multiply_by_vector)
+{
+    TUpperTriangularMatrix<double> u(9);
+    TLowerTriangularMatrix<double> l(9);
+    fillTriangle(u, 3);
+    fillTriangle(l, 4);
+    TDynamicVector<double> x(9);
+    for (size_t i = 0; i < 9; i++) x[i] = double(i) - 4.0;
+    EXPECT_EQ(u * x, TDynamicMatrix<double>(u) * x);
+    EXPECT_EQ(l * x, TDynamicMatrix<double>(l) * x);
+    EXPECT_EQ(u * (x + x), TDynamicMatrix<double>(u) * (x + x));
+    ASSERT_ANY_THROW(u * TDynamicVector<double>(8));
+}
+
+TEST(TTriangularMatrix, product_of_triangular_matrices_matches_dense_product)
+{
+    TUpperTriangularMatrix<double> a(37), b(37);
+    TLowerTriangularMatrix<double> c(37), d(37);
+    fillTriangle(a, 1);
+    fillTriangle(b, 2);
+    fillTriangle(c, 3);
+    fillTriangle(d, 4);
+    TUpperTriangularMatrix<double> ab = a * b;
+    TLowerTriangularMatrix<double> cd = c * d;
+    EXPECT_EQ(TDynamicMatrix<double>(ab), TDynamicMatrix<double>(a) * TDynamicMatrix<double>(b));
+    EXPECT_EQ(TDynamicMatrix<double>(cd), TDynamicMatrix<double>(c) * TDynamicMatrix<double>(d));
+}
+
+TEST(TTriangularMatrix, can_multiply_by_dense_matrix)
+{
+    TUpperTriangularMatrix<double> u(5);
+    fillTriangle(u, 1);
+    TDynamicMatrix<double> m(5, 3);
+    for (size_t i = 0; i < 5; i++)
+        for (size_t j = 0; j < 3; j++)
+            m[i][j] = double(i + j);
+    EXPECT_EQ(u * m, TDynamicMatrix<double>(u) * m);
+}
+
+TEST(TTriangularMatrix, can_compare_and_swap)
+{
+    TLowerTriangularMatrix<int> a(4), b(2);
+    a(3, 1) = 1;
+    TLowerTriangularMatrix<int> c(a);
+    EXPECT_EQ(a, c);
+    EXPECT_NE(a, b);
+    swap(a, b);
+    EXPECT_EQ(a.size(), 2);
+    EXPECT_EQ(b, c);
+}
+
+template<typename M>
+static void makeDiagonalDominant(M& m)
+{
+    for (size_t i = 0; i < m.rows(); i++)
+        m(i, i) = 10.0 + double(i);
+}
+
+template<typename M>
+static TDynamicMatrix<double> denseTranspose(const M& m)
+{
+    TDynamicMatrix<double> t(m.rows(), m.rows());
+    for (size_t i = 0; i < m.rows(); i++)
+        for (size_t j = 0; j < m.rows(); j++)
+            t[j][i] = m.at(i, j);
+    return t;
+}
+
+TEST(TTriangularMatrix, can_solve_triangular_system)
+{
+    TUpperTriangularMatrix<double> u(23);
+    TLowerTriangularMatrix<double> l(23);
+    fillTriangle(u, 1);
+    fillTriangle(l, 2);
+    makeDiagonalDominant(u);
+    makeDiagonalDominant(l);
+    TDynamicVector<double> x(23);
+    for (size_t i = 0; i < 23; i++) x[i] = double(i % 4) - 1.5;
+    TDynamicVector<double> xu = u.solve(u * x), xl = l.solve(l * x);
+    TDynamicVector<double> xut = u.solveTransposed(denseTranspose(u) * x);
+    TDynamicVector<double> xlt = l.solveTransposed(denseTranspose(l) * x);
+    for (size_t i = 0; i < 23; i++) {
+        EXPECT_NEAR(xu[i], x[i], 1e-12);
+        EXPECT_NEAR(xl[i], x[i], 1e-12);
+        EXPECT_NEAR(xut[i], x[i], 1e-12);
+        EXPECT_NEAR(xlt[i], x[i], 1e-12);
+    }
+}
+
+TEST(TTriangularMatrix, can_solve_with_several_right_hand_sides)
+{
+    TLowerTriangularMatrix<double> l(41);
+    fillTriangle(l, 3);
+    makeDiagonalDominant(l);
+    TDynamicMatrix<double> x(41, 7);
+    for (size_t i = 0; i < 41; i++)
+        for (size_t j = 0; j < 7; j++)
+            x[i][j] = double((i + 2 * j) % 5) - 2.0;
+    TDynamicMatrix<double> y = l.solve(l * x);
+    TDynamicMatrix<double> yt = l.solveTransposed(denseTranspose(l) * x);
+    for (size_t i = 0; i < 41; i++)
+        for (size_t j = 0; j < 7; j++) {
+            EXPECT_NEAR(y[i][j], x[i][j], 1e-12);
+            EXPECT_NEAR(yt[i][j], x[i][j], 1e-12);
+        }
+}
+
+TEST(TTriangularMatrix, throws_when_solve_singular_or_mismatched_system)
+{
+    TUpperTriangularMatrix<double> u(4);
+    fillTriangle(u, 1);
+    makeDiagonalDominant(u);
+    ASSERT_ANY_THROW(u.solve(TDynamicVector<double>(3)));
+    ASSERT_ANY_THROW(u.solve(TDynamicMatrix<double>(5, 2)));
+    u(2, 2) = 0.0;
+    ASSERT_ANY_THROW(u.solve(TDynamicVector<double>(4)));
+}
+
+TEST(TTriangularMatrix, throws_when_packed_size_overflows)
+{
+    const TSizeLimits saved = sizeLimits();
+    sizeLimits().maxMatrixSize = std::numeric_limits<size_t>::max();
+    EXPECT_THROW(TLowerTriangularMatrix<char> m(std::numeric_limits<size_t>::max() / 2), overflow_error);
+    sizeLimits() = saved;
+}
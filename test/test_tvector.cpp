@@ -1,5 +1,7 @@
 ﻿#include "utmatrix.h"
 #include <gtest.h>
+#include <sstream>
+#include <iomanip>
 
 TEST(TDynamicVector, can_create_vector_with_positive_length)
 {
@@ -200,3 +202,478 @@ TEST(TDynamicVector, cant_multiply_vectors_with_not_equal_size)
     TDynamicVector<int> v2(2);
     ASSERT_ANY_THROW(v1 * v2, invalid_argument); // Проверяем умножение векторов разного размера
 }
+
+template<typename T>
+static void checkSimdKernelsAgainstScalar()
+{
+    const size_t n = 67; // не кратно ширине ни одного регистра
+    T a[n], b[n], expected[n], res[n];
+    for (size_t i = 0; i < n; i++) {
+        a[i] = T(int(i % 13) - 6);
+        b[i] = T(int(i % 7) + 1);
+    }
+    const TSimdKernels<T>* scalar = simdKernels<T>(TSimdLevel::Scalar);
+    ASSERT_NE(scalar, nullptr);
+    for (int l = 0; l <= int(simdLevel()); l++) {
+        const TSimdKernels<T>* k = simdKernels<T>(TSimdLevel(l));
+        ASSERT_NE(k, nullptr);
+        scalar->add(a, b, expected, n);
+        k->add(a, b, res, n);
+        EXPECT_TRUE(std::equal(res, res + n, expected));
+        scalar->sub(a, b, expected, n);
+        k->sub(a, b, res, n);
+        EXPECT_TRUE(std::equal(res, res + n, expected));
+        scalar->addScalar(a, T(3), expected, n);
+        k->addScalar(a, T(3), res, n);
+        EXPECT_TRUE(std::equal(res, res + n, expected));
+        scalar->subScalar(a, T(3), expected, n);
+        k->subScalar(a, T(3), res, n);
+        EXPECT_TRUE(std::equal(res, res + n, expected));
+        scalar->mulScalar(a, T(-3), expected, n);
+        k->mulScalar(a, T(-3), res, n);
+        EXPECT_TRUE(std::equal(res, res + n, expected));
+        EXPECT_EQ(k->dot(a, b, n), scalar->dot(a, b, n)); // малые целые значения складываются точно
+        std::copy(b, b + n, expected);
+        std::copy(b, b + n, res);
+        scalar->axpy(T(2), a, expected, n);
+        k->axpy(T(2), a, res, n);
+        EXPECT_TRUE(std::equal(res, res + n, expected));
+        // Четыре строки по 15 элементов с шагом 17 внутри a: остаются хвосты
+        const size_t lda = 17, len = 15;
+        scalar->dotRows4(a, lda, b, expected, len);
+        k->dotRows4(a, lda, b, res, len);
+        EXPECT_TRUE(std::equal(res, res + 4, expected));
+        for (size_t q = 0; q < 4; q++)
+            EXPECT_EQ(res[q], scalar->dot(a + q * lda, b, len));
+        const T alpha[4] = { T(1), T(-2), T(3), T(2) };
+        std::copy(b, b + n, expected);
+        std::copy(b, b + n, res);
+        scalar->axpyRows4(alpha, a, lda, expected, len);
+        k->axpyRows4(alpha, a, lda, res, len);
+        EXPECT_TRUE(std::equal(res, res + n, expected));
+    }
+}
+
+TEST(TDynamicVector, simd_kernels_match_scalar_for_double)
+{
+    checkSimdKernelsAgainstScalar<double>();
+}
+
+TEST(TDynamicVector, simd_kernels_match_scalar_for_float)
+{
+    checkSimdKernelsAgainstScalar<float>();
+}
+
+TEST(TDynamicVector, simd_kernels_match_scalar_for_int32)
+{
+    checkSimdKernelsAgainstScalar<int32_t>();
+}
+
+TEST(TDynamicVector, simd_kernels_match_scalar_for_int64)
+{
+    checkSimdKernelsAgainstScalar<int64_t>();
+}
+
+TEST(TDynamicVector, int64_simd_multiply_keeps_high_bits)
+{
+    const int64_t big = int64_t(1) << 40;
+    int64_t a[9], res[9];
+    for (int i = 0; i < 9; i++) a[i] = big + i;
+    simdKernels<int64_t>()->mulScalar(a, -3, res, 9);
+    for (int i = 0; i < 9; i++)
+        EXPECT_EQ(res[i], (big + i) * -3);
+}
+
+TEST(TDynamicVector, types_without_simd_kernels_use_generic_path)
+{
+    EXPECT_EQ(simdKernels<short>(), nullptr);
+    TDynamicVector<short> v1(3), v2(3);
+    v1[0] = 2;
+    v2[0] = 5;
+    EXPECT_EQ((v1 + v2)[0], 7);
+    EXPECT_EQ(v1 * v2, 10);
+}
+
+TEST(TDynamicVector, can_compute_dot_product_of_long_double_vectors)
+{
+    TDynamicVector<double> v1(1001), v2(1001);
+    double expected = 0;
+    for (size_t i = 0; i < 1001; i++) {
+        v1[i] = double(i % 10);
+        v2[i] = 0.5;
+        expected += v1[i] * v2[i];
+    }
+    EXPECT_EQ(v1 * v2, expected);
+}
+
+TEST(TDynamicVector, chained_expression_is_evaluated_correctly)
+{
+    TDynamicVector<int> a(5), b(5), d(5);
+    for (size_t i = 0; i < 5; i++) {
+        a[i] = int(i);
+        b[i] = int(i * 10);
+        d[i] = 1;
+    }
+    TDynamicVector<int> c = a + b * 2 - d;
+    for (size_t i = 0; i < 5; i++)
+        EXPECT_EQ(c[i], int(i) + int(i * 10) * 2 - 1);
+}
+
+TEST(TDynamicVector, assigning_expression_reuses_destination_buffer)
+{
+    TDynamicVector<double> a(100), b(100), c(100);
+    a[3] = 1.5;
+    b[3] = 2.0;
+    const double* before = &c[0];
+    c = a + b * 2.0 - a;
+    EXPECT_EQ(&c[0], before); // результат записан на место, без временных векторов
+    EXPECT_EQ(c[3], 4.0);
+}
+
+TEST(TDynamicVector, can_assign_expression_with_itself_as_operand)
+{
+    TDynamicVector<int> v(3);
+    v[0] = 1;
+    v[1] = 2;
+    v[2] = 3;
+    v = v * 2 + v;
+    EXPECT_EQ(v[0], 3);
+    EXPECT_EQ(v[2], 9);
+}
+
+TEST(TDynamicVector, assigning_expression_changes_vector_size)
+{
+    TDynamicVector<int> a(4), b(4), c(2);
+    a[3] = 5;
+    c = a + b;
+    EXPECT_EQ(c.size(), 4);
+    EXPECT_EQ(c[3], 5);
+}
+
+TEST(TDynamicVector, expression_element_access_is_checked)
+{
+    TDynamicVector<int> a(4), b(4);
+    a[1] = 2;
+    auto e = a + b;
+    EXPECT_EQ(e[1], 2);
+    ASSERT_ANY_THROW(e[4]);
+}
+
+TEST(TDynamicVector, can_compute_dot_product_of_expressions)
+{
+    TDynamicVector<int> a(3), b(3);
+    a[0] = 1;
+    a[1] = 2;
+    b[0] = 3;
+    b[1] = 4;
+    EXPECT_EQ((a + b) * (a - b), (1 + 3) * (1 - 3) + (2 + 4) * (2 - 4));
+}
+
+TEST(TDynamicVector, compound_operators_work_in_place)
+{
+    TDynamicVector<int> acc(4), delta(4);
+    for (size_t i = 0; i < 4; i++) {
+        acc[i] = int(i);
+        delta[i] = 10;
+    }
+    const int* before = &acc[0];
+    acc += delta;
+    acc -= delta * 2;
+    acc += 3;
+    acc -= 1;
+    acc *= 2;
+    EXPECT_EQ(&acc[0], before); // буфер не перевыделялся
+    for (size_t i = 0; i < 4; i++)
+        EXPECT_EQ(acc[i], (int(i) - 10 + 2) * 2);
+}
+
+TEST(TDynamicVector, cant_add_assign_vectors_with_not_equal_size)
+{
+    TDynamicVector<int> v1(4), v2(3);
+    ASSERT_ANY_THROW(v1 += v2);
+    ASSERT_ANY_THROW(v1 -= v2);
+    ASSERT_ANY_THROW(v1.axpy(2, v2));
+}
+
+TEST(TDynamicVector, can_do_axpy_update)
+{
+    TDynamicVector<double> y(37), x(37);
+    for (size_t i = 0; i < 37; i++) {
+        y[i] = double(i);
+        x[i] = 1.0;
+    }
+    y.axpy(0.5, x).axpy(2.0, x + x);
+    for (size_t i = 0; i < 37; i++)
+        EXPECT_EQ(y[i], double(i) + 0.5 + 4.0);
+}
+
+TEST(TDynamicVector, expression_assignment_does_not_allocate)
+{
+    TDynamicVector<int> a(8), b(8), c(8);
+    size_t before = allocationCount();
+    c = a + b * 2 - a;
+    c += a;
+    c.axpy(3, b);
+    EXPECT_EQ(allocationCount(), before);
+}
+
+TEST(TDynamicVector, operators_reuse_buffer_of_temporary_operand)
+{
+    TDynamicVector<int> a(6), b(6);
+    for (size_t i = 0; i < 6; i++) {
+        a[i] = int(i);
+        b[i] = 2;
+    }
+    size_t before = allocationCount();
+    TDynamicVector<int> r = ((TDynamicVector<int>(a) + b) * 3 - b) + 1;
+    EXPECT_EQ(allocationCount() - before, 1); // только копия a
+    for (size_t i = 0; i < 6; i++)
+        EXPECT_EQ(r[i], (int(i) + 2) * 3 - 2 + 1);
+}
+
+TEST(TDynamicVector, can_subtract_temporary_from_vector)
+{
+    TDynamicVector<int> a(3), b(3);
+    a[0] = 10;
+    b[0] = 4;
+    TDynamicVector<int> r = a - TDynamicVector<int>(b);
+    EXPECT_EQ(r[0], 6);
+}
+
+TEST(TDynamicVector, unchecked_access_and_data_refer_to_same_elements)
+{
+    TDynamicVector<int> v(5);
+    for (size_t i = 0; i < v.size(); i++)
+        v(i) = int(i) * 2;
+    EXPECT_EQ(v[3], 6);
+    EXPECT_EQ(v.data()[4], 8);
+    EXPECT_EQ(&v(0), v.data());
+    EXPECT_EQ(v.end() - v.begin(), 5);
+}
+
+TEST(TDynamicVector, at_keeps_bounds_check)
+{
+    TDynamicVector<int> v(5);
+    ASSERT_NO_THROW(v.at(4));
+    ASSERT_ANY_THROW(v.at(5));
+}
+
+// Распределитель с состоянием: считает свои выделения
+template<typename T>
+struct TCountingAllocator
+{
+    typedef T value_type;
+    size_t* counter;
+
+    explicit TCountingAllocator(size_t* c) noexcept : counter(c) {}
+    template<typename U> TCountingAllocator(const TCountingAllocator<U>& a) noexcept : counter(a.counter) {}
+
+    T* allocate(size_t n)
+    {
+        ++*counter;
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) noexcept { std::allocator<T>().deallocate(p, n); }
+
+    bool operator==(const TCountingAllocator& a) const noexcept { return counter == a.counter; }
+    bool operator!=(const TCountingAllocator& a) const noexcept { return counter != a.counter; }
+};
+
+TEST(TDynamicVector, default_allocator_aligns_buffer)
+{
+    TDynamicVector<char> v(3);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(&v[0]) % MEM_ALIGNMENT, 0);
+    TDynamicVector<double, TAlignedAllocator<double, 256>> w(3);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(&w[0]) % 256, 0);
+}
+
+TEST(TDynamicVector, can_use_custom_allocator)
+{
+    size_t count = 0;
+    TCountingAllocator<int> alloc(&count);
+    TDynamicVector<int, TCountingAllocator<int>> a(10, alloc), b(10, alloc);
+    EXPECT_EQ(count, 2);
+    for (size_t i = 0; i < 10; i++) {
+        a[i] = int(i);
+        b[i] = 1;
+    }
+    TDynamicVector<int, TCountingAllocator<int>> c(a);
+    EXPECT_EQ(count, 3);
+    EXPECT_EQ(c.get_allocator(), alloc);
+    c = a + b;
+    EXPECT_EQ(c[9], 10);
+    EXPECT_EQ(a * b, 45);
+    TDynamicVector<int> d = a - b; // смешение распределителей в выражениях
+    EXPECT_EQ(d[0], -1);
+}
+
+TEST(TDynamicVector, can_create_vector_filled_with_value)
+{
+    TDynamicVector<double> v(7, 2.5);
+    for (size_t i = 0; i < v.size(); i++)
+        EXPECT_EQ(v[i], 2.5);
+    ASSERT_ANY_THROW(TDynamicVector<double>(0, 1.0));
+}
+
+TEST(TDynamicVector, can_create_uninitialized_vector)
+{
+    TDynamicVector<int> v(9, uninitialized);
+    EXPECT_EQ(v.size(), 9);
+    for (size_t i = 0; i < v.size(); i++)
+        v[i] = int(i);
+    EXPECT_EQ(v[8], 8);
+    ASSERT_ANY_THROW(TDynamicVector<int>(MAX_VECTOR_SIZE + 1, uninitialized));
+}
+
+TEST(TDynamicVector, uninitialized_vector_of_class_type_is_default_constructed)
+{
+    TDynamicVector<std::string> v(3, uninitialized);
+    EXPECT_TRUE(v[2].empty());
+}
+
+TEST(TDynamicVector, assignment_of_equal_size_does_not_allocate)
+{
+    TDynamicVector<int> a(50, 4), b(50);
+    size_t before = allocationCount();
+    b = a;
+    EXPECT_EQ(allocationCount(), before);
+    EXPECT_EQ(b, a);
+}
+
+TEST(TDynamicVector, text_output_matches_stream_formatting)
+{
+    TDynamicVector<double> v(4);
+    v[0] = 1.5; v[1] = 2.0; v[2] = 1.0 / 3.0; v[3] = -1e20;
+    stringstream s;
+    s << v;
+    EXPECT_EQ(s.str(), "1.5 2 0.333333 -1e+20 ");
+    stringstream f;
+    f << fixed << setprecision(2) << v;
+    EXPECT_EQ(f.str(), "1.50 2.00 0.33 -100000000000000000000.00 ");
+    stringstream w;
+    w << setw(4) << TDynamicVector<int>(2, 7);
+    EXPECT_EQ(w.str(), "   7 7 ");
+}
+
+TEST(TDynamicVector, text_round_trip_is_exact_with_full_precision)
+{
+    const size_t n = 1000000; // больше одного куска чтения
+    TDynamicVector<double> v(n), u(n);
+    for (size_t i = 0; i < n; i++)
+        v[i] = std::sin(double(i)) * 1e3;
+    stringstream s;
+    s << setprecision(17) << v;
+    s >> u;
+    EXPECT_FALSE(s.fail());
+    EXPECT_EQ(u, v);
+}
+
+TEST(TDynamicVector, text_input_accepts_csv_and_leaves_rest_of_stream)
+{
+    stringstream s("1,+2;  -3\n4.5e1\t5, 6 7 tail");
+    TDynamicVector<double> a(3), b(3);
+    s >> a >> b;
+    EXPECT_EQ(a[0], 1.0);
+    EXPECT_EQ(a[1], 2.0);
+    EXPECT_EQ(a[2], -3.0);
+    EXPECT_EQ(b[0], 45.0);
+    EXPECT_EQ(b[1], 5.0);
+    EXPECT_EQ(b[2], 6.0);
+    int rest;
+    string word;
+    s >> rest >> word;
+    EXPECT_EQ(rest, 7);
+    EXPECT_EQ(word, "tail");
+}
+
+TEST(TDynamicVector, text_input_fails_on_malformed_or_short_data)
+{
+    TDynamicVector<int> v(3);
+    stringstream bad("1 2x 3");
+    bad >> v;
+    EXPECT_TRUE(bad.fail());
+    stringstream shortData("1 2");
+    shortData >> v;
+    EXPECT_TRUE(shortData.fail());
+}
+
+TEST(TDynamicVector, text_codec_constants_can_be_bound_to_references)
+{
+    // Без определения констант такой код не компонуется в отладочной сборке
+    const size_t& chunk = utmatrix_detail::TTextCodec<int>::chunkSize;
+    const size_t& part = utmatrix_detail::TTextCodec<double>::minPartSize;
+    EXPECT_GT(chunk, size_t(0));
+    EXPECT_LE(part, utmatrix_detail::TTextCodec<double>::chunkSize);
+    TDynamicVector<int> v(100000, 7), u(100000); // больше первого куска чтения
+    stringstream s;
+    s << v;
+    s >> u;
+    EXPECT_EQ(u, v);
+}
+
+TEST(TDynamicVector, fixed_text_output_fits_largest_long_double)
+{
+    TDynamicVector<long double> v(3);
+    v[0] = std::numeric_limits<long double>::max();
+    v[1] = -std::numeric_limits<long double>::max();
+    v[2] = 0.5L;
+    stringstream s, expected;
+    s << fixed << setprecision(3) << v;
+    expected << fixed << setprecision(3);
+    for (size_t i = 0; i < v.size(); i++)
+        expected << v[i] << ' ';
+    EXPECT_EQ(s.str(), expected.str());
+}
+
+TEST(TDynamicVector, can_subtract_most_negative_integer_scalar)
+{
+    // a - INT_MIN нельзя считать как a + (0 - INT_MIN): отрицание переполняется
+    const int lowest = std::numeric_limits<int>::min();
+    TDynamicVector<int> v(37);
+    for (size_t i = 0; i < v.size(); i++)
+        v[i] = -1 - int(i);
+    TDynamicVector<int> res = v - lowest;
+    for (size_t i = 0; i < v.size(); i++)
+        EXPECT_EQ(res[i], -1 - int(i) - lowest);
+}
+
+// Ограничения размеров восстанавливаются по выходе из теста
+struct TVectorLimitsGuard
+{
+    TSizeLimits saved = sizeLimits();
+    ~TVectorLimitsGuard() { sizeLimits() = saved; }
+};
+
+TEST(TDynamicVector, can_create_vector_beyond_default_limit_after_raising_it)
+{
+    TVectorLimitsGuard guard;
+    sizeLimits().maxVectorSize = MAX_VECTOR_SIZE * 2;
+    TDynamicVector<char, TFileAllocator<char>> v(MAX_VECTOR_SIZE + 1, uninitialized);
+    ASSERT_EQ(v.size(), MAX_VECTOR_SIZE + 1);
+    v[0] = 1;
+    v[MAX_VECTOR_SIZE] = 2;
+    EXPECT_EQ(v[0], 1);
+    EXPECT_EQ(v[MAX_VECTOR_SIZE / 2], 0);
+    EXPECT_EQ(v[MAX_VECTOR_SIZE], 2);
+}
+
+TEST(TDynamicVector, throws_when_size_in_bytes_overflows)
+{
+    TVectorLimitsGuard guard;
+    sizeLimits().maxVectorSize = std::numeric_limits<size_t>::max();
+    ASSERT_ANY_THROW(TDynamicVector<double> v(std::numeric_limits<size_t>::max() / 4));
+    ASSERT_ANY_THROW(TDynamicVector<double> v(std::numeric_limits<size_t>::max() / 4, uninitialized));
+}
+
+TEST(TDynamicVector, file_backed_vector_supports_arithmetic)
+{
+    TDynamicVector<double, TFileAllocator<double>> a(1000), b(1000);
+    for (size_t i = 0; i < 1000; i++) {
+        a[i] = double(i);
+        b[i] = 2.0;
+    }
+    TDynamicVector<double, TFileAllocator<double>> c = a + b * 3.0;
+    EXPECT_EQ(c[10], 16.0);
+    EXPECT_EQ(a * b, 999000.0);
+}